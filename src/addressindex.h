@@ -8,6 +8,10 @@
 
 #include <uint256.h>
 #include <consensus/amount.h>
+#include <crypto/siphash.h>
+#include <random.h>
+
+#include <utility>
 
 struct CMempoolAddressDelta
 {
@@ -56,26 +60,17 @@ struct CMempoolAddressDeltaKey
     }
 };
 
-struct CMempoolAddressDeltaKeyCompare
+/** Salted hasher for the mempool deltas of an address, keyed by type and hash */
+class CMempoolAddressHasher
 {
-    bool operator()(const CMempoolAddressDeltaKey& a, const CMempoolAddressDeltaKey& b) const {
-        if (a.type == b.type) {
-            if (a.addressBytes == b.addressBytes) {
-                if (a.txhash == b.txhash) {
-                    if (a.index == b.index) {
-                        return a.spending < b.spending;
-                    } else {
-                        return a.index < b.index;
-                    }
-                } else {
-                    return a.txhash < b.txhash;
-                }
-            } else {
-                return a.addressBytes < b.addressBytes;
-            }
-        } else {
-            return a.type < b.type;
-        }
+private:
+    const uint64_t k0, k1;
+
+public:
+    CMempoolAddressHasher() : k0{GetRand<uint64_t>()}, k1{GetRand<uint64_t>()} {}
+
+    size_t operator()(const std::pair<int, uint256>& address) const noexcept {
+        return SipHashUint256Extra(k0, k1, address.second, address.first);
     }
 };
 
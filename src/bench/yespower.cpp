@@ -0,0 +1,116 @@
+// Copyright (c) 2023 The Sugarchain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/data.h>
+
+#include <chainparams.h>
+#include <crypto/yespower.h>
+#include <node/blockstorage.h>
+#include <pow.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <thread>
+#include <vector>
+
+// Yespower dominates the validation cost of this chain. These benchmarks
+// cover each place the PoW hash is computed or looked up.
+
+//! Headers per full headers message (MAX_HEADERS_RESULTS in net_processing.cpp)
+static constexpr size_t HEADERS_BATCH_SIZE{2000};
+
+static CBlock ReadBenchBlock()
+{
+    CDataStream stream(benchmark::data::block6513497, SER_NETWORK, PROTOCOL_VERSION);
+    CBlock block;
+    stream >> block;
+    return block;
+}
+
+static void YespowerPoWHash(benchmark::Bench& bench)
+{
+    const CBlockHeaderUncached header{ReadBenchBlock().GetBlockHeader()};
+    bench.unit("header").run([&] {
+        uint256 hash{header.GetPoWHash()};
+        ankerl::nanobench::doNotOptimizeAway(hash);
+    });
+}
+
+static void YespowerPoWHashCached(benchmark::Bench& bench)
+{
+    // A cache hit still pays a SHA256d of the header and a shard lock
+    const CBlockHeader header{ReadBenchBlock().GetBlockHeader()};
+    header.GetPoWHash_cached();
+    bench.unit("header").run([&] {
+        uint256 hash{header.GetPoWHash_cached()};
+        ankerl::nanobench::doNotOptimizeAway(hash);
+    });
+}
+
+static void YespowerHeaderBatchVerify(benchmark::Bench& bench)
+{
+    // A full headers message, verified on all cores like during header sync.
+    // The headers need distinct hashes to miss the PoW hash cache, so give them
+    // the easiest possible target: all but about 1 in 65536 of them are valid.
+    Consensus::Params consensus;
+    consensus.powLimit = uint256S(std::string(64, 'f'));
+    CBlockHeader header{ReadBenchBlock().GetBlockHeader()};
+    header.nBits = 0x2100ffff;
+    StartPoWCheckWorkerThreads(std::max(GetNumCores() - 1, 0));
+
+    bench.batch(HEADERS_BATCH_SIZE).unit("header").run([&] {
+        std::vector<CBlockHeader> headers(HEADERS_BATCH_SIZE, header);
+        for (CBlockHeader& h : headers) {
+            h.nNonce = header.nNonce++;
+        }
+        bool valid{HasValidProofOfWork(headers, consensus)};
+        ankerl::nanobench::doNotOptimizeAway(valid);
+    });
+    StopPoWCheckWorkerThreads();
+}
+
+static void ReadBlockFromDiskBench(benchmark::Bench& bench, bool check_pow)
+{
+    const auto testing_setup{MakeNoLogFileContext<const TestingSetup>(CBaseChainParams::MAIN)};
+    const CChainParams& params{testing_setup->m_node.chainman->GetParams()};
+    const CBlock block{ReadBenchBlock()};
+    CChain chain;
+    const FlatFilePos pos{testing_setup->m_node.chainman->m_blockman.SaveBlockToDisk(block, 0, chain, params, nullptr)};
+
+    bench.unit("block").run([&] {
+        // Measure the Yespower hash, not a PoW hash cache hit
+        if (check_pow) ClearPoWHashCache();
+        CBlock read;
+        bool ok{node::ReadBlockFromDisk(read, pos, params.GetConsensus(), check_pow)};
+        assert(ok);
+    });
+}
+
+static void ReadBlockFromDiskPoWCheck(benchmark::Bench& bench) { ReadBlockFromDiskBench(bench, /*check_pow=*/true); }
+static void ReadBlockFromDiskNoPoWCheck(benchmark::Bench& bench) { ReadBlockFromDiskBench(bench, /*check_pow=*/false); }
+
+static void YespowerFirstHashOnNewThread(benchmark::Bench& bench)
+{
+    // A new thread borrows a Yespower region that is already faulted in from
+    // the region pool; compare with YespowerPoWHash for the cost of the hash alone.
+    const CBlockHeaderUncached header{ReadBenchBlock().GetBlockHeader()};
+    InitPoWHashRegions(1, /*hugepages=*/false);
+    bench.unit("thread").run([&] {
+        uint256 hash;
+        std::thread thread{[&] { hash = header.GetPoWHash(); }};
+        thread.join();
+        ankerl::nanobench::doNotOptimizeAway(hash);
+    });
+    YespowerFreeRegions();
+}
+
+BENCHMARK(YespowerPoWHash, benchmark::PriorityLevel::HIGH);
+BENCHMARK(YespowerPoWHashCached, benchmark::PriorityLevel::HIGH);
+BENCHMARK(YespowerHeaderBatchVerify, benchmark::PriorityLevel::LOW);
+BENCHMARK(ReadBlockFromDiskPoWCheck, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ReadBlockFromDiskNoPoWCheck, benchmark::PriorityLevel::HIGH);
+BENCHMARK(YespowerFirstHashOnNewThread, benchmark::PriorityLevel::HIGH);
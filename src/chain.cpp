@@ -79,8 +79,7 @@ CBlockIndex* CChain::FindEarliestAtLeast(int64_t nTime, int height) const
 /** Turn the lowest '1' bit in the binary representation of a number into a '0'. */
 int static inline InvertLowestOne(int n) { return n & (n - 1); }
 
-/** Compute what height to jump back to with the CBlockIndex::pskip pointer. */
-int static inline GetSkipHeight(int height) {
+int GetSkipHeight(int height) {
     if (height < 2)
         return 0;
 
@@ -143,6 +142,14 @@ arith_uint256 GetBlockProof(const CBlockIndex& block)
     return (~bnTarget / (bnTarget + 1)) + 1;
 }
 
+/* SugarShield */
+arith_uint256 GetBlockTarget(const CBlockIndex& block)
+{
+    arith_uint256 bnTarget;
+    bnTarget.SetCompact(block.nBits);
+    return bnTarget;
+}
+
 int64_t GetBlockProofEquivalentTime(const CBlockIndex& to, const CBlockIndex& from, const CBlockIndex& tip, const Consensus::Params& params)
 {
     arith_uint256 r;
@@ -103,13 +103,16 @@ enum BlockStatus : uint32_t {
     BLOCK_VALID_RESERVED     =    1,
 
     //! All parent headers found, difficulty matches, timestamp >= median previous, checkpoint. Implies all parents
-    //! are also at least TREE.
+    //! are also at least TREE. Does not imply the header's proof of work was checked: headers accepted during
+    //! initial block download skip CheckBlockHeader.
     BLOCK_VALID_TREE         =    2,
 
     /**
      * Only first tx is coinbase, 2 <= coinbase input script length <= 100, transactions valid, no duplicate txids,
      * sigops, size, merkle root. Implies all parents are at least TREE but not necessarily TRANSACTIONS. When all
-     * parent blocks also have TRANSACTIONS, CBlockIndex::nChainTx will be set.
+     * parent blocks also have TRANSACTIONS, CBlockIndex::nChainTx will be set. Also implies the block passed
+     * CheckBlock, including the header's proof of work, which lets block reads through the index skip recomputing
+     * the Yespower hash.
      */
     BLOCK_VALID_TRANSACTIONS =    3,
 
@@ -175,6 +178,11 @@ public:
     //! (memory only) Total amount of work (expected number of hashes) in the chain up to and including this block
     arith_uint256 nChainWork{};
 
+    /* SugarShield */
+    //! (memory only) Sum of the targets of all blocks in the chain up to and including this block, modulo 2**256.
+    //! The difference between two of these is the target sum of the blocks in between.
+    arith_uint256 nChainTargetSum{};
+
     //! Number of transactions in this block.
     //! Note: in a potential headers-first mode, this number cannot be relied upon
     //! Note: this value is faked during UTXO snapshot load to ensure that
@@ -207,24 +215,12 @@ public:
     uint32_t nBits{0};
     uint32_t nNonce{0};
 
-    /* YespowerSugar */
-    //! (currently memory only, but don't have to be)
-    bool cache_init{false};
-    uint256 cache_block_hash{};
-    uint256 cache_PoW_hash{};
-
     //! (memory only) Sequential id assigned to distinguish order in which blocks are received.
     int32_t nSequenceId{0};
 
     //! (memory only) Maximum nTime in the chain up to and including this block.
     unsigned int nTimeMax{0};
 
-    /* YespowerSugar */
-    void SetNullCacheInit()
-    {
-        cache_init = false;
-    }
-
     explicit CBlockIndex(const CBlockHeader& block)
         : nVersion{block.nVersion},
           hashMerkleRoot{block.hashMerkleRoot},
@@ -232,11 +228,6 @@ public:
           nBits{block.nBits},
           nNonce{block.nNonce}
     {
-        /* YespowerSugar */
-        SetNullCacheInit();
-        cache_init = block.cache_init;
-        cache_block_hash = block.cache_block_hash;
-        cache_PoW_hash = block.cache_PoW_hash;
     }
 
     FlatFilePos GetBlockPos() const EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
@@ -271,12 +262,6 @@ public:
         block.nTime = nTime;
         block.nBits = nBits;
         block.nNonce = nNonce;
-
-        /* YespowerSugar */
-        block.cache_init = cache_init;
-        block.cache_block_hash = cache_block_hash;
-        block.cache_PoW_hash = cache_PoW_hash;
-
         return block;
     }
 
@@ -401,6 +386,10 @@ protected:
 };
 
 arith_uint256 GetBlockProof(const CBlockIndex& block);
+/** The target encoded by a block's nBits, as summed by SugarShield (no negative/overflow checks). */
+arith_uint256 GetBlockTarget(const CBlockIndex& block); /* SugarShield */
+/** Compute what height to jump back to with the CBlockIndex::pskip pointer. */
+int GetSkipHeight(int height);
 /** Return the time it would take to redo the work difference between from and to, assuming the current hashrate corresponds to the difficulty at tip, in seconds. */
 int64_t GetBlockProofEquivalentTime(const CBlockIndex& to, const CBlockIndex& from, const CBlockIndex& tip, const Consensus::Params&);
 /** Find the forking point between two chain tips. */
@@ -120,6 +120,12 @@ struct Params {
     uint256 nMinimumChainWork;
     /** By default assume that the signatures in ancestors of this block are valid */
     uint256 defaultAssumeValid;
+    /* YespowerSugar */
+    /** Height and hash of a header that commits (through hashPrevBlock) to the header
+     *  chain below it. Headers up to it are matched against it by hash instead of
+     *  having their proof of work checked during initial headers sync. */
+    int nAssumedPoWHeight;
+    uint256 hashAssumedPoW;
 
     /**
      * If true, witness commitments contain a payload equal to a Sugarchain Script solution
@@ -0,0 +1,181 @@
+// Copyright (c) 2023 The Sugarchain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/yespower.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+#ifdef MAP_HUGETLB
+//! Size of the explicit huge pages requested with MAP_HUGETLB
+constexpr size_t HUGEPAGE_SIZE{2 << 20};
+
+/** Map a region of at least size bytes on explicit huge pages. The region is
+ *  laid out like yespower's own mmap allocations, so yespower_free_local()
+ *  unmaps it.
+ */
+bool AllocHugepageRegion(yespower_local_t& local, size_t size)
+{
+    // munmap() of a MAP_HUGETLB mapping fails unless the size is a multiple of the huge page size
+    const size_t mapped_size{(size + HUGEPAGE_SIZE - 1) & ~(HUGEPAGE_SIZE - 1)};
+    void* base = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE | MAP_HUGETLB, -1, 0);
+    if (base == MAP_FAILED) return false;
+    local.base = local.aligned = base;
+    local.base_size = local.aligned_size = mapped_size;
+    return true;
+}
+#endif
+
+/** Hash once in a region to allocate it and fault in all of its pages. */
+bool FaultInRegion(yespower_local_t& local, const yespower_params_t& params)
+{
+    const unsigned char input[80]{};
+    yespower_binary_t out;
+    return yespower(&local, input, sizeof(input), &params, &out) == 0;
+}
+
+/** Process-wide pool of Yespower regions. A hash borrows a region for its
+ *  duration instead of each thread keeping its own, so a thread hashing for
+ *  the first time gets a region that is already faulted in, and the memory
+ *  in use is bounded by the pool size rather than by the number of threads.
+ */
+class RegionPool
+{
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::vector<yespower_local_t> m_idle;
+    //! Regions in existence, idle or borrowed
+    size_t m_count{0};
+    //! Upper bound on m_count, 0 for none
+    size_t m_max{0};
+
+public:
+    yespower_local_t Borrow()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, [&] { return !m_idle.empty() || m_max == 0 || m_count < m_max; });
+        if (!m_idle.empty()) {
+            const yespower_local_t local{m_idle.back()};
+            m_idle.pop_back();
+            return local;
+        }
+        // yespower() allocates the region on first use
+        ++m_count;
+        yespower_local_t local;
+        yespower_init_local(&local);
+        return local;
+    }
+
+    void Return(yespower_local_t local)
+    {
+        bool keep;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // Drop the region if the pool was shrunk while it was borrowed
+            keep = m_max == 0 || m_count <= m_max;
+            if (keep) {
+                m_idle.push_back(local);
+            } else {
+                --m_count;
+            }
+        }
+        if (!keep) yespower_free_local(&local);
+        m_cond.notify_one();
+    }
+
+    size_t Init(size_t count, bool hugepages, const yespower_params_t& params)
+    {
+#ifdef MAP_HUGETLB
+        // Find the region size yespower asks for with these params
+        size_t size{0};
+        if (hugepages) {
+            yespower_local_t probe;
+            yespower_init_local(&probe);
+            if (FaultInRegion(probe, params)) size = probe.aligned_size;
+            yespower_free_local(&probe);
+        }
+#endif
+
+        std::vector<yespower_local_t> regions;
+        size_t hugepage_regions{0};
+        for (size_t i = 0; i < count; ++i) {
+            yespower_local_t local;
+            yespower_init_local(&local);
+#ifdef MAP_HUGETLB
+            if (size > 0 && AllocHugepageRegion(local, size)) ++hugepage_regions;
+#endif
+            // A region that fails to allocate now is retried on first use
+            if (!FaultInRegion(local, params)) yespower_free_local(&local);
+            regions.push_back(local);
+        }
+
+        Free();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_idle.insert(m_idle.end(), regions.begin(), regions.end());
+        m_count += count;
+        m_max = count;
+        return hugepage_regions;
+    }
+
+    void Free()
+    {
+        std::vector<yespower_local_t> idle;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            idle.swap(m_idle);
+            m_count -= idle.size();
+            m_max = 0;
+        }
+        for (yespower_local_t& local : idle) {
+            yespower_free_local(&local);
+        }
+        m_cond.notify_all();
+    }
+};
+
+RegionPool& GetRegionPool()
+{
+    static RegionPool pool;
+    return pool;
+}
+
+/** A region borrowed from the pool for the lifetime of this object. */
+class BorrowedRegion
+{
+    yespower_local_t m_local;
+
+public:
+    BorrowedRegion() : m_local{GetRegionPool().Borrow()} {}
+    ~BorrowedRegion() { GetRegionPool().Return(m_local); }
+    BorrowedRegion(const BorrowedRegion&) = delete;
+    BorrowedRegion& operator=(const BorrowedRegion&) = delete;
+
+    bool Hash(const unsigned char* input, size_t len, const yespower_params_t& params, unsigned char output[32])
+    {
+        return yespower(&m_local, input, len, &params, reinterpret_cast<yespower_binary_t*>(output)) == 0;
+    }
+};
+} // namespace
+
+bool YespowerHash(const unsigned char* input, size_t len, const yespower_params_t& params, unsigned char output[32])
+{
+    return BorrowedRegion{}.Hash(input, len, params, output);
+}
+
+size_t YespowerInitRegions(size_t count, bool hugepages, const yespower_params_t& params)
+{
+    return GetRegionPool().Init(count, hugepages, params);
+}
+
+void YespowerFreeRegions()
+{
+    GetRegionPool().Free();
+}
@@ -0,0 +1,34 @@
+// Copyright (c) 2023 The Sugarchain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_YESPOWER_H
+#define BITCOIN_CRYPTO_YESPOWER_H
+
+#include <crypto/yespower-1.0.1/yespower.h>
+
+#include <cstdlib>
+#include <stdint.h>
+
+/** Compute one Yespower hash, using a memory region borrowed from the
+ *  process-wide region pool.
+ *  Returns false if the region could not be allocated.
+ */
+bool YespowerHash(const unsigned char* input, size_t len, const yespower_params_t& params, unsigned char output[32]);
+
+/** Fill the region pool with count regions sized for params, faulted in up
+ *  front, and cap the pool at that many regions: a hash started while all of
+ *  them are borrowed waits for one to be returned. Without this call the pool
+ *  is uncapped and allocates regions on first use.
+ *  hugepages: back the regions with explicit huge pages (MAP_HUGETLB) where
+ *  the OS has them reserved, falling back to normal pages.
+ *  Returns the number of regions that got huge pages.
+ */
+size_t YespowerInitRegions(size_t count, bool hugepages, const yespower_params_t& params);
+
+/** Free the idle regions and lift the cap again. Borrowed regions are freed
+ *  as they are returned.
+ */
+void YespowerFreeRegions();
+
+#endif // BITCOIN_CRYPTO_YESPOWER_H
@@ -8,6 +8,8 @@
 #include <timedata.h>
 #include <util/check.h>
 
+#include <algorithm>
+
 // The two constants below are computed using the simulation script on
 // https://gist.github.com/sipa/016ae445c132cdf65a2791534dfb7ae1
 
@@ -18,12 +20,20 @@ constexpr size_t HEADER_COMMITMENT_PERIOD{584};
 //! received and validated against commitments.
 constexpr size_t REDOWNLOAD_BUFFER_SIZE{13959}; // 13959/584 = ~23.9 commitments
 
+/* YespowerSugar */
+//! Store the full hash of every ASSUMED_POW_HASH_PERIOD-th header below the
+//! assumed-PoW header. Every header leaving the redownload buffer then has a
+//! matched hash above it.
+constexpr int64_t ASSUMED_POW_HASH_PERIOD{2000};
+static_assert(ASSUMED_POW_HASH_PERIOD <= int64_t{REDOWNLOAD_BUFFER_SIZE});
+
 // Our memory analysis assumes 48 bytes for a CompressedHeader (so we should
 // re-calculate parameters if we compress further)
 static_assert(sizeof(CompressedHeader) == 48);
 
 HeadersSyncState::HeadersSyncState(NodeId id, const Consensus::Params& consensus_params,
-        const CBlockIndex* chain_start, const arith_uint256& minimum_required_work) :
+        const CBlockIndex* chain_start, const arith_uint256& minimum_required_work,
+        bool assume_pow) :
     m_commit_offset(GetRand<unsigned>(HEADER_COMMITMENT_PERIOD)),
     m_id(id), m_consensus_params(consensus_params),
     m_chain_start(chain_start),
@@ -42,7 +52,13 @@ HeadersSyncState::HeadersSyncState(NodeId id, const Consensus::Params& consensus
     // could try again, if necessary, to sync a longer chain).
     m_max_commitments = 6*(Ticks<std::chrono::seconds>(GetAdjustedTime() - NodeSeconds{std::chrono::seconds{chain_start->GetMedianTimePast()}}) + MAX_FUTURE_BLOCK_TIME) / HEADER_COMMITMENT_PERIOD;
 
-    LogPrint(BCLog::NET, "Initial headers sync started with peer=%d: height=%i, max_commitments=%i, min_work=%s\n", m_id, m_current_height, m_max_commitments, m_minimum_required_work.ToString());
+    /* YespowerSugar */
+    if (assume_pow && !m_consensus_params.hashAssumedPoW.IsNull() && m_current_height < m_consensus_params.nAssumedPoWHeight) {
+        m_assumed_pow_height = m_consensus_params.nAssumedPoWHeight;
+        m_assumed_pow_hash = m_consensus_params.hashAssumedPoW;
+    }
+
+    LogPrint(BCLog::NET, "Initial headers sync started with peer=%d: height=%i, max_commitments=%i, min_work=%s, assumed_pow_height=%i\n", m_id, m_current_height, m_max_commitments, m_minimum_required_work.ToString(), m_assumed_pow_height);
 }
 
 /** Free any memory in use, and mark this object as no longer usable. This is
@@ -58,6 +74,8 @@ void HeadersSyncState::Finalize()
     m_redownload_buffer_first_prev_hash.SetNull();
     m_process_all_remaining_headers = false;
     m_current_height = 0;
+    m_assumed_pow_reached = false;
+    m_assumed_pow_hashes = {};
 
     m_download_state = State::FINAL;
 }
@@ -136,6 +154,26 @@ HeadersSyncState::ProcessingResult HeadersSyncState::ProcessNextHeaders(const
     return ret;
 }
 
+/* YespowerSugar */
+size_t HeadersSyncState::CountAssumedPoWHeaders(const std::vector<CBlockHeader>& headers) const
+{
+    if (m_assumed_pow_height == 0 || headers.empty()) return 0;
+
+    int64_t next_height{0};
+    if (m_download_state == State::PRESYNC) {
+        if (headers[0].hashPrevBlock != m_last_header_received.GetHash()) return 0;
+        next_height = m_current_height + 1;
+    } else if (m_download_state == State::REDOWNLOAD) {
+        // Only a chain that was seen to pass through the assumed-PoW header
+        // can be matched against it.
+        if (!m_assumed_pow_reached || headers[0].hashPrevBlock != m_redownload_buffer_last_hash) return 0;
+        next_height = m_redownload_buffer_last_height + 1;
+    } else {
+        return 0;
+    }
+    return std::clamp<int64_t>(m_assumed_pow_height - next_height + 1, 0, headers.size());
+}
+
 bool HeadersSyncState::ValidateAndStoreHeadersCommitments(const std::vector<CBlockHeader>& headers)
 {
     // The caller should not give us an empty set of headers.
@@ -205,6 +243,21 @@ bool HeadersSyncState::ValidateAndProcessSingleHeader(const CBlockHeader& curren
         }
     }
 
+    /* YespowerSugar */
+    if (next_height <= m_assumed_pow_height) {
+        const uint256 hash{current.GetHash()};
+        if (next_height == m_assumed_pow_height) {
+            if (hash != m_assumed_pow_hash) {
+                LogPrint(BCLog::NET, "Initial headers sync aborted with peer=%d: assumed-PoW header mismatch at height=%i (presync phase)\n", m_id, next_height);
+                return false;
+            }
+            m_assumed_pow_reached = true;
+        }
+        if (next_height % ASSUMED_POW_HASH_PERIOD == 0 || next_height == m_assumed_pow_height) {
+            m_assumed_pow_hashes.push_back(hash);
+        }
+    }
+
     m_current_chain_work += GetBlockProof(CBlockIndex(current));
     m_last_header_received = current;
     m_current_height = next_height;
@@ -240,10 +293,25 @@ bool HeadersSyncState::ValidateAndStoreRedownloadedHeader(const CBlockHeader& he
         return false;
     }
 
+    /* YespowerSugar */
+    // Headers up to the assumed-PoW header had no proof of work checked, so
+    // match them against the hashes stored during PRESYNC.
+    if (m_assumed_pow_reached && next_height <= m_assumed_pow_height &&
+            (next_height % ASSUMED_POW_HASH_PERIOD == 0 || next_height == m_assumed_pow_height)) {
+        if (m_assumed_pow_hashes.empty() || header.GetHash() != m_assumed_pow_hashes.front()) {
+            LogPrint(BCLog::NET, "Initial headers sync aborted with peer=%d: assumed-PoW hash mismatch at height=%i (redownload phase)\n", m_id, next_height);
+            return false;
+        }
+        m_assumed_pow_hashes.pop_front();
+    }
+
     // Track work on the redownloaded chain
     m_redownload_chain_work += GetBlockProof(CBlockIndex(header));
 
-    if (m_redownload_chain_work >= m_minimum_required_work) {
+    // Claimed work below the assumed-PoW header is unverified until that
+    // header is matched, so don't release everything before then.
+    if (m_redownload_chain_work >= m_minimum_required_work &&
+            (!m_assumed_pow_reached || next_height >= m_assumed_pow_height)) { /* YespowerSugar */
         m_process_all_remaining_headers = true;
     }
 
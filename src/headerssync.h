@@ -134,9 +134,12 @@ public:
      * consensus_params: parameters needed for difficulty adjustment validation
      * chain_start: best known fork point that the peer's headers branch from
      * minimum_required_work: amount of chain work required to accept the chain
+     * assume_pow: whether to match headers below the consensus params'
+     *             assumed-PoW header by hash instead of by proof of work
      */
     HeadersSyncState(NodeId id, const Consensus::Params& consensus_params,
-            const CBlockIndex* chain_start, const arith_uint256& minimum_required_work);
+            const CBlockIndex* chain_start, const arith_uint256& minimum_required_work,
+            bool assume_pow);
 
     /** Result data structure for ProcessNextHeaders. */
     struct ProcessingResult {
@@ -168,6 +171,14 @@ public:
     ProcessingResult ProcessNextHeaders(const std::vector<CBlockHeader>&
             received_headers, bool full_headers_message);
 
+    /* YespowerSugar */
+    /** Return how many of the leading headers of a batch continuing this sync
+     *  lie at or below the assumed-PoW header. The caller doesn't need to check
+     *  their proof of work: ProcessNextHeaders() matches them against the
+     *  assumed-PoW header by hash instead, and aborts the sync on a mismatch.
+     */
+    size_t CountAssumedPoWHeaders(const std::vector<CBlockHeader>& headers) const;
+
     /** Issue the next GETHEADERS message to our peer.
      *
      * This will return a locator appropriate for the current sync object, to continue the
@@ -271,6 +282,22 @@ private:
      */
     bool m_process_all_remaining_headers{false};
 
+    /* YespowerSugar */
+    /** Height and hash of the assumed-PoW header (height 0 if not in use).
+     *  Headers up to it have no proof of work checked; instead the chain must
+     *  pass through this header, which commits to all of them by hash. */
+    int64_t m_assumed_pow_height{0};
+    uint256 m_assumed_pow_hash;
+
+    /** Whether the PRESYNC chain passed through the assumed-PoW header. Only
+     *  then does REDOWNLOAD skip proof-of-work checks too. */
+    bool m_assumed_pow_reached{false};
+
+    /** Hashes of the PRESYNC chain at every ASSUMED_POW_HASH_PERIOD-th height
+     *  and at the assumed-PoW height. REDOWNLOAD matches them again, so that no
+     *  header is released for acceptance before a header above it was matched. */
+    std::deque<uint256> m_assumed_pow_hashes;
+
     /** Current state of our headers sync. */
     State m_download_state{State::PRESYNC};
 };
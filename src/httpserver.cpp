@@ -541,7 +541,10 @@ HTTPRequest::HTTPRequest(struct evhttp_request* _req, bool _replySent) : req(_re
 
 HTTPRequest::~HTTPRequest()
 {
-    if (!replySent) {
+    if (!replySent && replyStarted) {
+        // The status was sent already, a client sees the reply end early
+        WriteReplyEnd();
+    } else if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL_SERVER_ERROR, "Unhandled request");
@@ -587,6 +590,47 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
     evhttp_add_header(headers, hdr.c_str(), value.c_str());
 }
 
+/** Re-enable reading from the socket. This is the second part of the libevent
+ * workaround in http_request_cb. */
+static void EnableReading(struct evhttp_request* req)
+{
+    if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
+        evhttp_connection* conn = evhttp_request_get_connection(req);
+        if (conn) {
+            bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+            if (bev) {
+                bufferevent_enable(bev, EV_READ | EV_WRITE);
+            }
+        }
+    }
+}
+
+struct HTTPRequest::ReplyBacklog {
+    Mutex mutex;
+    std::condition_variable cond;
+    /** Bytes of chunks not yet handed to the connection */
+    size_t queued GUARDED_BY(mutex){0};
+    /** Bytes in the output buffer of the connection, as last seen */
+    size_t buffered GUARDED_BY(mutex){0};
+    bool closed GUARDED_BY(mutex){false};
+
+    /** Called in the main http thread once the output buffer is written */
+    static void Drained(struct evhttp_connection*, void* arg)
+    {
+        auto backlog{static_cast<ReplyBacklog*>(arg)};
+        WITH_LOCK(backlog->mutex, backlog->buffered = 0);
+        backlog->cond.notify_all();
+    }
+
+    /** Called in the main http thread when the connection is freed */
+    static void Closed(struct evhttp_connection*, void* arg)
+    {
+        auto backlog{static_cast<ReplyBacklog*>(arg)};
+        WITH_LOCK(backlog->mutex, backlog->closed = true);
+        backlog->cond.notify_all();
+    }
+};
+
 /** Closure sent to main thread to request a reply to be sent to
  * a HTTP request.
  * Replies must be sent in the main loop in the main http thread,
@@ -594,7 +638,7 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
  */
 void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
 {
-    assert(!replySent && req);
+    assert(!replySent && !replyStarted && req);
     if (ShutdownRequested()) {
         WriteHeader("Connection", "close");
     }
@@ -605,17 +649,82 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     auto req_copy = req;
     HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
         evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
-        // Re-enable reading from the socket. This is the second part of the libevent
-        // workaround above.
-        if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
-            evhttp_connection* conn = evhttp_request_get_connection(req_copy);
-            if (conn) {
-                bufferevent* bev = evhttp_connection_get_bufferevent(conn);
-                if (bev) {
-                    bufferevent_enable(bev, EV_READ | EV_WRITE);
-                }
-            }
+        EnableReading(req_copy);
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+}
+
+void HTTPRequest::WriteReplyStart(int nStatus)
+{
+    assert(!replySent && !replyStarted && req);
+    if (ShutdownRequested()) {
+        WriteHeader("Connection", "close");
+    }
+    auto req_copy = req;
+    replyBacklog = std::make_shared<ReplyBacklog>();
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus, backlog = replyBacklog]{
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (!conn) {
+            WITH_LOCK(backlog->mutex, backlog->closed = true);
+            backlog->cond.notify_all();
+            return;
+        }
+        evhttp_connection_set_closecb(conn, ReplyBacklog::Closed, backlog.get());
+        evhttp_send_reply_start(req_copy, nStatus, nullptr);
+    });
+    ev->trigger(nullptr);
+    replyStarted = true;
+}
+
+bool HTTPRequest::WriteReplyChunk(std::string chunk)
+{
+    assert(replyStarted && req);
+    if (chunk.empty()) return true;
+    const size_t size{chunk.size()};
+    WITH_LOCK(replyBacklog->mutex, replyBacklog->queued += size);
+    auto req_copy = req;
+    // Events are handled in the order they are triggered, so the chunks are
+    // sent in order as well
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, chunk = std::move(chunk), backlog = replyBacklog]{
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        struct evbuffer* evb = conn ? evbuffer_new() : nullptr;
+        if (evb) {
+            evbuffer_add(evb, chunk.data(), chunk.size());
+            evhttp_send_reply_chunk_with_cb(req_copy, evb, ReplyBacklog::Drained, backlog.get());
+            evbuffer_free(evb);
+        }
+        {
+            LOCK(backlog->mutex);
+            backlog->queued -= chunk.size();
+            backlog->buffered = conn ? evbuffer_get_length(bufferevent_get_output(evhttp_connection_get_bufferevent(conn))) : 0;
+            // The request stays valid until the reply is ended, but does
+            // not send anything once the client went away
+            if (!conn) backlog->closed = true;
+        }
+        backlog->cond.notify_all();
+    });
+    ev->trigger(nullptr);
+
+    WAIT_LOCK(replyBacklog->mutex, lock);
+    replyBacklog->cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(replyBacklog->mutex) {
+        return replyBacklog->closed || replyBacklog->queued + replyBacklog->buffered <= MAX_REPLY_BACKLOG;
+    });
+    return !replyBacklog->closed;
+}
+
+void HTTPRequest::WriteReplyEnd()
+{
+    assert(replyStarted && req);
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, backlog = std::move(replyBacklog)]{
+        // The callbacks must not outlive the backlog
+        if (evhttp_connection* conn = evhttp_request_get_connection(req_copy)) {
+            evhttp_connection_set_closecb(conn, nullptr, nullptr);
         }
+        evhttp_send_reply_end(req_copy);
+        EnableReading(req_copy);
     });
     ev->trigger(nullptr);
     replySent = true;
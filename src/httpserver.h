@@ -6,12 +6,15 @@
 #define BITCOIN_HTTPSERVER_H
 
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=128; // was (16)
 static const int DEFAULT_HTTP_SERVER_TIMEOUT=30;
+/** Most bytes of a chunked reply that wait to be sent before the writer blocks */
+static const size_t MAX_REPLY_BACKLOG = 1 << 20;
 
 struct evhttp_request;
 struct event_base;
@@ -58,6 +61,10 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    bool replyStarted{false};
+    /** Output of a chunked reply that is not sent yet, shared with the main http thread */
+    struct ReplyBacklog;
+    std::shared_ptr<ReplyBacklog> replyBacklog;
 
 public:
     explicit HTTPRequest(struct evhttp_request* req, bool replySent = false);
@@ -124,6 +131,32 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Start a chunked HTTP reply, to send a body that is not built at once.
+     * nStatus is the HTTP status code to send.
+     *
+     * @note Call this instead of WriteReply, followed by any number of calls
+     * to WriteReplyChunk and one to WriteReplyEnd.
+     */
+    void WriteReplyStart(int nStatus);
+
+    /**
+     * Send the next part of the body of a chunked reply.
+     *
+     * Blocks while more than MAX_REPLY_BACKLOG bytes of the reply wait to be
+     * sent, so a slow client holds up the writer instead of filling memory.
+     * Returns false once the client went away, the reply should then be ended.
+     */
+    bool WriteReplyChunk(std::string chunk);
+
+    /**
+     * End a chunked reply.
+     *
+     * @note As this will give the request back to the main thread, do not
+     * call any other HTTPRequest methods after calling this.
+     */
+    void WriteReplyEnd();
 };
 
 /** Get the query parameter value from request uri for a specified key, or std::nullopt if the key
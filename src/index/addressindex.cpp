@@ -0,0 +1,571 @@
+// Copyright (c) 2023 The Sugarchain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/addressindex.h>
+
+#include <chainparams.h>
+#include <crypto/siphash.h>
+#include <logging.h>
+#include <node/blockstorage.h>
+#include <random.h>
+#include <undo.h>
+#include <util/fastrange.h>
+#include <util/system.h>
+#include <util/thread.h>
+#include <validation.h>
+
+#include <functional>
+#include <limits>
+#include <set>
+
+using node::ReadBlockFromDisk;
+using node::UndoReadFromDisk;
+
+constexpr uint8_t DB_ADDRESSINDEX{'A'};
+constexpr uint8_t DB_ADDRESSUNSPENTINDEX{'U'};
+constexpr uint8_t DB_ADDRESSBALANCE{'S'};
+constexpr uint8_t DB_ADDRESSCOINBASE{'C'};
+constexpr uint8_t DB_ADDRESSFILTER{'F'};
+constexpr uint8_t DB_ADDRESSFILTERPAGE{'P'};
+
+/** Version 1 stores the compact encoding of the keys and values */
+constexpr int DB_CURRENT_VERSION{1};
+
+namespace {
+/** Key and size of the stored address filter, whose pages are stored apart */
+struct AddressFilterInfo {
+    uint64_t k0;
+    uint64_t k1;
+    uint32_t n_pages;
+    uint64_t count;
+
+    SERIALIZE_METHODS(AddressFilterInfo, obj) { READWRITE(obj.k0, obj.k1, obj.n_pages, obj.count); }
+};
+} // namespace
+
+std::unique_ptr<AddressIndex> g_address_index;
+
+/** Smallest number of pages of an address filter */
+static constexpr uint32_t MIN_ADDRESS_FILTER_PAGES{16};
+
+static_assert(AddressFilter::BLOCK_SIZE * 8 == 512 && AddressFilter::NUM_HASH_BITS * 9 <= 64,
+              "the bits of an address in its block are taken 9 bits at a time from a 64 bit hash");
+
+AddressFilter::AddressFilter(uint64_t k0, uint64_t k1, uint32_t n_pages)
+    : m_k0{k0}, m_k1{k1}, m_data(size_t{n_pages} * PAGE_SIZE)
+{
+    // a new filter is written in full
+    for (uint32_t page = 0; page < n_pages; ++page) {
+        m_dirty_pages.emplace(page, m_changes);
+    }
+}
+
+uint32_t AddressFilter::PagesFor(uint64_t n_addresses)
+{
+    const uint64_t n_bits{2 * n_addresses * BITS_PER_ADDRESS};
+    return std::max<uint64_t>(MIN_ADDRESS_FILTER_PAGES, (n_bits + PAGE_SIZE * 8 - 1) / (PAGE_SIZE * 8));
+}
+
+/** Offset of the block of an address, and the hash its bits are taken from */
+static std::pair<size_t, uint64_t> HashAddress(uint64_t k0, uint64_t k1, size_t n_blocks, int type, const uint256& hash)
+{
+    // the zero padding of 20 byte hashes is left out
+    const size_t size{AddressHashSize(type)};
+    const uint64_t block_hash{CSipHasher(k0, k1).Write(type).Write(hash.begin(), size).Finalize()};
+    const uint64_t bits_hash{CSipHasher(k1, k0).Write(type).Write(hash.begin(), size).Finalize()};
+    return {FastRange64(block_hash, n_blocks) * AddressFilter::BLOCK_SIZE, bits_hash};
+}
+
+void AddressFilter::Insert(int type, const uint256& hash)
+{
+    const auto [offset, bits_hash] = HashAddress(m_k0, m_k1, m_data.size() / BLOCK_SIZE, type, hash);
+    bool changed{false};
+    for (int i = 0; i < NUM_HASH_BITS; ++i) {
+        const unsigned int bit = (bits_hash >> (9 * i)) & 511;
+        unsigned char& byte{m_data[offset + bit / 8]};
+        const unsigned char mask = 1 << (bit % 8);
+        if (!(byte & mask)) {
+            byte |= mask;
+            changed = true;
+        }
+    }
+    if (changed) {
+        ++m_count;
+        m_dirty_pages[offset / PAGE_SIZE] = ++m_changes;
+    }
+}
+
+bool AddressFilter::MayContain(int type, const uint256& hash) const
+{
+    const auto [offset, bits_hash] = HashAddress(m_k0, m_k1, m_data.size() / BLOCK_SIZE, type, hash);
+    for (int i = 0; i < NUM_HASH_BITS; ++i) {
+        const unsigned int bit = (bits_hash >> (9 * i)) & 511;
+        if (!(m_data[offset + bit / 8] & (1 << (bit % 8)))) return false;
+    }
+    return true;
+}
+
+bool AddressFilter::LoadPage(uint32_t page, Span<const unsigned char> data)
+{
+    if (page >= GetNumPages() || data.size() != PAGE_SIZE) return false;
+    std::copy(data.begin(), data.end(), m_data.begin() + size_t{page} * PAGE_SIZE);
+    return true;
+}
+
+void AddressFilter::ClearDirtyPages(const DirtyPages& written)
+{
+    for (const auto& [page, change] : written) {
+        const auto it{m_dirty_pages.find(page)};
+        if (it != m_dirty_pages.end() && it->second == change) m_dirty_pages.erase(it);
+    }
+}
+
+/** Access to the address index database (indexes/addressindex/) */
+class AddressIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, size_t n_write_cache_size, bool f_memory = false, bool f_wipe = false);
+};
+
+AddressIndex::DB::DB(size_t n_cache_size, size_t n_write_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "addressindex", n_cache_size, f_memory, f_wipe, /*f_obfuscate=*/false, n_write_cache_size)
+{}
+
+AddressIndex::AddressIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, size_t n_write_cache_size, bool f_memory, bool f_wipe)
+    : BaseIndex(std::move(chain), "addressindex"),
+      m_db(OpenVersionedDB(DB_CURRENT_VERSION, f_wipe, [&](bool wipe) { return std::make_unique<AddressIndex::DB>(n_cache_size, n_write_cache_size, f_memory, wipe); }))
+{
+    // An index without a best block has no entries yet. The filter of one
+    // that has entries but no filter is built once the index starts.
+    CBlockLocator locator;
+    if (!LoadFilter() && !(m_db->ReadBestBlock(locator) && !locator.IsNull())) {
+        FastRandomContext rng;
+        LOCK(m_filter_mutex);
+        m_filter = std::make_unique<AddressFilter>(rng.rand64(), rng.rand64(), AddressFilter::PagesFor(0));
+    }
+}
+
+AddressIndex::~AddressIndex()
+{
+    m_filter_interrupt();
+    std::thread builder{WITH_LOCK(m_filter_mutex, return std::move(m_filter_builder))};
+    if (builder.joinable()) builder.join();
+}
+
+bool AddressIndex::CustomInit(const std::optional<interfaces::BlockKey>& block)
+{
+    // lookups read the database until the filter is built
+    LOCK(m_filter_mutex);
+    if (!m_filter) StartFilterRebuild(0);
+    return true;
+}
+
+/** Address type and hash of an output script, false if it is not indexed */
+static bool GetIndexedAddress(const CScript& script, int& type, uint256& hash)
+{
+    std::vector<unsigned char> hash_bytes;
+    if (!ExtractIndexInfo(&script, type, hash_bytes) || type == 0) {
+        return false;
+    }
+    hash = uint256(hash_bytes.data(), hash_bytes.size());
+    return true;
+}
+
+bool AddressIndex::CustomAppend(const interfaces::BlockInfo& block)
+{
+    // Exclude genesis block transactions because outputs are not spendable.
+    if (block.height == 0) return true;
+
+    assert(block.data);
+    assert(block.undo_data);
+    const CBlockUndo* block_undo{block.undo_data};
+    DB::CacheBatch batch;
+    BalanceDeltas deltas;
+    for (size_t i = 0; i < block.data->vtx.size(); ++i) {
+        const CTransaction& tx{*block.data->vtx[i]};
+        const uint256& txhash{tx.GetHash()};
+        std::set<std::pair<int, uint256>> addresses;
+        std::map<std::pair<int, uint256>, CAmount> coinbase_received;
+        int type;
+        uint256 hash;
+
+        // The coinbase tx has no undo data since no former output is spent
+        if (!tx.IsCoinBase()) {
+            const CTxUndo& tx_undo{block_undo->vtxundo.at(i - 1)};
+            for (size_t j = 0; j < tx.vin.size(); ++j) {
+                const CTxOut& prevout{tx_undo.vprevout.at(j).out};
+                if (!GetIndexedAddress(prevout.scriptPubKey, type, hash)) continue;
+
+                // record spending activity
+                batch.Write(std::make_pair(DB_ADDRESSINDEX, CAddressIndexKey(type, hash, block.height, i, txhash, j, true)), prevout.nValue * -1);
+
+                // remove address from unspent index
+                batch.Erase(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressUnspentKey(type, hash, tx.vin[j].prevout.hash, tx.vin[j].prevout.n)));
+
+                deltas[{type, hash}].balance -= prevout.nValue;
+                addresses.emplace(type, hash);
+            }
+        }
+
+        for (size_t k = 0; k < tx.vout.size(); ++k) {
+            const CTxOut& out{tx.vout[k]};
+            if (!GetIndexedAddress(out.scriptPubKey, type, hash)) continue;
+
+            // record receiving activity
+            batch.Write(std::make_pair(DB_ADDRESSINDEX, CAddressIndexKey(type, hash, block.height, i, txhash, k, false)), out.nValue);
+
+            // record unspent output
+            batch.Write(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressUnspentKey(type, hash, txhash, k)), CAddressUnspentValue(out.nValue, out.scriptPubKey, block.height));
+
+            CAddressBalanceValue& delta{deltas[{type, hash}]};
+            delta.balance += out.nValue;
+            delta.received += out.nValue;
+            addresses.emplace(type, hash);
+            if (tx.IsCoinBase()) coinbase_received[{type, hash}] += out.nValue;
+        }
+
+        for (const auto& address : addresses) {
+            ++deltas[address].txCount;
+        }
+        // record coinbase outputs, which are immature for COINBASE_MATURITY blocks
+        for (const auto& [address, amount] : coinbase_received) {
+            batch.Write(std::make_pair(DB_ADDRESSCOINBASE, CAddressCoinbaseKey(address.first, address.second, block.height)), amount);
+        }
+    }
+    WriteBalances(deltas, batch);
+    m_db->WriteCache(batch);
+    // the entries of new addresses become visible to lookups once they are in the filter
+    InsertIntoFilter(deltas);
+    if (m_notify_block_deltas && IsSynced()) m_notify_block_deltas(block.hash, /*connected=*/true, deltas);
+    return true;
+}
+
+bool AddressIndex::CustomCommit(CDBBatch& batch)
+{
+    // the changed pages are stored along with the entries they cover, and
+    // stay dirty until the batch is written
+    LOCK(m_filter_mutex);
+    m_committing_filter = m_filter.get();
+    if (!m_filter) return true;
+    batch.Write(DB_ADDRESSFILTER, AddressFilterInfo{m_filter->GetK0(), m_filter->GetK1(), m_filter->GetNumPages(), m_filter->GetCount()});
+    m_committing_pages = m_filter->GetDirtyPages();
+    for (const auto& [page, change] : m_committing_pages) {
+        const Span<const unsigned char> data{m_filter->GetPage(page)};
+        batch.Write(std::make_pair(DB_ADDRESSFILTERPAGE, page), std::vector<unsigned char>(data.begin(), data.end()));
+    }
+    return true;
+}
+
+void AddressIndex::CustomCommitted()
+{
+    LOCK(m_filter_mutex);
+    // a filter that was replaced meanwhile is stored in full with the next commit
+    if (m_filter && m_filter.get() == m_committing_filter) {
+        m_filter->ClearDirtyPages(m_committing_pages);
+    }
+    m_committing_filter = nullptr;
+    m_committing_pages.clear();
+}
+
+bool AddressIndex::LoadFilter()
+{
+    AddressFilterInfo info;
+    if (!m_db->Read(DB_ADDRESSFILTER, info)) return false;
+
+    auto filter{std::make_unique<AddressFilter>(info.k0, info.k1, info.n_pages)};
+    std::vector<unsigned char> data;
+    for (uint32_t page = 0; page < info.n_pages; ++page) {
+        if (!m_db->Read(std::make_pair(DB_ADDRESSFILTERPAGE, page), data) || !filter->LoadPage(page, data)) {
+            LogPrintf("%s: address filter page %u is missing, rebuilding the filter\n", __func__, page);
+            return false;
+        }
+    }
+    filter->LoadCount(info.count);
+    filter->ClearDirtyPages();
+
+    LOCK(m_filter_mutex);
+    m_filter = std::move(filter);
+    return true;
+}
+
+std::unique_ptr<AddressFilter> AddressIndex::BuildFilter(uint64_t n_addresses, const CThreadInterrupt* interrupt) const
+{
+    // every address with an entry has a balance record
+    const auto scan{[&](const std::function<void(const CAddressIndexIteratorKey&)>& visit) {
+        std::unique_ptr<DB::CachedIterator> pcursor{m_db->NewCachedIterator(DB_ADDRESSBALANCE)};
+        for (pcursor->Seek(DB_ADDRESSBALANCE); pcursor->Valid(); pcursor->Next()) {
+            if (interrupt && *interrupt) return false;
+            std::pair<uint8_t, CAddressIndexIteratorKey> key;
+            if (!pcursor->GetKey(key) || key.first != DB_ADDRESSBALANCE) break;
+            visit(key.second);
+        }
+        return true;
+    }};
+
+    uint64_t n_records{0};
+    if (!scan([&](const CAddressIndexIteratorKey&) { ++n_records; })) return nullptr;
+
+    FastRandomContext rng;
+    auto filter{std::make_unique<AddressFilter>(rng.rand64(), rng.rand64(), AddressFilter::PagesFor(std::max(n_addresses, n_records)))};
+    if (!scan([&](const CAddressIndexIteratorKey& key) { filter->Insert(key.type, key.hashBytes); })) return nullptr;
+    LogPrintf("%s: address filter of %u addresses in %u KiB\n", __func__, n_records, filter->GetNumPages() * AddressFilter::PAGE_SIZE / 1024);
+    return filter;
+}
+
+void AddressIndex::InsertIntoFilter(const BalanceDeltas& deltas)
+{
+    LOCK(m_filter_mutex);
+    for (const auto& [address, delta] : deltas) {
+        if (m_filter) m_filter->Insert(address.first, address.second);
+        if (m_filter_rebuilding) m_filter_pending.insert(address);
+    }
+    // lookups use the full filter, with more false positives, until the larger one is built
+    if (m_filter && m_filter->IsFull()) StartFilterRebuild(m_filter->GetCount());
+}
+
+void AddressIndex::StartFilterRebuild(uint64_t n_addresses)
+{
+    if (m_filter_rebuilding || m_filter_interrupt) return;
+    // the thread of the previous rebuild is done
+    if (m_filter_builder.joinable()) m_filter_builder.join();
+    m_filter_rebuilding = true;
+    m_filter_builder = std::thread(&util::TraceThread, "addrfilter", [this, n_addresses] {
+        // The filter is built from a snapshot taken after m_filter_rebuilding
+        // was set. The addresses of blocks appended since are added to it.
+        FinishFilterRebuild(BuildFilter(n_addresses, &m_filter_interrupt));
+    });
+}
+
+void AddressIndex::FinishFilterRebuild(std::unique_ptr<AddressFilter> filter)
+{
+    LOCK(m_filter_mutex);
+    if (filter) {
+        for (const auto& [type, hash] : m_filter_pending) {
+            filter->Insert(type, hash);
+        }
+        if (m_committing_filter == m_filter.get()) m_committing_filter = nullptr;
+        m_filter = std::move(filter);
+    }
+    m_filter_pending.clear();
+    m_filter_rebuilding = false;
+}
+
+bool AddressIndex::MayHaveAddress(const uint256& address_hash, int type) const
+{
+    LOCK(m_filter_mutex);
+    return !m_filter || m_filter->MayContain(type, address_hash);
+}
+
+void AddressIndex::WriteBalances(const BalanceDeltas& deltas, DB::CacheBatch& batch) const
+{
+    for (const auto& [address, delta] : deltas) {
+        const auto key{std::make_pair(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(address.first, address.second))};
+        // an address without a record has no history yet, and the filter
+        // does not have the addresses of the block being appended
+        CAddressBalanceValue value;
+        if (MayHaveAddress(address.second, address.first)) m_db->ReadCached(key, value);
+        value += delta;
+        if (value.txCount == 0) {
+            batch.Erase(key);
+        } else {
+            batch.Write(key, value);
+        }
+    }
+}
+
+void AddressIndex::ReverseBlock(const CBlock& block, const CBlockUndo& block_undo, int height, DB::CacheBatch& batch, BalanceDeltas& deltas) const
+{
+    // undo transactions in reverse order, so an output created and spent in
+    // the same block ends up erased from the unspent index
+    for (size_t i = block.vtx.size(); i-- > 0;) {
+        const CTransaction& tx{*block.vtx[i]};
+        const uint256& txhash{tx.GetHash()};
+        std::set<std::pair<int, uint256>> addresses;
+        int type;
+        uint256 hash;
+
+        for (size_t k = tx.vout.size(); k-- > 0;) {
+            const CTxOut& out{tx.vout[k]};
+            if (!GetIndexedAddress(out.scriptPubKey, type, hash)) continue;
+
+            // undo receiving activity and unspent index
+            batch.Erase(std::make_pair(DB_ADDRESSINDEX, CAddressIndexKey(type, hash, height, i, txhash, k, false)));
+            batch.Erase(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressUnspentKey(type, hash, txhash, k)));
+            if (tx.IsCoinBase()) batch.Erase(std::make_pair(DB_ADDRESSCOINBASE, CAddressCoinbaseKey(type, hash, height)));
+
+            CAddressBalanceValue& delta{deltas[{type, hash}]};
+            delta.balance -= out.nValue;
+            delta.received -= out.nValue;
+            addresses.emplace(type, hash);
+        }
+
+        if (!tx.IsCoinBase()) {
+            const CTxUndo& tx_undo{block_undo.vtxundo.at(i - 1)};
+            for (size_t j = tx.vin.size(); j-- > 0;) {
+                const Coin& coin{tx_undo.vprevout.at(j)};
+                if (!GetIndexedAddress(coin.out.scriptPubKey, type, hash)) continue;
+
+                // undo spending activity and restore unspent index
+                batch.Erase(std::make_pair(DB_ADDRESSINDEX, CAddressIndexKey(type, hash, height, i, txhash, j, true)));
+                batch.Write(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressUnspentKey(type, hash, tx.vin[j].prevout.hash, tx.vin[j].prevout.n)), CAddressUnspentValue(coin.out.nValue, coin.out.scriptPubKey, coin.nHeight));
+
+                deltas[{type, hash}].balance += coin.out.nValue;
+                addresses.emplace(type, hash);
+            }
+        }
+
+        for (const auto& address : addresses) {
+            --deltas[address].txCount;
+        }
+    }
+}
+
+bool AddressIndex::CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip)
+{
+    DB::CacheBatch batch;
+    // the balance changes of all disconnected blocks are summed, so each
+    // balance record is read and written once
+    BalanceDeltas deltas;
+    // the changes of each block, to pass on once the index is written
+    const bool notify{m_notify_block_deltas && IsSynced()};
+    std::vector<std::pair<uint256, BalanceDeltas>> block_deltas;
+    {
+        LOCK(cs_main);
+        const CBlockIndex* iter_tip{m_chainstate->m_blockman.LookupBlockIndex(current_tip.hash)};
+        const CBlockIndex* new_tip_index{m_chainstate->m_blockman.LookupBlockIndex(new_tip.hash)};
+        const auto& consensus_params{Params().GetConsensus()};
+
+        do {
+            CBlock block;
+            CBlockUndo block_undo;
+            if (!ReadBlockFromDisk(block, iter_tip, consensus_params) || !UndoReadFromDisk(block_undo, iter_tip)) {
+                return error("%s: Failed to read block %s from disk",
+                             __func__, iter_tip->GetBlockHash().ToString());
+            }
+
+            if (notify) {
+                BalanceDeltas& reverted{block_deltas.emplace_back(iter_tip->GetBlockHash(), BalanceDeltas{}).second};
+                ReverseBlock(block, block_undo, iter_tip->nHeight, batch, reverted);
+                for (const auto& [address, delta] : reverted) {
+                    deltas[address] += delta;
+                }
+            } else {
+                ReverseBlock(block, block_undo, iter_tip->nHeight, batch, deltas);
+            }
+
+            iter_tip = iter_tip->GetAncestor(iter_tip->nHeight - 1);
+        } while (new_tip_index != iter_tip);
+    }
+    WriteBalances(deltas, batch);
+    m_db->WriteCache(batch);
+    for (const auto& [hash, reverted] : block_deltas) {
+        m_notify_block_deltas(hash, /*connected=*/false, reverted);
+    }
+
+    return true;
+}
+
+BaseIndex::DB& AddressIndex::GetDB() const { return *m_db; }
+
+bool AddressIndex::ReadAddressIndex(const uint256& address_hash, int type,
+                                    std::vector<std::pair<CAddressIndexKey, CAmount>>& address_index,
+                                    int start, int end,
+                                    const std::optional<CAddressIndexKey>& after, size_t limit) const
+{
+    if (!MayHaveAddress(address_hash, type)) return true;
+    std::unique_ptr<DB::CachedIterator> pcursor{m_db->NewCachedIterator(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, address_hash)))};
+
+    if (after) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, *after));
+    } else if (start > 0 && end > 0) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, address_hash, start)));
+    } else {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, address_hash)));
+    }
+
+    const size_t max_size{limit > 0 ? address_index.size() + limit : std::numeric_limits<size_t>::max()};
+    while (pcursor->Valid() && address_index.size() < max_size) {
+        std::pair<uint8_t, CAddressIndexKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRESSINDEX || key.second.hashBytes != address_hash) break;
+        if (end > 0 && key.second.blockHeight > end) break;
+        if (after && key.second == *after) {
+            pcursor->Next();
+            continue;
+        }
+
+        CAmount value;
+        if (!pcursor->GetValue(value)) {
+            return error("failed to get address index value");
+        }
+        address_index.emplace_back(key.second, value);
+        pcursor->Next();
+    }
+
+    return true;
+}
+
+bool AddressIndex::ReadAddressUnspentIndex(const uint256& address_hash, int type,
+                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>>& unspent_outputs,
+                                           const std::optional<CAddressUnspentKey>& after, size_t limit) const
+{
+    if (!MayHaveAddress(address_hash, type)) return true;
+    std::unique_ptr<DB::CachedIterator> pcursor{m_db->NewCachedIterator(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, address_hash)))};
+
+    if (after) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, *after));
+    } else {
+        pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, address_hash)));
+    }
+
+    const size_t max_size{limit > 0 ? unspent_outputs.size() + limit : std::numeric_limits<size_t>::max()};
+    while (pcursor->Valid() && unspent_outputs.size() < max_size) {
+        std::pair<uint8_t, CAddressUnspentKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRESSUNSPENTINDEX || key.second.hashBytes != address_hash) break;
+        if (after && key.second == *after) {
+            pcursor->Next();
+            continue;
+        }
+
+        CAddressUnspentValue value;
+        if (!pcursor->GetValue(value)) {
+            return error("failed to get address unspent value");
+        }
+        unspent_outputs.emplace_back(key.second, value);
+        pcursor->Next();
+    }
+
+    return true;
+}
+
+bool AddressIndex::ReadAddressBalance(const uint256& address_hash, int type, CAddressBalanceValue& balance) const
+{
+    balance.SetNull();
+    if (!MayHaveAddress(address_hash, type)) return true;
+    // an address without a record has no history
+    m_db->ReadCached(std::make_pair(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(type, address_hash)), balance);
+    return true;
+}
+
+bool AddressIndex::ReadAddressCoinbase(const uint256& address_hash, int type, int start, CAmount& received) const
+{
+    received = 0;
+    if (!MayHaveAddress(address_hash, type)) return true;
+    std::unique_ptr<DB::CachedIterator> pcursor{m_db->NewCachedIterator(std::make_pair(DB_ADDRESSCOINBASE, CAddressIndexIteratorKey(type, address_hash)))};
+
+    pcursor->Seek(std::make_pair(DB_ADDRESSCOINBASE, CAddressCoinbaseKey(type, address_hash, start)));
+
+    while (pcursor->Valid()) {
+        std::pair<uint8_t, CAddressCoinbaseKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRESSCOINBASE || key.second.type != unsigned(type) || key.second.hashBytes != address_hash) break;
+
+        CAmount value;
+        if (!pcursor->GetValue(value)) {
+            return error("failed to get address coinbase value");
+        }
+        received += value;
+        pcursor->Next();
+    }
+
+    return true;
+}
@@ -0,0 +1,244 @@
+// Copyright (c) 2023 The Sugarchain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_ADDRESSINDEX_H
+#define BITCOIN_INDEX_ADDRESSINDEX_H
+
+#include <attributes.h>
+#include <consensus/amount.h>
+#include <index/base.h>
+#include <span.h>
+#include <spentindex.h>
+#include <sync.h>
+#include <util/threadinterrupt.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class CBlock;
+class CBlockUndo;
+
+static constexpr bool DEFAULT_ADDRESSINDEX{false};
+
+/**
+ * A blocked bloom filter over the addresses of the address index, to answer
+ * lookups of addresses that were never used without reading the database.
+ * An address sets the bits of one block, the size of a cache line, that is
+ * picked with a keyed hash. The filter is stored in pages, and only the pages
+ * that changed since they were last stored are written.
+ *
+ * Addresses are never removed, so the filter stays a superset of the
+ * addresses of the index when blocks are disconnected.
+ */
+class AddressFilter
+{
+public:
+    /// Bytes of a block, whose bits an address sets
+    static constexpr size_t BLOCK_SIZE{64};
+    /// Bytes of a page, the unit the filter is stored in
+    static constexpr size_t PAGE_SIZE{4096};
+    /// Bits per address, for about 1% false positives when the filter is full
+    static constexpr uint64_t BITS_PER_ADDRESS{10};
+    /// Bits an address sets in its block
+    static constexpr int NUM_HASH_BITS{7};
+
+private:
+    uint64_t m_k0;
+    uint64_t m_k1;
+    std::vector<unsigned char> m_data;
+    /// Number of inserted addresses that set at least one bit
+    uint64_t m_count{0};
+    /// Number of changes to the pages, which identifies the last one
+    uint64_t m_changes{0};
+
+public:
+    /// Pages that changed since they were stored, with their last change
+    using DirtyPages = std::map<uint32_t, uint64_t>;
+
+private:
+    DirtyPages m_dirty_pages;
+
+public:
+    /// An empty filter of n_pages pages, hashing with the SipHash key k0, k1
+    AddressFilter(uint64_t k0, uint64_t k1, uint32_t n_pages);
+
+    /// Number of pages to hold n_addresses, with room for as many again
+    static uint32_t PagesFor(uint64_t n_addresses);
+
+    void Insert(int type, const uint256& hash);
+
+    /// False if the address was never inserted
+    bool MayContain(int type, const uint256& hash) const;
+
+    uint64_t GetK0() const { return m_k0; }
+    uint64_t GetK1() const { return m_k1; }
+    uint32_t GetNumPages() const { return m_data.size() / PAGE_SIZE; }
+    uint64_t GetCount() const { return m_count; }
+
+    /// Whether the filter holds more addresses than it is sized for
+    bool IsFull() const { return m_count > m_data.size() * 8 / BITS_PER_ADDRESS; }
+
+    Span<const unsigned char> GetPage(uint32_t page) const { return Span{m_data}.subspan(page * PAGE_SIZE, PAGE_SIZE); }
+
+    /// Restore a stored page and the number of addresses, false if the page does not fit
+    bool LoadPage(uint32_t page, Span<const unsigned char> data);
+    void LoadCount(uint64_t count) { m_count = count; }
+
+    const DirtyPages& GetDirtyPages() const LIFETIMEBOUND { return m_dirty_pages; }
+
+    /// Mark the written pages as stored, unless they changed again since
+    void ClearDirtyPages(const DirtyPages& written);
+
+    /// Mark all pages as stored
+    void ClearDirtyPages() { m_dirty_pages.clear(); }
+};
+
+/**
+ * AddressIndex records every change to the balance of an address, and the
+ * outputs of the address that are still unspent. Only outputs whose script is
+ * of a known address type, and the inputs spending them, are indexed. A
+ * balance record per address is updated along with them, so balances are
+ * looked up without reading the address history.
+ *
+ * The index is written to its own LevelDB database, and spent outputs are
+ * looked up in the block undo data, so it can be built after the fact on a
+ * node that has all blocks. The entries of new blocks are kept in a write
+ * cache and reach the database along with the best block locator.
+ *
+ * An AddressFilter over the indexed addresses is kept in memory and stored
+ * with each commit, so lookups of unused addresses return without reading
+ * the database. A filter that is full, or missing, is rebuilt from the
+ * database on a thread of its own, while the index keeps appending blocks
+ * and lookups use the old filter.
+ */
+class AddressIndex final : public BaseIndex
+{
+    friend struct AddressIndexTest; // for test access to the filter rebuild
+
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+    mutable Mutex m_filter_mutex;
+    /// Filter over the addresses in the index, null until it is loaded or built
+    std::unique_ptr<AddressFilter> m_filter GUARDED_BY(m_filter_mutex);
+    /// The filter and its pages written by the commit in progress
+    const AddressFilter* m_committing_filter GUARDED_BY(m_filter_mutex){nullptr};
+    AddressFilter::DirtyPages m_committing_pages GUARDED_BY(m_filter_mutex);
+
+    /// Builds a new filter in the background, see StartFilterRebuild
+    std::thread m_filter_builder GUARDED_BY(m_filter_mutex);
+    CThreadInterrupt m_filter_interrupt;
+    bool m_filter_rebuilding GUARDED_BY(m_filter_mutex){false};
+    /// Addresses inserted since the rebuild started, which the new filter may miss
+    std::set<std::pair<int, uint256>> m_filter_pending GUARDED_BY(m_filter_mutex);
+
+    bool AllowPrune() const override { return false; }
+
+public:
+    /// Changes to the balance records, by address type and hash
+    using BalanceDeltas = std::map<std::pair<int, uint256>, CAddressBalanceValue>;
+    /// Receives the balance changes of a block the index connected, or
+    /// disconnected, in which case they are the ones that were reverted
+    using BlockDeltasFn = std::function<void(const uint256& block_hash, bool connected, const BalanceDeltas& deltas)>;
+
+private:
+    BlockDeltasFn m_notify_block_deltas;
+
+    /// Add balance changes to the stored balance records.
+    void WriteBalances(const BalanceDeltas& deltas, BaseIndex::DB::CacheBatch& batch) const EXCLUSIVE_LOCKS_REQUIRED(!m_filter_mutex);
+
+    /// Undo the entries that were written for a block, and collect its balance changes.
+    void ReverseBlock(const CBlock& block, const CBlockUndo& block_undo, int height, BaseIndex::DB::CacheBatch& batch, BalanceDeltas& deltas) const;
+
+    /// Read the stored address filter, false if there is none.
+    bool LoadFilter() EXCLUSIVE_LOCKS_REQUIRED(!m_filter_mutex);
+
+    /// Build an address filter over the addresses that have a balance record,
+    /// with room for at least n_addresses. Null if interrupted.
+    std::unique_ptr<AddressFilter> BuildFilter(uint64_t n_addresses, const CThreadInterrupt* interrupt = nullptr) const;
+
+    /// Add the addresses of a block to the filter, and rebuild it larger when it is full.
+    void InsertIntoFilter(const BalanceDeltas& deltas) EXCLUSIVE_LOCKS_REQUIRED(!m_filter_mutex);
+
+    /// Start building a filter with room for at least n_addresses on
+    /// m_filter_builder, unless a build is running already. Once built, the
+    /// addresses inserted meanwhile are added and it replaces m_filter.
+    void StartFilterRebuild(uint64_t n_addresses) EXCLUSIVE_LOCKS_REQUIRED(m_filter_mutex);
+
+    /// Add the addresses inserted since the rebuild started to the built
+    /// filter, which replaces m_filter unless the rebuild was interrupted.
+    void FinishFilterRebuild(std::unique_ptr<AddressFilter> filter) EXCLUSIVE_LOCKS_REQUIRED(!m_filter_mutex);
+
+    /// False if the address certainly has no entries in the index
+    bool MayHaveAddress(const uint256& address_hash, int type) const EXCLUSIVE_LOCKS_REQUIRED(!m_filter_mutex);
+
+protected:
+    bool CustomInit(const std::optional<interfaces::BlockKey>& block) override;
+
+    bool CustomAppend(const interfaces::BlockInfo& block) override;
+
+    bool CustomCommit(CDBBatch& batch) override;
+
+    void CustomCommitted() override;
+
+    bool RewindsOnDisconnect() const override { return true; }
+
+    bool NeedsUndoData() const override { return true; }
+
+    bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+public:
+    /// Constructs the index, which becomes available to be queried. The
+    /// entries of new blocks are kept in up to n_write_cache_size bytes of
+    /// memory until the index is committed.
+    explicit AddressIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, size_t n_write_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    // It also interrupts and joins a filter rebuild.
+    virtual ~AddressIndex() override;
+
+    /// Pass the balance changes of the blocks connected and disconnected once
+    /// the index is in sync to fn, which is called on the validation
+    /// notification thread. Set before the index is started.
+    void SetBlockDeltasNotifier(BlockDeltasFn fn) { m_notify_block_deltas = std::move(fn); }
+
+    /// Look up the balance changes of an address, ordered by height. With
+    /// start and end set, only those of blocks start to end are returned.
+    /// With after set, the lookup resumes behind that entry, and with limit
+    /// set, at most limit entries are added.
+    bool ReadAddressIndex(const uint256& address_hash, int type,
+                          std::vector<std::pair<CAddressIndexKey, CAmount>>& address_index,
+                          int start = 0, int end = 0,
+                          const std::optional<CAddressIndexKey>& after = std::nullopt, size_t limit = 0) const EXCLUSIVE_LOCKS_REQUIRED(!m_filter_mutex);
+
+    /// Look up the unspent outputs of an address, optionally resuming behind
+    /// an entry and adding at most limit entries.
+    bool ReadAddressUnspentIndex(const uint256& address_hash, int type,
+                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>>& unspent_outputs,
+                                 const std::optional<CAddressUnspentKey>& after = std::nullopt, size_t limit = 0) const EXCLUSIVE_LOCKS_REQUIRED(!m_filter_mutex);
+
+    /// Look up the balance, total received and transaction count of an
+    /// address, kept up to date as blocks are connected and disconnected.
+    bool ReadAddressBalance(const uint256& address_hash, int type, CAddressBalanceValue& balance) const EXCLUSIVE_LOCKS_REQUIRED(!m_filter_mutex);
+
+    /// Sum the coinbase outputs an address received from height start on.
+    bool ReadAddressCoinbase(const uint256& address_hash, int type, int start, CAmount& received) const EXCLUSIVE_LOCKS_REQUIRED(!m_filter_mutex);
+};
+
+/// The global address index, used by the address RPCs. May be null.
+extern std::unique_ptr<AddressIndex> g_address_index;
+
+#endif // BITCOIN_INDEX_ADDRESSINDEX_H
@@ -7,12 +7,14 @@
 #include <interfaces/chain.h>
 #include <kernel/chain.h>
 #include <logging.h>
+#include <memusage.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
 #include <node/database_args.h>
 #include <node/interface_ui.h>
 #include <shutdown.h>
 #include <tinyformat.h>
+#include <undo.h>
 #include <util/syscall_sandbox.h>
 #include <util/system.h>
 #include <util/thread.h>
@@ -20,16 +22,28 @@
 #include <validation.h> // For g_chainman
 #include <warnings.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 
 using node::ReadBlockFromDisk;
+using node::UndoReadFromDisk;
 
 constexpr uint8_t DB_BEST_BLOCK{'B'};
+constexpr uint8_t DB_VERSION{'V'};
 
 constexpr auto SYNC_LOG_INTERVAL{30s};
 constexpr auto SYNC_LOCATOR_WRITE_INTERVAL{30s};
 
+/** Most threads an index uses to read blocks ahead while it catches up */
+constexpr int MAX_SYNC_READ_THREADS{4};
+/** Blocks read ahead per thread */
+constexpr size_t SYNC_READ_BLOCKS_PER_THREAD{16};
+
 template <typename... Args>
 static void FatalError(const char* fmt, const Args&... args)
 {
@@ -49,16 +63,146 @@ CBlockLocator GetLocator(interfaces::Chain& chain, const uint256& block_hash)
     return locator;
 }
 
-BaseIndex::DB::DB(const fs::path& path, size_t n_cache_size, bool f_memory, bool f_wipe, bool f_obfuscate) :
+BaseIndex::DB::DB(const fs::path& path, size_t n_cache_size, bool f_memory, bool f_wipe, bool f_obfuscate, size_t n_write_cache_size) :
     CDBWrapper{DBParams{
         .path = path,
         .cache_bytes = n_cache_size,
         .memory_only = f_memory,
         .wipe_data = f_wipe,
         .obfuscate = f_obfuscate,
-        .options = [] { DBOptions options; node::ReadDatabaseArgs(gArgs, options); return options; }()}}
+        .options = [] { DBOptions options; node::ReadDatabaseArgs(gArgs, options); return options; }()}},
+    m_cache_limit{n_write_cache_size}
+{}
+
+namespace {
+/** Reads the remaining bytes of a stream, to get the raw keys of the database */
+struct RawEntry {
+    std::vector<unsigned char>& bytes;
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        bytes.resize(s.size());
+        s.read(MakeWritableByteSpan(bytes));
+    }
+};
+
+/** Memory taken by an entry of the write cache */
+template <typename Map>
+size_t CacheEntryUsage(const Map& map, const typename Map::value_type& entry)
+{
+    return memusage::IncrementalDynamicUsage(map) + memusage::DynamicUsage(entry.first) +
+           (entry.second ? memusage::DynamicUsage(*entry.second) : 0);
+}
+} // namespace
+
+BaseIndex::DB::CachedIterator::CachedIterator(std::unique_ptr<CDBIterator> db_cursor, CacheMap cache)
+    : m_cache{std::move(cache)},
+      m_db_cursor{std::move(db_cursor)},
+      m_cache_pos{m_cache.end()}
 {}
 
+std::unique_ptr<BaseIndex::DB::CachedIterator> BaseIndex::DB::MakeCachedIterator(const std::vector<unsigned char>& begin, const std::vector<unsigned char>& end_prefix)
+{
+    // the first key behind all keys that start with end_prefix, empty if there is none
+    std::vector<unsigned char> end{end_prefix};
+    while (!end.empty() && end.back() == 0xff) end.pop_back();
+    if (!end.empty()) ++end.back();
+
+    CacheMap cache;
+    LOCK(m_cache_mutex);
+    // The database iterator reads a snapshot taken now. Along with the cache
+    // entries copied under the same lock, it sees the state after a commit
+    // whose entries are still being written, whether they are on disk yet or not.
+    std::unique_ptr<CDBIterator> db_cursor{NewIterator()};
+    for (const CacheMap* entries : {&m_committing, &m_cache}) {
+        for (auto it{entries->lower_bound(begin)}; it != entries->end() && (end.empty() || it->first < end); ++it) {
+            cache.insert_or_assign(it->first, it->second);
+        }
+    }
+    return std::make_unique<CachedIterator>(std::move(db_cursor), std::move(cache));
+}
+
+void BaseIndex::DB::CachedIterator::Settle()
+{
+    while (true) {
+        RawEntry raw_key{m_db_key};
+        m_db_valid = m_db_cursor->Valid() && m_db_cursor->GetKey(raw_key);
+        m_at_cache = false;
+        if (m_cache_pos == m_cache.end() || (m_db_valid && m_db_key < m_cache_pos->first)) return;
+        if (m_db_valid && m_db_key == m_cache_pos->first) {
+            m_db_cursor->Next();
+        }
+        if (m_cache_pos->second) {
+            m_at_cache = true;
+            return;
+        }
+        ++m_cache_pos;
+    }
+}
+
+void BaseIndex::DB::CachedIterator::Next()
+{
+    if (m_at_cache) {
+        ++m_cache_pos;
+    } else {
+        m_db_cursor->Next();
+    }
+    Settle();
+}
+
+void BaseIndex::DB::WriteCache(const CacheBatch& batch)
+{
+    LOCK(m_cache_mutex);
+    for (const auto& [key, value] : batch.m_entries) {
+        auto [it, inserted]{m_cache.try_emplace(key)};
+        if (!inserted) m_cache_usage -= CacheEntryUsage(m_cache, *it);
+        it->second = value;
+        m_cache_usage += CacheEntryUsage(m_cache, *it);
+    }
+}
+
+bool BaseIndex::DB::CacheFull() const
+{
+    LOCK(m_cache_mutex);
+    return m_cache_usage > m_cache_limit;
+}
+
+bool BaseIndex::DB::WriteBatchWithCache(CDBBatch& batch)
+{
+    LOCK(m_commit_mutex);
+    {
+        LOCK(m_cache_mutex);
+        for (const auto& [key, value] : m_cache) {
+            const Span<const unsigned char> key_bytes{key};
+            if (value) {
+                batch.Write(key_bytes, Span<const unsigned char>{*value});
+            } else {
+                batch.Erase(key_bytes);
+            }
+        }
+        m_committing = std::exchange(m_cache, {});
+        m_cache_usage = 0;
+    }
+
+    const bool written{WriteBatch(batch)};
+
+    LOCK(m_cache_mutex);
+    if (!written) {
+        // keep the entries for the next commit, behind those written meanwhile
+        for (auto& [key, value] : m_cache) {
+            m_committing.insert_or_assign(key, std::move(value));
+        }
+        m_cache = std::exchange(m_committing, {});
+        m_cache_usage = 0;
+        for (const auto& entry : m_cache) {
+            m_cache_usage += CacheEntryUsage(m_cache, entry);
+        }
+    }
+    m_committing.clear();
+    return written;
+}
+
 bool BaseIndex::DB::ReadBestBlock(CBlockLocator& locator) const
 {
     bool success = Read(DB_BEST_BLOCK, locator);
@@ -73,6 +217,25 @@ void BaseIndex::DB::WriteBestBlock(CDBBatch& batch, const CBlockLocator& locator
     batch.Write(DB_BEST_BLOCK, locator);
 }
 
+std::optional<int> BaseIndex::DB::ReadVersion() const
+{
+    int version;
+    if (!Read(DB_VERSION, version)) return std::nullopt;
+    return version;
+}
+
+bool BaseIndex::DB::WriteVersion(int version)
+{
+    return Write(DB_VERSION, version);
+}
+
+bool BaseIndex::DB::HasOtherVersion(int version) const
+{
+    // nothing has been indexed into a database without a best block yet
+    CBlockLocator locator;
+    return ReadBestBlock(locator) && ReadVersion() != version;
+}
+
 BaseIndex::BaseIndex(std::unique_ptr<interfaces::Chain> chain, std::string name)
     : m_chain{std::move(chain)}, m_name{std::move(name)} {}
 
@@ -154,12 +317,110 @@ static const CBlockIndex* NextSyncBlock(const CBlockIndex* pindex_prev, CChain&
     return chain.Next(chain.FindFork(pindex_prev));
 }
 
+struct BaseIndex::BlockReader::Read {
+    const CBlockIndex* const index;
+    CBlock block;
+    CBlockUndo undo;
+    enum class State { QUEUED, READING, DONE, FAILED } state{State::QUEUED};
+
+    explicit Read(const CBlockIndex* pindex) : index{pindex} {}
+};
+
+BaseIndex::BlockReader::BlockReader(const std::string& index_name, bool read_undo, int num_threads)
+    : m_read_undo{read_undo}, m_read_ahead{SYNC_READ_BLOCKS_PER_THREAD * num_threads}
+{
+    for (int n = 0; n < num_threads; ++n) {
+        m_threads.emplace_back(&util::TraceThread, strprintf("%s.read.%i", index_name, n), [this] { ThreadRead(); });
+    }
+}
+
+BaseIndex::BlockReader::~BlockReader()
+{
+    WITH_LOCK(m_mutex, m_stop = true);
+    m_cond.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void BaseIndex::BlockReader::ThreadRead()
+{
+    const auto& consensus_params{Params().GetConsensus()};
+    while (true) {
+        std::shared_ptr<Read> read;
+        {
+            WAIT_LOCK(m_mutex, lock);
+            while (!m_stop) {
+                const auto it{std::find_if(m_reads.begin(), m_reads.end(), [](const auto& r) { return r->state == Read::State::QUEUED; })};
+                if (it != m_reads.end()) {
+                    read = *it;
+                    break;
+                }
+                m_cond.wait(lock);
+            }
+            if (!read) return;
+            read->state = Read::State::READING;
+        }
+
+        // the genesis block has no undo data
+        const bool ok{ReadBlockFromDisk(read->block, read->index, consensus_params) &&
+                      (!m_read_undo || read->index->nHeight == 0 || UndoReadFromDisk(read->undo, read->index))};
+        if (!ok) LogPrintf("%s: Failed to read block %s from disk\n", __func__, read->index->GetBlockHash().ToString());
+        {
+            LOCK(m_mutex);
+            read->state = ok ? Read::State::DONE : Read::State::FAILED;
+        }
+        m_cond.notify_all();
+    }
+}
+
+void BaseIndex::BlockReader::Queue(const CBlockIndex* pindex, const CChain& chain)
+{
+    {
+        LOCK(m_mutex);
+        if (!m_reads.empty() && (m_reads.front()->index != pindex || !chain.Contains(m_reads.back()->index))) {
+            m_reads.clear();
+        }
+        const CBlockIndex* next{m_reads.empty() ? pindex : chain.Next(m_reads.back()->index)};
+        for (; next && m_reads.size() < m_read_ahead; next = chain.Next(next)) {
+            m_reads.push_back(std::make_shared<Read>(next));
+        }
+    }
+    m_cond.notify_all();
+}
+
+bool BaseIndex::BlockReader::Take(const CBlockIndex* pindex, CBlock& block, CBlockUndo& undo)
+{
+    WAIT_LOCK(m_mutex, lock);
+    assert(!m_reads.empty() && m_reads.front()->index == pindex);
+    const std::shared_ptr<Read> read{m_reads.front()};
+    m_cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return read->state == Read::State::DONE || read->state == Read::State::FAILED; });
+    m_reads.pop_front();
+    if (read->state == Read::State::FAILED) return false;
+    block = std::move(read->block);
+    undo = std::move(read->undo);
+    return true;
+}
+
+std::vector<const CBlockIndex*> BaseIndex::BlockReader::Queued() const
+{
+    LOCK(m_mutex);
+    std::vector<const CBlockIndex*> queued;
+    for (const auto& read : m_reads) {
+        queued.push_back(read->index);
+    }
+    return queued;
+}
+
 void BaseIndex::ThreadSync()
 {
     SetSyscallSandboxPolicy(SyscallSandboxPolicy::TX_INDEX);
     const CBlockIndex* pindex = m_best_block_index.load();
     if (!m_synced) {
-        auto& consensus_params = Params().GetConsensus();
+        // Reading a block from disk and deserializing it takes longer than
+        // indexing it, so blocks are read ahead in parallel and appended in
+        // order
+        m_block_reader = std::make_unique<BlockReader>(GetName(), NeedsUndoData(), std::clamp(GetNumCores() - 1, 1, MAX_SYNC_READ_THREADS));
 
         std::chrono::steady_clock::time_point last_log_time{0s};
         std::chrono::steady_clock::time_point last_locator_write_time{0s};
@@ -189,6 +450,7 @@ void BaseIndex::ThreadSync()
                     return;
                 }
                 pindex = pindex_next;
+                m_block_reader->Queue(pindex, m_chainstate->m_chain);
             }
 
             auto current_time{std::chrono::steady_clock::now()};
@@ -198,7 +460,8 @@ void BaseIndex::ThreadSync()
                 last_log_time = current_time;
             }
 
-            if (last_locator_write_time + SYNC_LOCATOR_WRITE_INTERVAL < current_time) {
+            // a full write cache is committed early
+            if (last_locator_write_time + SYNC_LOCATOR_WRITE_INTERVAL < current_time || GetDB().CacheFull()) {
                 SetBestBlockIndex(pindex->pprev);
                 last_locator_write_time = current_time;
                 // No need to handle errors in Commit. See rationale above.
@@ -206,13 +469,16 @@ void BaseIndex::ThreadSync()
             }
 
             CBlock block;
-            interfaces::BlockInfo block_info = kernel::MakeBlockInfo(pindex);
-            if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+            CBlockUndo block_undo;
+            if (!m_block_reader->Take(pindex, block, block_undo)) {
                 FatalError("%s: Failed to read block %s from disk",
                            __func__, pindex->GetBlockHash().ToString());
                 return;
-            } else {
-                block_info.data = &block;
+            }
+            interfaces::BlockInfo block_info = kernel::MakeBlockInfo(pindex);
+            block_info.data = &block;
+            if (NeedsUndoData() && pindex->nHeight > 0) {
+                block_info.undo_data = &block_undo;
             }
             if (!CustomAppend(block_info)) {
                 FatalError("%s: Failed to write block %s to index database",
@@ -220,6 +486,7 @@ void BaseIndex::ThreadSync()
                 return;
             }
         }
+        m_block_reader.reset();
     }
 
     if (pindex) {
@@ -239,7 +506,8 @@ bool BaseIndex::Commit()
         ok = CustomCommit(batch);
         if (ok) {
             GetDB().WriteBestBlock(batch, GetLocator(*m_chain, m_best_block_index.load()->GetBlockHash()));
-            ok = GetDB().WriteBatch(batch);
+            ok = GetDB().WriteBatchWithCache(batch);
+            if (ok) CustomCommitted();
         }
     }
     if (!ok) {
@@ -304,7 +572,21 @@ void BaseIndex::BlockConnected(const std::shared_ptr<const CBlock>& block, const
             return;
         }
     }
+    // Commit a full write cache before the block is added to it, while it
+    // matches the best block. No need to handle errors, see ChainStateFlushed.
+    if (GetDB().CacheFull()) {
+        Commit();
+    }
     interfaces::BlockInfo block_info = kernel::MakeBlockInfo(pindex, block.get());
+    CBlockUndo block_undo;
+    if (NeedsUndoData() && pindex->nHeight > 0) {
+        if (!UndoReadFromDisk(block_undo, pindex)) {
+            FatalError("%s: Failed to read undo data of block %s from disk",
+                       __func__, pindex->GetBlockHash().ToString());
+            return;
+        }
+        block_info.undo_data = &block_undo;
+    }
     if (CustomAppend(block_info)) {
         // Setting the best block index is intentionally the last step of this
         // function, so BlockUntilSyncedToCurrentChain callers waiting for the
@@ -318,6 +600,24 @@ void BaseIndex::BlockConnected(const std::shared_ptr<const CBlock>& block, const
     }
 }
 
+void BaseIndex::BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex)
+{
+    if (!m_synced || !RewindsOnDisconnect()) {
+        return;
+    }
+
+    // Rewind right away instead of on the next connected block, so the index
+    // never serves data of a block that is no longer in the active chain.
+    const CBlockIndex* best_block_index = m_best_block_index.load();
+    if (best_block_index != pindex) {
+        return;
+    }
+    if (!Rewind(best_block_index, pindex->pprev)) {
+        FatalError("%s: Failed to rewind index %s to a previous chain tip",
+                   __func__, GetName());
+    }
+}
+
 void BaseIndex::ChainStateFlushed(const CBlockLocator& locator)
 {
     if (!m_synced) {
@@ -371,7 +671,9 @@ bool BaseIndex::BlockUntilSyncedToCurrentChain() const
         LOCK(cs_main);
         const CBlockIndex* chain_tip = m_chainstate->m_chain.Tip();
         const CBlockIndex* best_block_index = m_best_block_index.load();
-        if (best_block_index->GetAncestor(chain_tip->nHeight) == chain_tip) {
+        // An index that rewinds on disconnect has pending notifications
+        // while it is ahead of the tip, on blocks that were disconnected.
+        if (RewindsOnDisconnect() ? best_block_index == chain_tip : best_block_index->GetAncestor(chain_tip->nHeight) == chain_tip) {
             return true;
         }
     }
@@ -412,6 +714,7 @@ void BaseIndex::Stop()
     if (m_thread_sync.joinable()) {
         m_thread_sync.join();
     }
+    m_block_reader.reset();
 }
 
 IndexSummary BaseIndex::GetSummary() const
@@ -7,13 +7,25 @@
 
 #include <dbwrapper.h>
 #include <interfaces/chain.h>
+#include <kernel/cs_main.h>
+#include <logging.h>
+#include <sync.h>
 #include <util/threadinterrupt.h>
 #include <validationinterface.h>
 
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <optional>
 #include <string>
+#include <thread>
+#include <vector>
 
 class CBlock;
 class CBlockIndex;
+class CBlockUndo;
+class CChain;
 class Chainstate;
 namespace interfaces {
 class Chain;
@@ -42,15 +54,201 @@ protected:
     */
     class DB : public CDBWrapper
     {
+        /// Serialized entries written since the last commit, by serialized
+        /// key. Erased entries have no value.
+        using CacheMap = std::map<std::vector<unsigned char>, std::optional<std::vector<unsigned char>>>;
+
+        template <typename T>
+        static std::vector<unsigned char> SerializeEntry(const T& obj)
+        {
+            CDataStream stream{SER_DISK, CLIENT_VERSION};
+            stream << obj;
+            return {UCharCast(stream.data()), UCharCast(stream.data()) + stream.size()};
+        }
+
+        template <typename T>
+        static bool UnserializeEntry(const std::vector<unsigned char>& bytes, T& obj)
+        {
+            try {
+                CDataStream stream{MakeByteSpan(bytes), SER_DISK, CLIENT_VERSION};
+                stream >> obj;
+            } catch (const std::exception&) {
+                return false;
+            }
+            return true;
+        }
+
+        /// Serializes commits, which write the database outside m_cache_mutex
+        Mutex m_commit_mutex;
+        mutable Mutex m_cache_mutex;
+        CacheMap m_cache GUARDED_BY(m_cache_mutex);
+        /// Entries of the commit being written, seen by readers until they
+        /// are on disk. m_cache takes precedence over them.
+        CacheMap m_committing GUARDED_BY(m_cache_mutex);
+        size_t m_cache_usage GUARDED_BY(m_cache_mutex){0};
+        const size_t m_cache_limit;
+
     public:
+        /// With n_write_cache_size set, entries written with WriteCache are
+        /// kept in memory until the next commit, or until they take up more
+        /// than that.
         DB(const fs::path& path, size_t n_cache_size,
-           bool f_memory = false, bool f_wipe = false, bool f_obfuscate = false);
+           bool f_memory = false, bool f_wipe = false, bool f_obfuscate = false,
+           size_t n_write_cache_size = 0);
+
+        /// Entries written for a block, applied to the write cache at once so
+        /// readers never see part of a block.
+        class CacheBatch
+        {
+            friend class DB;
+            std::vector<std::pair<std::vector<unsigned char>, std::optional<std::vector<unsigned char>>>> m_entries;
+
+        public:
+            template <typename K, typename V>
+            void Write(const K& key, const V& value) { m_entries.emplace_back(SerializeEntry(key), SerializeEntry(value)); }
+
+            template <typename K>
+            void Erase(const K& key) { m_entries.emplace_back(SerializeEntry(key), std::nullopt); }
+        };
+
+        /// Iterates over the database with the write cache applied on top.
+        /// It reads a snapshot of the database and a copy of the cache
+        /// entries in its key range, both taken at its creation, so it does
+        /// not hold up writes. It must not be moved outside that range.
+        class CachedIterator
+        {
+            const CacheMap m_cache;
+            const std::unique_ptr<CDBIterator> m_db_cursor;
+            CacheMap::const_iterator m_cache_pos;
+            std::vector<unsigned char> m_db_key;
+            bool m_db_valid{false};
+            bool m_at_cache{false};
+
+            /// Skip erased entries and database entries the cache replaces.
+            void Settle();
+
+        public:
+            CachedIterator(std::unique_ptr<CDBIterator> db_cursor, CacheMap cache);
+
+            template <typename K>
+            void Seek(const K& key)
+            {
+                m_db_cursor->Seek(key);
+                m_cache_pos = m_cache.lower_bound(SerializeEntry(key));
+                Settle();
+            }
+
+            bool Valid() const { return m_at_cache || m_db_valid; }
+
+            void Next();
+
+            template <typename K>
+            bool GetKey(K& key) const { return UnserializeEntry(m_at_cache ? m_cache_pos->first : m_db_key, key); }
+
+            template <typename V>
+            bool GetValue(V& value) const { return m_at_cache ? UnserializeEntry(*m_cache_pos->second, value) : m_db_cursor->GetValue(value); }
+        };
+
+        /// Read an entry, seeing the entries in the write cache.
+        template <typename K, typename V>
+        bool ReadCached(const K& key, V& value) const EXCLUSIVE_LOCKS_REQUIRED(!m_cache_mutex)
+        {
+            const std::vector<unsigned char> key_bytes{SerializeEntry(key)};
+            {
+                LOCK(m_cache_mutex);
+                for (const CacheMap* cache : {&m_cache, &m_committing}) {
+                    if (const auto it{cache->find(key_bytes)}; it != cache->end()) {
+                        return it->second && UnserializeEntry(*it->second, value);
+                    }
+                }
+            }
+            // an entry that is in neither is not changed by a commit
+            return Read(key, value);
+        }
+
+        /// Iterator over the entries from key begin up to those whose key
+        /// starts with end.
+        template <typename B, typename E>
+        std::unique_ptr<CachedIterator> NewCachedIterator(const B& begin, const E& end) EXCLUSIVE_LOCKS_REQUIRED(!m_cache_mutex)
+        {
+            return MakeCachedIterator(SerializeEntry(begin), SerializeEntry(end));
+        }
+
+        /// Iterator over the entries whose key starts with prefix.
+        template <typename P>
+        std::unique_ptr<CachedIterator> NewCachedIterator(const P& prefix) EXCLUSIVE_LOCKS_REQUIRED(!m_cache_mutex)
+        {
+            return NewCachedIterator(prefix, prefix);
+        }
+
+        /// Apply the entries of a batch to the write cache.
+        void WriteCache(const CacheBatch& batch) EXCLUSIVE_LOCKS_REQUIRED(!m_cache_mutex);
+
+        /// Whether the write cache has grown beyond its limit and should be
+        /// committed.
+        bool CacheFull() const EXCLUSIVE_LOCKS_REQUIRED(!m_cache_mutex);
+
+        /// Write the batch along with the entries of the write cache, and
+        /// empty the cache. Readers and WriteCache are not held up while the
+        /// batch is written. On failure the entries stay in the cache.
+        bool WriteBatchWithCache(CDBBatch& batch) EXCLUSIVE_LOCKS_REQUIRED(!m_commit_mutex, !m_cache_mutex);
 
         /// Read block locator of the chain that the index is in sync with.
         bool ReadBestBlock(CBlockLocator& locator) const;
 
         /// Write block locator of the chain that the index is in sync with.
         void WriteBestBlock(CDBBatch& batch, const CBlockLocator& locator);
+
+        /// Read the version of the database format, none if it was not written.
+        std::optional<int> ReadVersion() const;
+
+        /// Write the version of the database format.
+        bool WriteVersion(int version);
+
+        /// Whether the database has index entries of another format version.
+        bool HasOtherVersion(int version) const;
+
+    private:
+        std::unique_ptr<CachedIterator> MakeCachedIterator(const std::vector<unsigned char>& begin, const std::vector<unsigned char>& end_prefix) EXCLUSIVE_LOCKS_REQUIRED(!m_cache_mutex);
+    };
+
+    /**
+     * Reads the blocks the sync thread appends next, and their undo data if the
+     * index needs it, on threads of its own. Blocks are queued and taken in chain
+     * order, so the following ones are read while the current one is appended.
+     */
+    class BlockReader
+    {
+        struct Read;
+
+        const bool m_read_undo;
+        const size_t m_read_ahead;
+
+        mutable Mutex m_mutex;
+        std::condition_variable m_cond;
+        /// The blocks read ahead, in chain order. A read that is dropped while
+        /// it is in progress stays alive until its thread is done with it.
+        std::deque<std::shared_ptr<Read>> m_reads GUARDED_BY(m_mutex);
+        bool m_stop GUARDED_BY(m_mutex){false};
+
+        std::vector<std::thread> m_threads;
+
+        void ThreadRead() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    public:
+        BlockReader(const std::string& index_name, bool read_undo, int num_threads);
+        ~BlockReader();
+
+        /// Queue the blocks from pindex on that are not queued yet. Reads that do
+        /// not lead up to pindex along the chain, after a reorg, are dropped.
+        void Queue(const CBlockIndex* pindex, const CChain& chain) EXCLUSIVE_LOCKS_REQUIRED(::cs_main, !m_mutex);
+
+        /// Wait for the block that was queued first, pindex, to be read and take
+        /// it out of the queue. False if it could not be read.
+        bool Take(const CBlockIndex* pindex, CBlock& block, CBlockUndo& undo) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+        /// The blocks that are queued, in order. Used by tests.
+        std::vector<const CBlockIndex*> Queued() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
     };
 
 private:
@@ -69,6 +267,9 @@ private:
     std::thread m_thread_sync;
     CThreadInterrupt m_interrupt;
 
+    /// Threads that read blocks ahead for the sync thread while it catches up
+    std::unique_ptr<BlockReader> m_block_reader;
+
     /// Read best block locator and check that data needed to sync has not been pruned.
     bool Init();
 
@@ -101,18 +302,40 @@ protected:
 
     void BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override;
 
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override;
+
     void ChainStateFlushed(const CBlockLocator& locator) override;
 
+    /// Whether the index is in sync, so blocks reach it through the
+    /// BlockConnected and BlockDisconnected notifications.
+    bool IsSynced() const { return m_synced; }
+
     /// Initialize internal state from the database and block index.
     [[nodiscard]] virtual bool CustomInit(const std::optional<interfaces::BlockKey>& block) { return true; }
 
     /// Write update index entries for a newly connected block.
     [[nodiscard]] virtual bool CustomAppend(const interfaces::BlockInfo& block) { return true; }
 
+    /// Whether the index rewinds as soon as its best block is disconnected,
+    /// rather than when the next block of the new chain is connected. Queries
+    /// then wait for the rewind, and never see the entries of a disconnected
+    /// block. Off by default, so txindex, coinstatsindex and the block
+    /// filter indexes keep rewinding on the next connected block, as before.
+    virtual bool RewindsOnDisconnect() const { return false; }
+
+    /// Whether CustomAppend uses undo data. It is then passed in
+    /// BlockInfo::undo_data for every block but the genesis block, and read
+    /// ahead along with the blocks while the index catches up.
+    virtual bool NeedsUndoData() const { return false; }
+
     /// Virtual method called internally by Commit that can be overridden to atomically
     /// commit more index state.
     virtual bool CustomCommit(CDBBatch& batch) { return true; }
 
+    /// Called once the batch of CustomCommit is written, to drop the state
+    /// that has to be kept until then.
+    virtual void CustomCommitted() {}
+
     /// Rewind index to an earlier chain tip during a chain reorg. The tip must
     /// be an ancestor of the current best block.
     [[nodiscard]] virtual bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) { return true; }
@@ -122,6 +345,22 @@ protected:
     /// Get the name of the index for display in logs.
     const std::string& GetName() const LIFETIMEBOUND { return m_name; }
 
+    /// Open the database of the index with make_db(f_wipe). A database with
+    /// entries of another format version is opened wiped instead, so the
+    /// index is rebuilt. A database without a version is marked with version.
+    template <typename MakeDB>
+    auto OpenVersionedDB(int version, bool f_wipe, MakeDB make_db) const
+    {
+        auto db{make_db(f_wipe)};
+        if (!f_wipe && db->HasOtherVersion(version)) {
+            LogPrintf("%s: database is not of format version %d, rebuilding the index\n", GetName(), version);
+            db.reset();
+            db = make_db(/*f_wipe=*/true);
+        }
+        if (!db->ReadVersion()) db->WriteVersion(version);
+        return db;
+    }
+
     /// Update the internal best block index as well as the prune lock.
     void SetBestBlockIndex(const CBlockIndex* block);
 
@@ -0,0 +1,142 @@
+// Copyright (c) 2023 The Sugarchain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/spentindex.h>
+
+#include <chainparams.h>
+#include <logging.h>
+#include <node/blockstorage.h>
+#include <undo.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <numeric>
+
+using node::ReadBlockFromDisk;
+using node::UndoReadFromDisk;
+
+constexpr uint8_t DB_SPENTINDEX{'P'};
+
+/** Version 1 stores the compact encoding of the keys and values */
+constexpr int DB_CURRENT_VERSION{1};
+
+std::unique_ptr<SpentIndex> g_spent_index;
+
+/** Access to the spent index database (indexes/spentindex/) */
+class SpentIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, size_t n_write_cache_size, bool f_memory = false, bool f_wipe = false);
+};
+
+SpentIndex::DB::DB(size_t n_cache_size, size_t n_write_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "spentindex", n_cache_size, f_memory, f_wipe, /*f_obfuscate=*/false, n_write_cache_size)
+{}
+
+SpentIndex::SpentIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, size_t n_write_cache_size, bool f_memory, bool f_wipe)
+    : BaseIndex(std::move(chain), "spentindex"),
+      m_db(OpenVersionedDB(DB_CURRENT_VERSION, f_wipe, [&](bool wipe) { return std::make_unique<SpentIndex::DB>(n_cache_size, n_write_cache_size, f_memory, wipe); }))
+{}
+
+SpentIndex::~SpentIndex() = default;
+
+bool SpentIndex::CustomAppend(const interfaces::BlockInfo& block)
+{
+    // The genesis block spends nothing and has no undo data.
+    if (block.height == 0) return true;
+
+    assert(block.data);
+    assert(block.undo_data);
+    const CBlockUndo* block_undo{block.undo_data};
+    DB::CacheBatch batch;
+    for (size_t i = 1; i < block.data->vtx.size(); ++i) {
+        const CTransaction& tx{*block.data->vtx[i]};
+        const CTxUndo& tx_undo{block_undo->vtxundo.at(i - 1)};
+
+        for (size_t j = 0; j < tx.vin.size(); ++j) {
+            const CTxOut& prevout{tx_undo.vprevout.at(j).out};
+            std::vector<unsigned char> hash_bytes;
+            int type = 0;
+            if (!ExtractIndexInfo(&prevout.scriptPubKey, type, hash_bytes) || type == 0) continue;
+
+            // add the spent index to determine the txid and input that spent an output
+            // and to find the amount and address from an input
+            const COutPoint& out{tx.vin[j].prevout};
+            batch.Write(std::make_pair(DB_SPENTINDEX, CSpentIndexKey(out.hash, out.n)),
+                        CSpentIndexValue(tx.GetHash(), j, block.height, prevout.nValue, type, uint256(hash_bytes.data(), hash_bytes.size())));
+        }
+    }
+    m_db->WriteCache(batch);
+    return true;
+}
+
+bool SpentIndex::CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip)
+{
+    DB::CacheBatch batch;
+    {
+        LOCK(cs_main);
+        const CBlockIndex* iter_tip{m_chainstate->m_blockman.LookupBlockIndex(current_tip.hash)};
+        const CBlockIndex* new_tip_index{m_chainstate->m_blockman.LookupBlockIndex(new_tip.hash)};
+        const auto& consensus_params{Params().GetConsensus()};
+
+        do {
+            CBlock block;
+            if (!ReadBlockFromDisk(block, iter_tip, consensus_params)) {
+                return error("%s: Failed to read block %s from disk",
+                             __func__, iter_tip->GetBlockHash().ToString());
+            }
+
+            // Erasing the outputs that were not indexed is a no-op, so the
+            // undo data is not needed here
+            for (const CTransactionRef& tx : block.vtx) {
+                if (tx->IsCoinBase()) continue;
+                for (const CTxIn& input : tx->vin) {
+                    batch.Erase(std::make_pair(DB_SPENTINDEX, CSpentIndexKey(input.prevout.hash, input.prevout.n)));
+                }
+            }
+
+            iter_tip = iter_tip->GetAncestor(iter_tip->nHeight - 1);
+        } while (new_tip_index != iter_tip);
+    }
+    m_db->WriteCache(batch);
+
+    return true;
+}
+
+BaseIndex::DB& SpentIndex::GetDB() const { return *m_db; }
+
+bool SpentIndex::ReadSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value) const
+{
+    return m_db->ReadCached(std::make_pair(DB_SPENTINDEX, key), value);
+}
+
+bool SpentIndex::ReadSpentIndex(const std::vector<CSpentIndexKey>& keys, std::vector<std::optional<CSpentIndexValue>>& values) const
+{
+    // Seeking forward from the previous position mostly stays within the
+    // block the iterator has already loaded
+    std::vector<size_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return CSpentIndexKeyCompare()(keys[a], keys[b]); });
+
+    values.assign(keys.size(), std::nullopt);
+    if (keys.empty()) return true;
+    std::unique_ptr<DB::CachedIterator> pcursor{m_db->NewCachedIterator(std::make_pair(DB_SPENTINDEX, keys[order.front()].txid),
+                                                                        std::make_pair(DB_SPENTINDEX, keys[order.back()].txid))};
+    for (const size_t i : order) {
+        pcursor->Seek(std::make_pair(DB_SPENTINDEX, keys[i]));
+        std::pair<uint8_t, CSpentIndexKey> key;
+        if (!pcursor->Valid() || !pcursor->GetKey(key) || key.first != DB_SPENTINDEX ||
+            key.second.txid != keys[i].txid || key.second.outputIndex != keys[i].outputIndex) {
+            continue;
+        }
+        CSpentIndexValue value;
+        if (!pcursor->GetValue(value)) {
+            return error("%s: Cannot read spent index value", __func__);
+        }
+        values[i] = value;
+    }
+
+    return true;
+}
@@ -0,0 +1,64 @@
+// Copyright (c) 2023 The Sugarchain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_SPENTINDEX_H
+#define BITCOIN_INDEX_SPENTINDEX_H
+
+#include <index/base.h>
+#include <spentindex.h>
+
+#include <optional>
+#include <vector>
+
+static constexpr bool DEFAULT_SPENTINDEX{false};
+
+/**
+ * SpentIndex records, for every spent output of a known address type, the
+ * transaction input that spent it, along with the output's amount and address
+ * taken from the block undo data.
+ */
+class SpentIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+    bool AllowPrune() const override { return false; }
+
+protected:
+    bool CustomAppend(const interfaces::BlockInfo& block) override;
+
+    bool RewindsOnDisconnect() const override { return true; }
+
+    bool NeedsUndoData() const override { return true; }
+
+    bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+public:
+    /// Constructs the index, which becomes available to be queried. The
+    /// entries of new blocks are kept in up to n_write_cache_size bytes of
+    /// memory until the index is committed.
+    explicit SpentIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, size_t n_write_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~SpentIndex() override;
+
+    /// Look up the input spending an output. Returns false if the output is
+    /// not indexed as spent.
+    bool ReadSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value) const;
+
+    /// Look up the inputs spending several outputs. The outputs are visited
+    /// in key order with a single iterator, and values gets an entry per
+    /// key, in the order of keys, that is empty if the output is not spent.
+    bool ReadSpentIndex(const std::vector<CSpentIndexKey>& keys, std::vector<std::optional<CSpentIndexValue>>& values) const;
+};
+
+/// The global spent index, used by the getspentinfo RPC. May be null.
+extern std::unique_ptr<SpentIndex> g_spent_index;
+
+#endif // BITCOIN_INDEX_SPENTINDEX_H
@@ -0,0 +1,76 @@
+// Copyright (c) 2023 The Sugarchain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/timestampindex.h>
+
+#include <chain.h>
+#include <logging.h>
+#include <validation.h>
+
+#include <algorithm>
+
+std::unique_ptr<TimestampIndex> g_timestamp_index;
+
+TimestampIndex::TimestampIndex(ChainstateManager& chainman)
+    : m_chainman{chainman} {}
+
+void TimestampIndex::Start()
+{
+    {
+        LOCK2(cs_main, m_mutex);
+        const CChain& active_chain{m_chainman.ActiveChain()};
+        for (const auto& [_, block_index] : m_chainman.BlockIndex()) {
+            // only blocks that were connected have their scripts validated. Those
+            // invalidated later keep that level, and were listed before too.
+            if ((block_index.nStatus & BLOCK_VALID_MASK) >= BLOCK_VALID_SCRIPTS && !active_chain.Contains(&block_index)) {
+                m_stale_blocks.emplace(block_index.nTime, &block_index);
+            }
+        }
+        LogPrintf("timestampindex is enabled at height %d, with %u stale blocks\n", active_chain.Height(), m_stale_blocks.size());
+    }
+    RegisterValidationInterface(this);
+}
+
+void TimestampIndex::Stop()
+{
+    UnregisterValidationInterface(this);
+}
+
+void TimestampIndex::BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex)
+{
+    LOCK(m_mutex);
+    m_stale_blocks.emplace(pindex->nTime, pindex);
+}
+
+void TimestampIndex::ReadTimestampIndex(unsigned int high, unsigned int low, bool active_only,
+                                        std::vector<const CBlockIndex*>& blocks) const
+{
+    if (high <= low) return;
+
+    LOCK(cs_main);
+    const CChain& active_chain{m_chainman.ActiveChain()};
+    // Every block before the first one whose nTimeMax reaches low is older.
+    // A block is newer than the median time past of its parent, which never
+    // decreases along the chain, so once that reaches high all further
+    // blocks are newer than high.
+    for (const CBlockIndex* pindex = active_chain.FindEarliestAtLeast(low, 0); pindex; pindex = active_chain.Next(pindex)) {
+        if (pindex->nTime >= low && pindex->nTime < high) {
+            blocks.push_back(pindex);
+        }
+        if (pindex->GetMedianTimePast() >= high) break;
+    }
+
+    if (!active_only) {
+        LOCK(m_mutex);
+        for (auto it = m_stale_blocks.lower_bound({low, nullptr}); it != m_stale_blocks.end() && it->first < high; ++it) {
+            // a block that was reconnected is already listed
+            if (!active_chain.Contains(it->second)) {
+                blocks.push_back(it->second);
+            }
+        }
+    }
+
+    // blocks with the same time stay in the order of their height
+    std::stable_sort(blocks.begin(), blocks.end(), [](const CBlockIndex* a, const CBlockIndex* b) { return a->nTime < b->nTime; });
+}
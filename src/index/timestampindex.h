@@ -0,0 +1,59 @@
+// Copyright (c) 2023 The Sugarchain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_TIMESTAMPINDEX_H
+#define BITCOIN_INDEX_TIMESTAMPINDEX_H
+
+#include <sync.h>
+#include <validationinterface.h>
+
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+class CBlockIndex;
+class ChainstateManager;
+
+static constexpr bool DEFAULT_TIMESTAMPINDEX{false};
+
+/**
+ * TimestampIndex looks up blocks by their timestamp, without storing
+ * anything on disk. Blocks of the active chain are found with a binary
+ * search over nTimeMax of the block index. Blocks that were connected and
+ * have left the active chain since are kept in memory, ordered by time.
+ */
+class TimestampIndex final : public CValidationInterface
+{
+private:
+    ChainstateManager& m_chainman;
+
+    mutable Mutex m_mutex;
+    /// Connected blocks that are not on the active chain anymore, by time
+    std::set<std::pair<unsigned int, const CBlockIndex*>> m_stale_blocks GUARDED_BY(m_mutex);
+
+protected:
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override;
+
+public:
+    explicit TimestampIndex(ChainstateManager& chainman);
+
+    /// Collect the stale blocks of the block index and start following the
+    /// active chain.
+    void Start() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /// Stop following the active chain.
+    void Stop();
+
+    /// Look up the blocks with a timestamp from low up to but excluding high,
+    /// ordered by timestamp. With active_only set, blocks that are not on the
+    /// active chain are skipped.
+    void ReadTimestampIndex(unsigned int high, unsigned int low, bool active_only,
+                            std::vector<const CBlockIndex*>& blocks) const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+/// The global timestamp index, used by the getblockhashes RPC. May be null.
+extern std::unique_ptr<TimestampIndex> g_timestamp_index;
+
+#endif // BITCOIN_INDEX_TIMESTAMPINDEX_H
@@ -23,8 +23,11 @@
 #include <hash.h>
 #include <httprpc.h>
 #include <httpserver.h>
+#include <index/addressindex.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
+#include <index/spentindex.h>
+#include <index/timestampindex.h>
 #include <index/txindex.h>
 #include <init/common.h>
 #include <interfaces/chain.h>
@@ -53,8 +56,10 @@
 #include <policy/fees_args.h>
 #include <policy/policy.h>
 #include <policy/settings.h>
+#include <primitives/block.h>
 #include <protocol.h>
 #include <rpc/blockchain.h>
+#include <rpc/mining.h>
 #include <rpc/register.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
@@ -224,6 +229,13 @@ void Interrupt(NodeContext& node)
     if (g_coin_stats_index) {
         g_coin_stats_index->Interrupt();
     }
+    // Sugar: Addressindex
+    if (g_address_index) {
+        g_address_index->Interrupt();
+    }
+    if (g_spent_index) {
+        g_spent_index->Interrupt();
+    }
 }
 
 void Shutdown(NodeContext& node)
@@ -262,6 +274,7 @@ void Shutdown(NodeContext& node)
     if (node.scheduler) node.scheduler->stop();
     if (node.chainman && node.chainman->m_load_block.joinable()) node.chainman->m_load_block.join();
     StopScriptCheckWorkerThreads();
+    StopPoWCheckWorkerThreads();
 
     // After the threads that potentially access these pointers have been stopped,
     // destruct and reset all to nullptr.
@@ -301,6 +314,19 @@ void Shutdown(NodeContext& node)
         g_coin_stats_index->Stop();
         g_coin_stats_index.reset();
     }
+    // Sugar: Addressindex
+    if (g_address_index) {
+        g_address_index->Stop();
+        g_address_index.reset();
+    }
+    if (g_spent_index) {
+        g_spent_index->Stop();
+        g_spent_index.reset();
+    }
+    if (g_timestamp_index) {
+        g_timestamp_index->Stop();
+        g_timestamp_index.reset();
+    }
     ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Stop(); });
     DestroyAllBlockFilterIndexes();
 
@@ -426,11 +452,12 @@ void SetupServerArgs(ArgsManager& argsman)
 
     argsman.AddArg("-addressindex", strprintf("Maintain a full address index, used to query for the balance, txids and unspent outputs for addresses (default: %u)", DEFAULT_ADDRESSINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-spentindex", strprintf("Maintain a full spent index, used to query the spending txid and input index for an outpoint (default: %u)", DEFAULT_SPENTINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
-    argsman.AddArg("-timestampindex", strprintf("Maintain a timestamp index for block hashes, used to query blocks hashes by a range of timestamps (default: %u)", DEFAULT_TIMESTAMPINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-timestampindex", strprintf("Look up block hashes by a range of timestamps, using the block index kept in memory (default: %u)", DEFAULT_TIMESTAMPINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 
 #if HAVE_SYSTEM
     argsman.AddArg("-alertnotify=<cmd>", "Execute command when an alert is raised (%s in cmd is replaced by message)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #endif
+    argsman.AddArg("-assumepow", strprintf("During initial headers sync, match headers up to block %d against its hash instead of verifying their proof of work (default: %u)", defaultChainParams->GetConsensus().nAssumedPoWHeight, DEFAULT_ASSUME_POW), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS); /* YespowerSugar */
     argsman.AddArg("-assumevalid=<hex>", strprintf("If this block is in the chain assume that it and its ancestors are valid and potentially skip their script verification (0 to verify all, default: %s, testnet: %s, signet: %s)", defaultChainParams->GetConsensus().defaultAssumeValid.GetHex(), testnetChainParams->GetConsensus().defaultAssumeValid.GetHex(), signetChainParams->GetConsensus().defaultAssumeValid.GetHex()), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blocksdir=<dir>", "Specify directory to hold blocks subdirectory for *.dat files (default: <datadir>)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-fastprune", "Use smaller block files and lower minimum prune height for testing purposes", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
@@ -450,7 +477,7 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-maxorphantx=<n>", strprintf("Keep at most <n> unconnectable transactions in memory (default: %u)", DEFAULT_MAX_ORPHAN_TRANSACTIONS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-mempoolexpiry=<n>", strprintf("Do not keep transactions in the mempool longer than <n> hours (default: %u)", DEFAULT_MEMPOOL_EXPIRY_HOURS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-minimumchainwork=<hex>", strprintf("Minimum work assumed to exist on a valid chain in hex (default: %s, testnet: %s, signet: %s)", defaultChainParams->GetConsensus().nMinimumChainWork.GetHex(), testnetChainParams->GetConsensus().nMinimumChainWork.GetHex(), signetChainParams->GetConsensus().nMinimumChainWork.GetHex()), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
-    argsman.AddArg("-par=<n>", strprintf("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)",
+    argsman.AddArg("-par=<n>", strprintf("Set the number of script and header proof-of-work verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)",
         -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-persistmempool", strprintf("Whether to save the mempool on shutdown and load on restart (default: %u)", DEFAULT_PERSIST_MEMPOOL), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-pid=<file>", strprintf("Specify pid file. Relative paths will be prefixed by a net-specific datadir location. (default: %s)", BITCOIN_PID_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
@@ -465,6 +492,7 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-shutdownnotify=<cmd>", "Execute command immediately before beginning shutdown. The need for shutdown may be urgent, so be careful not to delay it long (if the command doesn't require interaction with the server, consider having it fork into the background).", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #endif
     argsman.AddArg("-txindex", strprintf("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)", DEFAULT_TXINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-yespowerhugepages", strprintf("Back the memory used for Yespower proof-of-work hashing with huge pages, if the OS has them reserved (default: %u)", DEFAULT_YESPOWER_HUGEPAGES), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS); /* YespowerSugar */
     argsman.AddArg("-blockfilterindex=<type>",
                  strprintf("Maintain an index of compact filters by block (default: %s, values: %s).", DEFAULT_BLOCKFILTERINDEX, ListBlockFilterTypes()) +
                  " If <type> is not supplied or if <type> = 1, indexes for all known types are enabled.",
@@ -537,11 +565,14 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-zmqpubrawblock=<address>", "Enable publish raw block in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawtx=<address>", "Enable publish raw transaction in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubsequence=<address>", "Enable publish hash block and tx sequence in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubaddressdelta=<address>", "Enable publish balance changes of addresses in <address> (requires -addressindex)", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubaddressdeltafilter=<file>", "Only publish balance changes of the addresses listed in <file>, one per line. The list can be replaced with the setzmqaddressfilter RPC", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubhashblockhwm=<n>", strprintf("Set publish hash block outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubhashtxhwm=<n>", strprintf("Set publish hash transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawblockhwm=<n>", strprintf("Set publish raw block outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawtxhwm=<n>", strprintf("Set publish raw transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubsequencehwm=<n>", strprintf("Set publish hash sequence message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubaddressdeltahwm=<n>", strprintf("Set publish address delta outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
 #else
     hidden_args.emplace_back("-zmqpubhashblock=<address>");
     hidden_args.emplace_back("-zmqpubhashtx=<address>");
@@ -553,6 +584,9 @@ void SetupServerArgs(ArgsManager& argsman)
     hidden_args.emplace_back("-zmqpubrawblockhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawtxhwm=<n>");
     hidden_args.emplace_back("-zmqpubsequencehwm=<n>");
+    hidden_args.emplace_back("-zmqpubaddressdelta=<address>");
+    hidden_args.emplace_back("-zmqpubaddressdeltafilter=<file>");
+    hidden_args.emplace_back("-zmqpubaddressdeltahwm=<n>");
 #endif
 
     argsman.AddArg("-checkblocks=<n>", strprintf("How many blocks to check at startup (default: %u, 0 = all)", DEFAULT_CHECKBLOCKS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
@@ -599,6 +633,7 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-blockmaxweight=<n>", strprintf("Set maximum BIP141 block weight (default: %d)", DEFAULT_BLOCK_MAX_WEIGHT), ArgsManager::ALLOW_ANY, OptionsCategory::BLOCK_CREATION);
     argsman.AddArg("-blockmintxfee=<amt>", strprintf("Set lowest fee rate (in %s/kvB) for transactions to be included in block creation. (default: %s)", CURRENCY_UNIT, FormatMoney(DEFAULT_BLOCK_MIN_TX_FEE)), ArgsManager::ALLOW_ANY, OptionsCategory::BLOCK_CREATION);
     argsman.AddArg("-blockversion=<n>", "Override block version to test forking scenarios", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::BLOCK_CREATION);
+    argsman.AddArg("-genproclimit=<n>", strprintf("Number of threads the generate RPCs use to search nonces (0 = all cores, default: %d)", DEFAULT_GENERATE_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::BLOCK_CREATION); /* YespowerSugar */
 
     argsman.AddArg("-rest", strprintf("Accept public REST requests (default: %u)", DEFAULT_REST_ENABLE), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcallowip=<ip>", "Allow JSON-RPC connections from specified source. Valid for <ip> are a single IP (e.g. 1.2.3.4), a network/netmask (e.g. 1.2.3.4/255.255.255.0) or a network/CIDR (e.g. 1.2.3.4/24). This option can be specified multiple times", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
@@ -918,22 +953,12 @@ bool AppInitParameterInteraction(const ArgsManager& args, bool use_syscall_sandb
 
         if (gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)) {
             return InitError(_("Prune mode is incompatible with -addressindex.")); }
-        if (gArgs.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX)) {
-            return InitError(_("Prune mode is incompatible with -timestampindex.")); }
         if (gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX)) {
             return InitError(_("Prune mode is incompatible with -spentindex.")); }
     }
-
-    // Make sure additional indexes are recalculated correctly in VerifyDB
-    // (we must reconnect blocks whenever we disconnect them for these indexes to work)
-    bool fAdditionalIndexes =
-        args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) ||
-        args.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) ||
-        args.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
-
-    if (fAdditionalIndexes && args.GetIntArg("-checklevel", DEFAULT_CHECKLEVEL) < 4) {
-        gArgs.ForceSetArg("-checklevel", "4");
-        LogPrintf("%s: parameter interaction: additional indexes -> setting -checklevel=4\n", __func__);
+    // the mempool balance changes are taken from the mempool address index
+    if (args.IsArgSet("-zmqpubaddressdelta") && !args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)) {
+        return InitError(_("-zmqpubaddressdelta requires -addressindex."));
     }
 
     // If -forcednsseed is set to true, ensure -dnsseed has not been set to false
@@ -1177,6 +1202,20 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
     LogPrintf("Script verification uses %d additional threads\n", script_threads);
     if (script_threads >= 1) {
         StartScriptCheckWorkerThreads(script_threads);
+        // Header PoW checks run outside block connection, so they get their own pool of the same size
+        StartPoWCheckWorkerThreads(script_threads);
+    }
+
+    /* YespowerSugar */
+    // Every PoW hash borrows a Yespower region from a shared pool. Size it for all
+    // PoW workers plus the thread handing out a header batch (or for all cores
+    // mining), plus one so RPC and block loading do not wait behind them.
+    const size_t yespower_regions = std::max(script_threads + 1, GetNumCores()) + 1;
+    const bool yespower_hugepages = args.GetBoolArg("-yespowerhugepages", DEFAULT_YESPOWER_HUGEPAGES);
+    const size_t hugepage_regions = InitPoWHashRegions(yespower_regions, yespower_hugepages);
+    LogPrintf("Pre-allocated %u Yespower regions, %u of them on huge pages\n", yespower_regions, hugepage_regions);
+    if (yespower_hugepages && hugepage_regions < yespower_regions) {
+        LogPrintf("Warning: not enough huge pages for -yespowerhugepages; reserve more with vm.nr_hugepages\n");
     }
 
     assert(!node.scheduler);
@@ -1312,6 +1351,7 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
         "-zmqpubrawblock",
         "-zmqpubrawtx",
         "-zmqpubsequence",
+        "-zmqpubaddressdelta",
     }) {
         for (const std::string& socket_addr : args.GetArgs(port_option)) {
             std::string host_out;
@@ -1453,9 +1493,18 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
     }
 
 #if ENABLE_ZMQ
-    g_zmq_notification_interface = CZMQNotificationInterface::Create();
+    g_zmq_notification_interface = CZMQNotificationInterface::Create(
+        [&node](const uint256& txhash, std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta>>& entries) {
+            return node.mempool && node.mempool->getAddressIndex(txhash, entries);
+        });
 
     if (g_zmq_notification_interface) {
+        if (args.IsArgSet("-zmqpubaddressdeltafilter")) {
+            std::string error;
+            if (!g_zmq_notification_interface->LoadAddressFilter(args.GetPathArg("-zmqpubaddressdeltafilter"), error)) {
+                return InitError(Untranslated(error));
+            }
+        }
         RegisterValidationInterface(g_zmq_notification_interface);
     }
 #endif
@@ -1482,6 +1531,14 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
     if (args.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
         LogPrintf("* Using %.1f MiB for transaction index database\n", cache_sizes.tx_index * (1.0 / 1024 / 1024));
     }
+    if (args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)) {
+        LogPrintf("* Using %.1f MiB for address index database\n", cache_sizes.address_index * (1.0 / 1024 / 1024));
+        LogPrintf("* Using %.1f MiB for address index write cache\n", cache_sizes.index_write_cache * (1.0 / 1024 / 1024));
+    }
+    if (args.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX)) {
+        LogPrintf("* Using %.1f MiB for spent index database\n", cache_sizes.spent_index * (1.0 / 1024 / 1024));
+        LogPrintf("* Using %.1f MiB for spent index write cache\n", cache_sizes.index_write_cache * (1.0 / 1024 / 1024));
+    }
     for (BlockFilterType filter_type : g_enabled_filter_types) {
         LogPrintf("* Using %.1f MiB for %s block filter index database\n",
                   cache_sizes.filter_index * (1.0 / 1024 / 1024), BlockFilterTypeName(filter_type));
@@ -1527,11 +1584,6 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
                 "", CClientUIInterface::MSG_ERROR);
         };
 
-        // Sugar: Addressindex
-        options.addressindex = args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
-        options.spentindex = args.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX);
-        options.timestampindex = args.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
-
         uiInterface.InitMessage(_("Loading block index…").translated);
         const auto load_block_index_start_time{SteadyClock::now()};
         auto catch_exceptions = [](auto&& f) {
@@ -1621,6 +1673,48 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
         }
     }
 
+    // Sugar: Addressindex
+    if (const auto warning{WITH_LOCK(cs_main, return CheckLegacyAddressIndex(*Assert(chainman.m_blockman.m_block_tree_db)))}) {
+        InitWarning(*warning);
+    }
+
+    if (args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)) {
+        g_address_index = std::make_unique<AddressIndex>(interfaces::MakeChain(node), cache_sizes.address_index, cache_sizes.index_write_cache, false, fReindex);
+#if ENABLE_ZMQ
+        // the ZMQ interface is deleted only after the index is stopped
+        if (g_zmq_notification_interface) {
+            g_address_index->SetBlockDeltasNotifier([](const uint256& block_hash, bool connected, const AddressIndex::BalanceDeltas& deltas) {
+                g_zmq_notification_interface->NotifyBlockAddressDeltas(block_hash, connected, deltas);
+            });
+        }
+#endif
+        if (!g_address_index->Start()) {
+            return false;
+        }
+        fAddressIndex = true;
+    }
+
+    if (args.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX)) {
+        g_spent_index = std::make_unique<SpentIndex>(interfaces::MakeChain(node), cache_sizes.spent_index, cache_sizes.index_write_cache, false, fReindex);
+        if (!g_spent_index->Start()) {
+            return false;
+        }
+        fSpentIndex = true;
+    }
+
+    if (args.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX)) {
+        g_timestamp_index = std::make_unique<TimestampIndex>(chainman);
+        g_timestamp_index->Start();
+    }
+    // The timestamp index is served from the block index now
+    const fs::path legacy_timestamp_index{args.GetDataDirNet() / "indexes" / "timestampindex"};
+    std::error_code ec;
+    if (fs::remove_all(legacy_timestamp_index, ec) > 0 && !ec) {
+        LogPrintf("Removed the database of the timestamp index, which is not used anymore\n");
+    } else if (ec) {
+        LogPrintf("Warning: Unable to remove the old timestamp index database %s: %s\n", fs::PathToString(legacy_timestamp_index), ec.message());
+    }
+
     // ********************************************************* Step 9: load wallet
     for (const auto& client : node.chain_clients) {
         if (!client->load()) {
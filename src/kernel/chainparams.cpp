@@ -123,6 +123,8 @@ public:
 
         consensus.nMinimumChainWork = uint256S("0x00000000000000000000000000000000000000000000000000003f23ef34da28"); // getblockhash 6513497 && "chainwork"
         consensus.defaultAssumeValid = uint256S("0x855f0c66238bc0246c8ca25cf958283fd49b9fb4b217ddeb518e5ea9f5071b9e"); // getblockhash 6513497 && "hash"
+        consensus.nAssumedPoWHeight = 6513497; // YespowerSugar
+        consensus.hashAssumedPoW = uint256S("0x855f0c66238bc0246c8ca25cf958283fd49b9fb4b217ddeb518e5ea9f5071b9e"); // getblockhash 6513497
 
         /**
          * The message start string is designed to be unlikely to occur in normal data.
@@ -238,6 +240,8 @@ public:
 
         consensus.nMinimumChainWork = uint256S("0x000000000000000000000000000000000000000000000000000000014d9bf048"); // getblockhash 4000000 && "chainwork" (testnet)
         consensus.defaultAssumeValid = uint256S("0xbc05c2d5e81785f287cd58a798b64467cff35c8ef2bbe8062d8420eeb86f4056"); // getblockhash 4000000 && "hash" (testnet)
+        consensus.nAssumedPoWHeight = 4000000; // YespowerSugar
+        consensus.hashAssumedPoW = uint256S("0xbc05c2d5e81785f287cd58a798b64467cff35c8ef2bbe8062d8420eeb86f4056"); // getblockhash 4000000 (testnet)
 
         pchMessageStart[0] = 0xb0;
         pchMessageStart[1] = 0x11;
@@ -317,6 +321,8 @@ public:
 
             consensus.nMinimumChainWork = uint256S(""); // TODO: signet not launched yet
             consensus.defaultAssumeValid = uint256S(""); // TODO: signet not launched yet
+            consensus.nAssumedPoWHeight = 0; // TODO: signet not launched yet
+            consensus.hashAssumedPoW = uint256{}; // TODO: signet not launched yet
             m_assumed_blockchain_size = 0; // TODO: signet not launched yet
             m_assumed_chain_state_size = 0; // TODO: signet not launched yet
             chainTxData = ChainTxData{ // TODO: signet not launched yet
@@ -329,6 +335,8 @@ public:
             bin = *options.challenge;
             consensus.nMinimumChainWork = uint256{}; // a new signet clean
             consensus.defaultAssumeValid = uint256{}; // a new signet clean
+            consensus.nAssumedPoWHeight = 0; // a new signet clean
+            consensus.hashAssumedPoW = uint256{}; // a new signet clean
             m_assumed_blockchain_size = 0; // a new signet clean
             m_assumed_chain_state_size = 0; // a new signet clean
             chainTxData = ChainTxData{ // a new signet clean
@@ -473,6 +481,8 @@ public:
 
         consensus.nMinimumChainWork = uint256{}; // regtest clean
         consensus.defaultAssumeValid = uint256{}; // regtest clean
+        consensus.nAssumedPoWHeight = 0; // regtest clean
+        consensus.hashAssumedPoW = uint256{}; // regtest clean
 
         pchMessageStart[0] = 0xaf;
         pchMessageStart[1] = 0xfb;
@@ -18,6 +18,7 @@
 class CChainParams;
 
 static constexpr bool DEFAULT_CHECKPOINTS_ENABLED{true};
+static constexpr bool DEFAULT_ASSUME_POW{true}; /* YespowerSugar */
 static constexpr auto DEFAULT_MAX_TIP_AGE{24h};
 
 namespace kernel {
@@ -33,6 +34,8 @@ struct ChainstateManagerOpts {
     const std::function<NodeClock::time_point()> adjusted_time_callback{nullptr};
     std::optional<bool> check_block_index{};
     bool checkpoints_enabled{DEFAULT_CHECKPOINTS_ENABLED};
+    //! Whether initial headers sync matches headers below the chain params' assumed-PoW header by hash instead of checking their proof of work.
+    bool assume_pow{DEFAULT_ASSUME_POW}; /* YespowerSugar */
     //! If set, it will override the minimum work we will assume exists on some valid chain.
     std::optional<arith_uint256> minimum_chain_work{};
     //! If set, it will override the block hash whose ancestors we will assume to have valid scripts without checking them.
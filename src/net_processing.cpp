@@ -50,6 +50,7 @@
 #include <memory>
 #include <optional>
 #include <typeinfo>
+#include <utility>
 
 using node::ReadBlockFromDisk;
 using node::ReadRawBlockFromDisk;
@@ -379,6 +380,11 @@ struct Peer {
     /** Time of the last getheaders message to this peer */
     NodeClock::time_point m_last_getheaders_timestamp GUARDED_BY(NetEventsInterface::g_msgproc_mutex){};
 
+    /* YespowerSugar */
+    /** Last header of the batch our outstanding pipelined getheaders continues
+     *  from, if that batch was not verified yet when the request was sent */
+    uint256 m_headers_pipelined_from GUARDED_BY(NetEventsInterface::g_msgproc_mutex){};
+
     /** Protects m_headers_sync **/
     Mutex m_headers_sync_mutex;
     /** Headers-sync state for this peer (eg for initial sync, or syncing large
@@ -609,8 +615,9 @@ private:
                                bool via_compact_block)
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_headers_presync_mutex, g_msgproc_mutex);
     /** Various helpers for headers processing, invoked by ProcessHeadersMessage() */
-    /** Return true if headers are continuous and have valid proof-of-work (DoS points assigned on failure) */
-    bool CheckHeadersPoW(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams, Peer& peer);
+    /** Return true if headers are continuous and have valid proof-of-work (DoS points assigned on failure).
+     *  The proof of work of the first assumed_pow headers is not checked (see HeadersSyncState::CountAssumedPoWHeaders()). */
+    bool CheckHeadersPoW(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams, Peer& peer, size_t assumed_pow = 0);
     /** Calculate an anti-DoS work threshold for headers chains */
     arith_uint256 GetAntiDoSWorkThreshold();
     /** Deal with state tracking and headers sync for peers that send the
@@ -665,6 +672,13 @@ private:
      * This returns true if a getheaders is actually sent, and false otherwise.
      */
     bool MaybeSendGetHeaders(CNode& pfrom, const CBlockLocator& locator, Peer& peer) EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex);
+    /** Request the headers following a full headers message before verifying
+     *  it, so the round trip overlaps with its proof-of-work checks. Only done
+     *  when the message will be processed directly (no low-work headers sync).
+     *  This returns true if a getheaders is actually sent, and false otherwise.
+     */
+    bool MaybePipelineGetHeaders(CNode& pfrom, const std::vector<CBlockHeader>& headers, Peer& peer)
+        EXCLUSIVE_LOCKS_REQUIRED(!peer.m_headers_sync_mutex, g_msgproc_mutex); /* YespowerSugar */
     /** Potentially fetch blocks from this peer upon receipt of a new headers tip */
     void HeadersDirectFetchBlocks(CNode& pfrom, const Peer& peer, const CBlockIndex& last_header);
     /** Update peer state based on received headers message */
@@ -2434,10 +2448,14 @@ void PeerManagerImpl::SendBlockTransactions(CNode& pfrom, Peer& peer, const CBlo
     m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::BLOCKTXN, resp));
 }
 
-bool PeerManagerImpl::CheckHeadersPoW(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams, Peer& peer)
+bool PeerManagerImpl::CheckHeadersPoW(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams, Peer& peer, size_t assumed_pow)
 {
+    /* YespowerSugar */
+    std::vector<CBlockHeader> unassumed;
+    if (assumed_pow > 0) unassumed.assign(headers.begin() + std::min(assumed_pow, headers.size()), headers.end());
+
     // Do these headers have proof-of-work matching what's claimed?
-    if (!HasValidProofOfWork(headers, consensusParams)) {
+    if (!HasValidProofOfWork(assumed_pow > 0 ? unassumed : headers, consensusParams)) {
         Misbehaving(peer, 100, "header with invalid proof of work");
         return false;
     }
@@ -2626,7 +2644,7 @@ bool PeerManagerImpl::TryLowWorkHeadersSync(Peer& peer, CNode& pfrom, const CBlo
             // advancing to the first unknown header would be a small effect.
             LOCK(peer.m_headers_sync_mutex);
             peer.m_headers_sync.reset(new HeadersSyncState(peer.m_id, m_chainparams.GetConsensus(),
-                chain_start_header, minimum_chain_work));
+                chain_start_header, minimum_chain_work, m_chainman.m_options.assume_pow));
 
             // Now a HeadersSyncState object for tracking this synchronization
             // is created, process the headers using it as normal. Failures are
@@ -2673,6 +2691,37 @@ bool PeerManagerImpl::MaybeSendGetHeaders(CNode& pfrom, const CBlockLocator& loc
     return false;
 }
 
+/* YespowerSugar */
+bool PeerManagerImpl::MaybePipelineGetHeaders(CNode& pfrom, const std::vector<CBlockHeader>& headers, Peer& peer)
+{
+    // Only a full headers message means the peer may have more headers, and a
+    // low-work headers sync requests its own headers.
+    if (headers.size() != MAX_HEADERS_RESULTS) return false;
+    if (WITH_LOCK(peer.m_headers_sync_mutex, return peer.m_headers_sync != nullptr)) return false;
+
+    const CBlockIndex* chain_start_header{WITH_LOCK(::cs_main, return m_chainman.m_blockman.LookupBlockIndex(headers[0].hashPrevBlock))};
+    if (chain_start_header == nullptr) return false;
+
+    // Leave headers that would start a low-work headers sync to the regular
+    // path (see TryLowWorkHeadersSync()). The claimed work is not verified
+    // yet, but if it is fake the peer is punished once it is.
+    if (!pfrom.HasPermission(NetPermissionFlags::NoBan) &&
+        chain_start_header->nChainWork + CalculateHeadersWork(headers) < GetAntiDoSWorkThreshold()) {
+        return false;
+    }
+
+    // The last header isn't in our block index yet, so put it in front of the
+    // locator of the header the batch builds on.
+    CBlockLocator locator{GetLocator(chain_start_header)};
+    locator.vHave.insert(locator.vHave.begin(), headers.back().GetHash());
+    if (!MaybeSendGetHeaders(pfrom, locator, peer)) return false;
+
+    peer.m_headers_pipelined_from = headers.back().GetHash();
+    LogPrint(BCLog::NET, "pipelined getheaders (%d) to end to peer=%d (startheight:%d)\n",
+             chain_start_header->nHeight + headers.size(), pfrom.GetId(), peer.m_starting_height);
+    return true;
+}
+
 /*
  * Given a new headers tip ending in last_header, potentially request blocks towards that tip.
  * We require that the given tip have at least as much work as our tip, and for
@@ -2807,6 +2856,11 @@ void PeerManagerImpl::ProcessHeadersMessage(CNode& pfrom, Peer& peer,
 {
     size_t nCount = headers.size();
 
+    /* YespowerSugar */
+    // Whether we already asked for the headers following a batch we hadn't
+    // verified yet (see MaybePipelineGetHeaders())
+    const uint256 pipelined_from{std::exchange(peer.m_headers_pipelined_from, uint256{})};
+
     if (nCount == 0) {
         // Nothing interesting. Stop asking this peers for more headers.
         // If we were in the middle of headers sync, receiving an empty headers
@@ -2821,11 +2875,27 @@ void PeerManagerImpl::ProcessHeadersMessage(CNode& pfrom, Peer& peer,
         return;
     }
 
+    /* YespowerSugar */
+    // Checking a full headers message costs thousands of Yespower hashes, so
+    // ask for the next one first and verify this one while it is in flight.
+    // If this one turns out invalid, the response won't connect and is
+    // dropped below.
+    MaybePipelineGetHeaders(pfrom, headers, peer);
+
+    /* YespowerSugar */
+    // Headers continuing a headers sync up to the assumed-PoW header are
+    // matched against it by hash there, instead of by proof of work.
+    size_t assumed_pow{0};
+    {
+        LOCK(peer.m_headers_sync_mutex);
+        if (peer.m_headers_sync) assumed_pow = peer.m_headers_sync->CountAssumedPoWHeaders(headers);
+    }
+
     // Before we do any processing, make sure these pass basic sanity checks.
     // We'll rely on headers having valid proof-of-work further down, as an
     // anti-DoS criteria (note: this check is required before passing any
     // headers into HeadersSyncState).
-    if (!CheckHeadersPoW(headers, m_chainparams.GetConsensus(), peer)) {
+    if (!CheckHeadersPoW(headers, m_chainparams.GetConsensus(), peer, assumed_pow)) {
         // Misbehaving() calls are handled within CheckHeadersPoW(), so we can
         // just return. (Note that even if a header is announced via compact
         // block, the header itself should be valid, so this type of error can
@@ -2866,11 +2936,24 @@ void PeerManagerImpl::ProcessHeadersMessage(CNode& pfrom, Peer& peer,
         have_headers_sync = !!peer.m_headers_sync;
     }
 
+    /* YespowerSugar */
+    // If the headers sync rejected headers we skipped the proof of work of,
+    // they are back in our hands unverified; check them fully before going on.
+    if (assumed_pow > 0 && !already_validated_work && !CheckHeadersPoW(headers, m_chainparams.GetConsensus(), peer)) {
+        return;
+    }
+
     // Do these headers connect to something in our block index?
     const CBlockIndex *chain_start_header{WITH_LOCK(::cs_main, return m_chainman.m_blockman.LookupBlockIndex(headers[0].hashPrevBlock))};
     bool headers_connect_blockindex{chain_start_header != nullptr};
 
     if (!headers_connect_blockindex) {
+        /* YespowerSugar */
+        if (!pipelined_from.IsNull() && headers[0].hashPrevBlock == pipelined_from) {
+            // We requested these before the batch they build on was rejected
+            LogPrint(BCLog::NET, "ignoring headers following a rejected batch from peer=%d\n", pfrom.GetId());
+            return;
+        }
         if (nCount <= MAX_BLOCKS_TO_ANNOUNCE) {
             // If this looks like it could be a BIP 130 block announcement, use
             // special logic for handling headers that don't connect, as this
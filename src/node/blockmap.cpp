@@ -0,0 +1,74 @@
+// Copyright (c) 2023 The Sugarchain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockmap.h>
+
+#include <crypto/siphash.h>
+#include <random.h>
+
+#include <cassert>
+#include <limits>
+
+namespace node {
+BlockMap::BlockMap()
+    : m_k0{GetRand<uint64_t>()},
+      m_k1{GetRand<uint64_t>()} {}
+
+BlockMap::~BlockMap()
+{
+    for (size_t pos = 0; pos < m_size; ++pos) {
+        Entry(pos).~value_type();
+    }
+    for (value_type* chunk : m_chunks) {
+        std::allocator<value_type>{}.deallocate(chunk, CHUNK_SIZE);
+    }
+}
+
+uint64_t BlockMap::Key(const uint256& hash) const
+{
+    return SipHashUint256(m_k0, m_k1, hash);
+}
+
+size_t BlockMap::Find(const uint256& hash, uint64_t key) const
+{
+    if (m_slots.empty()) return m_size;
+    const size_t mask{m_slots.size() - 1};
+    for (size_t i = key & mask; m_slots[i].pos != 0; i = (i + 1) & mask) {
+        if (m_slots[i].key == key && Entry(m_slots[i].pos - 1).first == hash) {
+            return m_slots[i].pos - 1;
+        }
+    }
+    return m_size;
+}
+
+void BlockMap::InsertSlot(uint64_t key, size_t pos)
+{
+    assert(pos < std::numeric_limits<uint32_t>::max());
+    const size_t mask{m_slots.size() - 1};
+    size_t i{key & mask};
+    while (m_slots[i].pos != 0) {
+        i = (i + 1) & mask;
+    }
+    m_slots[i] = {key, uint32_t(pos + 1)};
+}
+
+void BlockMap::Rehash(size_t slot_count)
+{
+    std::vector<Slot> old_slots(slot_count, Slot{0, 0});
+    old_slots.swap(m_slots);
+    // The keys are kept in the table, so no block hash is hashed again
+    for (const Slot& slot : old_slots) {
+        if (slot.pos != 0) InsertSlot(slot.key, slot.pos - 1);
+    }
+}
+
+void BlockMap::reserve(size_t count)
+{
+    size_t slot_count{MIN_SLOTS};
+    while (count * MAX_LOAD_DEN > slot_count * MAX_LOAD_NUM) {
+        slot_count *= 2;
+    }
+    if (slot_count > m_slots.size()) Rehash(slot_count);
+}
+} // namespace node
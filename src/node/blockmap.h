@@ -0,0 +1,145 @@
+// Copyright (c) 2023 The Sugarchain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKMAP_H
+#define BITCOIN_NODE_BLOCKMAP_H
+
+#include <chain.h>
+#include <uint256.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace node {
+/**
+ * Map from block hash to the block's CBlockIndex.
+ *
+ * Validation code holds pointers to the entries everywhere, so entries are
+ * stored inline in fixed-size chunks that are never moved or freed while the
+ * map exists. Lookups go through a linearly probed open-addressing table of
+ * 64-bit salted keys, and a key match is confirmed against the entry's full
+ * hash, which is what CBlockIndex::phashBlock points to.
+ *
+ * Only the std::unordered_map interface the block index uses is provided.
+ * Entries cannot be erased, and iteration is in insertion order.
+ */
+class BlockMap
+{
+public:
+    using key_type = uint256;
+    using mapped_type = CBlockIndex;
+    using value_type = std::pair<const uint256, CBlockIndex>;
+
+    template <bool is_const>
+    class Iterator
+    {
+        using Map = std::conditional_t<is_const, const BlockMap, BlockMap>;
+        Map* m_map{nullptr};
+        size_t m_pos{0};
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = BlockMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<is_const, const value_type*, value_type*>;
+        using reference = std::conditional_t<is_const, const value_type&, value_type&>;
+
+        Iterator() = default;
+        Iterator(Map* map, size_t pos) : m_map{map}, m_pos{pos} {}
+        //! Allow conversion from iterator to const_iterator
+        template <bool other_const, typename = std::enable_if_t<is_const && !other_const>>
+        Iterator(const Iterator<other_const>& other) : m_map{other.m_map}, m_pos{other.m_pos} {}
+
+        reference operator*() const { return m_map->Entry(m_pos); }
+        pointer operator->() const { return &m_map->Entry(m_pos); }
+        Iterator& operator++() { ++m_pos; return *this; }
+        Iterator operator++(int) { Iterator copy{*this}; ++m_pos; return copy; }
+        friend bool operator==(const Iterator& a, const Iterator& b) { return a.m_pos == b.m_pos; }
+        friend bool operator!=(const Iterator& a, const Iterator& b) { return a.m_pos != b.m_pos; }
+
+        friend class Iterator<!is_const>;
+    };
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    BlockMap();
+    ~BlockMap();
+    BlockMap(const BlockMap&) = delete;
+    BlockMap& operator=(const BlockMap&) = delete;
+
+    iterator begin() { return {this, 0}; }
+    iterator end() { return {this, m_size}; }
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, m_size}; }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    //! Size the table for count entries, so inserting that many does not rehash
+    void reserve(size_t count);
+
+    iterator find(const uint256& hash) { return {this, Find(hash)}; }
+    const_iterator find(const uint256& hash) const { return {this, Find(hash)}; }
+    size_t count(const uint256& hash) const { return Find(hash) != m_size; }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const uint256& hash, Args&&... args)
+    {
+        const uint64_t key{Key(hash)};
+        const size_t pos{Find(hash, key)};
+        if (pos != m_size) return {{this, pos}, false};
+
+        if (m_chunks.size() * CHUNK_SIZE == m_size) {
+            m_chunks.push_back(std::allocator<value_type>{}.allocate(CHUNK_SIZE));
+        }
+        new (&Entry(m_size)) value_type(std::piecewise_construct, std::forward_as_tuple(hash), std::forward_as_tuple(std::forward<Args>(args)...));
+        if ((m_size + 1) * MAX_LOAD_DEN > m_slots.size() * MAX_LOAD_NUM) {
+            Rehash(std::max<size_t>(m_slots.size() * 2, MIN_SLOTS));
+        }
+        InsertSlot(key, m_size);
+        return {{this, m_size++}, true};
+    }
+
+    CBlockIndex& operator[](const uint256& hash) { return try_emplace(hash).first->second; }
+
+private:
+    //! Entries per chunk of storage
+    static constexpr size_t CHUNK_SIZE{4096};
+    //! Smallest table size, a power of two like all table sizes
+    static constexpr size_t MIN_SLOTS{1024};
+    //! The table is grown once more than 3/4 of its slots are used
+    static constexpr size_t MAX_LOAD_NUM{3};
+    static constexpr size_t MAX_LOAD_DEN{4};
+
+    struct Slot {
+        //! Salted hash of the block hash
+        uint64_t key;
+        //! Position of the entry plus one, or 0 for an empty slot
+        uint32_t pos;
+    };
+
+    std::vector<value_type*> m_chunks;
+    std::vector<Slot> m_slots;
+    size_t m_size{0};
+    //! Salt for the keys in m_slots
+    const uint64_t m_k0, m_k1;
+
+    uint64_t Key(const uint256& hash) const;
+    value_type& Entry(size_t pos) const { return m_chunks[pos / CHUNK_SIZE][pos % CHUNK_SIZE]; }
+    //! Position of the entry for hash, or m_size if there is none
+    size_t Find(const uint256& hash) const { return Find(hash, Key(hash)); }
+    size_t Find(const uint256& hash, uint64_t key) const;
+    void InsertSlot(uint64_t key, size_t pos);
+    void Rehash(size_t slot_count);
+};
+} // namespace node
+
+#endif // BITCOIN_NODE_BLOCKMAP_H
@@ -20,9 +20,12 @@
 #include <util/fs.h>
 #include <util/syscall_sandbox.h>
 #include <util/system.h>
+#include <util/threadnames.h>
 #include <validation.h>
 
+#include <atomic>
 #include <map>
+#include <thread>
 #include <unordered_map>
 
 namespace node {
@@ -105,6 +108,7 @@ CBlockIndex* BlockManager::AddToBlockIndex(const CBlockHeader& block, CBlockInde
     }
     pindexNew->nTimeMax = (pindexNew->pprev ? std::max(pindexNew->pprev->nTimeMax, pindexNew->nTime) : pindexNew->nTime);
     pindexNew->nChainWork = (pindexNew->pprev ? pindexNew->pprev->nChainWork : 0) + GetBlockProof(*pindexNew);
+    pindexNew->nChainTargetSum = (pindexNew->pprev ? pindexNew->pprev->nChainTargetSum : 0) + GetBlockTarget(*pindexNew); /* SugarShield */
     pindexNew->RaiseValidity(BLOCK_VALID_TREE);
     if (best_header == nullptr || best_header->nChainWork < pindexNew->nChainWork) {
         best_header = pindexNew;
@@ -239,7 +243,11 @@ void BlockManager::UpdatePruneLock(const std::string& name, const PruneLockInfo&
 CBlockIndex* BlockManager::InsertBlockIndex(const uint256& hash)
 {
     AssertLockHeld(cs_main);
+    return InsertBlockIndexFromLoader(hash);
+}
 
+CBlockIndex* BlockManager::InsertBlockIndexFromLoader(const uint256& hash)
+{
     if (hash.IsNull()) {
         return nullptr;
     }
@@ -252,20 +260,83 @@ CBlockIndex* BlockManager::InsertBlockIndex(const uint256& hash)
     return pindex;
 }
 
+/** Call fn(begin, end) on about equal slices of [0, size), each on its own thread. */
+template <typename Fn>
+static void ForEachSlice(size_t size, int num_threads, const Fn& fn)
+{
+    std::vector<std::thread> threads;
+    for (int n = 1; n < num_threads; ++n) {
+        threads.emplace_back([&fn, size, num_threads, n] {
+            util::ThreadRename(strprintf("loadblkidx.%i", n));
+            fn(size * n / num_threads, size * (n + 1) / num_threads);
+        });
+    }
+    fn(0, size / num_threads);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
 bool BlockManager::LoadBlockIndex(const Consensus::Params& consensus_params)
 {
-    if (!m_block_tree_db->LoadBlockIndexGuts(consensus_params, [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); })) {
+    const int num_threads{std::max(GetNumCores(), 1)};
+    // Most entries come from the flat file, so size the map for those up front
+    m_block_index.reserve(m_block_tree_db->ReadFlatBlockIndexSize());
+    if (!m_block_tree_db->LoadBlockIndexGuts(consensus_params, [this](const uint256& hash) { return this->InsertBlockIndexFromLoader(hash); }, num_threads)) {
         return false;
     }
 
-    // Calculate nChainWork
-    std::vector<CBlockIndex*> vSortedByHeight{GetAllBlockIndices()};
-    std::sort(vSortedByHeight.begin(), vSortedByHeight.end(),
-              CBlockIndexHeightOnlyComparator());
+    // Store each block's own work and target in nChainWork and nChainTargetSum,
+    // and check that every block is one above its parent and every root is at
+    // height 0.
+    std::vector<CBlockIndex*> all_blocks{GetAllBlockIndices()};
+    std::atomic<bool> heights_linked{true};
+    std::atomic<int> max_height{0};
+    ForEachSlice(all_blocks.size(), num_threads, [&](size_t begin, size_t end) {
+        int slice_max_height{0};
+        for (size_t i = begin; i < end; ++i) {
+            CBlockIndex* pindex{all_blocks[i]};
+            pindex->nChainWork = GetBlockProof(*pindex);
+            pindex->nChainTargetSum = GetBlockTarget(*pindex); /* SugarShield */
+            if (pindex->nHeight != (pindex->pprev ? pindex->pprev->nHeight + 1 : 0)) heights_linked = false;
+            slice_max_height = std::max(slice_max_height, pindex->nHeight);
+        }
+        int prev_max_height{max_height.load()};
+        while (prev_max_height < slice_max_height && !max_height.compare_exchange_weak(prev_max_height, slice_max_height)) {}
+    });
+
+    // Sort by height. With linked heights every height up to the maximum has a
+    // block, so a counting sort applies; height_start[h] is the position of the
+    // first block at height h.
+    std::vector<CBlockIndex*> vSortedByHeight;
+    std::vector<size_t> height_start;
+    if (heights_linked) {
+        height_start.assign(max_height + 2, 0);
+        for (const CBlockIndex* pindex : all_blocks) {
+            ++height_start[pindex->nHeight + 1];
+        }
+        for (size_t height = 1; height < height_start.size(); ++height) {
+            height_start[height] += height_start[height - 1];
+        }
+        vSortedByHeight.resize(all_blocks.size());
+        std::vector<size_t> next_pos(height_start.begin(), height_start.end() - 1);
+        for (CBlockIndex* pindex : all_blocks) {
+            vSortedByHeight[next_pos[pindex->nHeight]++] = pindex;
+        }
+    } else {
+        LogPrintf("%s: block index heights are not linked, building skip pointers on one thread\n", __func__);
+        vSortedByHeight = std::move(all_blocks);
+        std::sort(vSortedByHeight.begin(), vSortedByHeight.end(),
+                  CBlockIndexHeightOnlyComparator());
+    }
 
+    // Calculate nChainWork and nChainTargetSum
     for (CBlockIndex* pindex : vSortedByHeight) {
         if (ShutdownRequested()) return false;
-        pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + GetBlockProof(*pindex);
+        if (pindex->pprev) {
+            pindex->nChainWork += pindex->pprev->nChainWork;
+            pindex->nChainTargetSum += pindex->pprev->nChainTargetSum; /* SugarShield */
+        }
         pindex->nTimeMax = (pindex->pprev ? std::max(pindex->pprev->nTimeMax, pindex->nTime) : pindex->nTime);
 
         // We can link the chain of blocks for which we've received transactions at some point, or
@@ -288,7 +359,35 @@ bool BlockManager::LoadBlockIndex(const Consensus::Params& consensus_params)
             pindex->nStatus |= BLOCK_FAILED_CHILD;
             m_dirty_blockindex.insert(pindex);
         }
-        if (pindex->pprev) {
+        if (!heights_linked && pindex->pprev) {
+            pindex->BuildSkip();
+        }
+    }
+
+    if (heights_linked) {
+        // A block alone at its height is an ancestor of every block above it,
+        // so skip pointers to such blocks need no walk down the chain. Only
+        // blocks skipping to a height with a fork are left to BuildSkip(),
+        // in height order.
+        Mutex forked_mutex;
+        std::vector<CBlockIndex*> forked;
+        ForEachSlice(vSortedByHeight.size(), num_threads, [&](size_t begin, size_t end) {
+            std::vector<CBlockIndex*> slice_forked;
+            for (size_t i = begin; i < end; ++i) {
+                CBlockIndex* pindex{vSortedByHeight[i]};
+                if (!pindex->pprev) continue;
+                const int skip_height{GetSkipHeight(pindex->nHeight)};
+                if (height_start[skip_height + 1] - height_start[skip_height] == 1) {
+                    pindex->pskip = vSortedByHeight[height_start[skip_height]];
+                } else {
+                    slice_forked.push_back(pindex);
+                }
+            }
+            LOCK(forked_mutex);
+            forked.insert(forked.end(), slice_forked.begin(), slice_forked.end());
+        });
+        std::sort(forked.begin(), forked.end(), CBlockIndexHeightOnlyComparator());
+        for (CBlockIndex* pindex : forked) {
             pindex->BuildSkip();
         }
     }
@@ -317,6 +416,31 @@ bool BlockManager::WriteBlockIndexDB()
     return true;
 }
 
+bool BlockManager::WriteFlatBlockIndex(const CChain& active_chain)
+{
+    AssertLockHeld(::cs_main);
+    const int flat_size{m_block_tree_db->FlatBlockIndexSize()};
+    const int end_height{std::min(active_chain.Height() + 1 - BLOCK_INDEX_FLAT_DEPTH, flat_size + MAX_BLOCK_INDEX_FLAT_BATCH)};
+    if (end_height <= flat_size) return true;
+
+    // After a reorg below the end of the flat file, new entries stay in the database
+    const CBlockIndex* first{active_chain[flat_size]};
+    if (first->pprev && first->pprev->GetBlockHash() != m_block_tree_db->FlatBlockIndexTip()) return true;
+
+    std::vector<const CBlockIndex*> blocks;
+    blocks.reserve(end_height - flat_size);
+    for (int height = flat_size; height < end_height; ++height) {
+        blocks.push_back(active_chain[height]);
+    }
+    return m_block_tree_db->WriteFlatBlockIndex(blocks);
+}
+
+bool BlockManager::FlatBlockIndexLags(const CChain& active_chain) const
+{
+    AssertLockHeld(::cs_main);
+    return active_chain.Height() + 1 - BLOCK_INDEX_FLAT_DEPTH - m_block_tree_db->FlatBlockIndexSize() >= MAX_BLOCK_INDEX_FLAT_BATCH;
+}
+
 bool BlockManager::LoadBlockIndexDB(const Consensus::Params& consensus_params)
 {
     if (!LoadBlockIndex(consensus_params)) {
@@ -366,16 +490,6 @@ bool BlockManager::LoadBlockIndexDB(const Consensus::Params& consensus_params)
     m_block_tree_db->ReadReindexing(fReindexing);
     if (fReindexing) fReindex = true;
 
-    // Sugar: Addressindex
-    m_block_tree_db->ReadFlag("addressindex", fAddressIndex);
-    LogPrintf("LoadBlockIndexDB(): address index %s\n", fAddressIndex ? "enabled" : "disabled");
-
-    m_block_tree_db->ReadFlag("timestampindex", fTimestampIndex);
-    LogPrintf("LoadBlockIndexDB(): timestamp index %s\n", fTimestampIndex ? "enabled" : "disabled");
-
-    m_block_tree_db->ReadFlag("spentindex", fSpentIndex);
-    LogPrintf("LoadBlockIndexDB(): spent index %s\n", fSpentIndex ? "enabled" : "disabled");
-
     return true;
 }
 
@@ -748,7 +862,7 @@ bool BlockManager::WriteUndoDataForBlock(const CBlockUndo& blockundo, BlockValid
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams)
+bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams, bool fCheckPOW)
 {
     block.SetNull();
 
@@ -766,7 +880,7 @@ bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::P
     }
 
     // Check the header
-    if (!CheckProofOfWork(block.GetPoWHash_cached(), block.nBits, consensusParams)) {
+    if (fCheckPOW && !CheckProofOfWork(block.GetPoWHash_cached(), block.nBits, consensusParams)) {
         return error("ReadBlockFromDisk: Errors in block header at %s", pos.ToString());
     }
 
@@ -780,9 +894,19 @@ bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::P
 
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
 {
-    const FlatFilePos block_pos{WITH_LOCK(cs_main, return pindex->GetBlockPos())};
+    FlatFilePos block_pos;
+    bool pow_checked;
+    {
+        LOCK(cs_main);
+        block_pos = pindex->GetBlockPos();
+        pow_checked = pindex->IsValid(BLOCK_VALID_TRANSACTIONS);
+    }
 
-    if (!ReadBlockFromDisk(block, block_pos, consensusParams)) {
+    /* YespowerSugar */
+    // A BLOCK_VALID_TRANSACTIONS entry passed CheckBlock, header PoW included,
+    // and that status is persisted in the block index. The hash comparison below
+    // ties the header we read to that entry, so skip the Yespower hash.
+    if (!ReadBlockFromDisk(block, block_pos, consensusParams, /*fCheckPOW=*/!pow_checked)) {
         return false;
     }
     if (block.GetHash() != pindex->GetBlockHash()) {
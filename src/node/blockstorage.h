@@ -9,6 +9,7 @@
 #include <chain.h>
 #include <kernel/blockmanager_opts.h>
 #include <kernel/cs_main.h>
+#include <node/blockmap.h>
 #include <protocol.h>
 #include <sync.h>
 #include <txdb.h>
@@ -47,13 +48,13 @@ static const unsigned int MAX_BLOCKFILE_SIZE = 0x8000000; // 128 MiB
 /** Size of header written by WriteBlockToDisk before a serialized CBlock */
 static constexpr size_t BLOCK_SERIALIZATION_HEADER_SIZE = CMessageHeader::MESSAGE_START_SIZE + sizeof(unsigned int);
 
-extern std::atomic_bool fReindex;
+/** Depth in the active chain (one day of blocks) after which a block's index entry moves to the flat block index file */
+static constexpr int BLOCK_INDEX_FLAT_DEPTH{17280};
+/** Maximum number of entries moved to the flat block index file per flush,
+ *  about 550 KB, so that a flush under cs_main stays short */
+static constexpr int MAX_BLOCK_INDEX_FLAT_BATCH{4096};
 
-// Because validation code takes pointers to the map's CBlockIndex objects, if
-// we ever switch to another associative container, we need to either use a
-// container that has stable addressing (true of all std associative
-// containers), or make the key a `std::unique_ptr<CBlockIndex>`
-using BlockMap = std::unordered_map<uint256, CBlockIndex, BlockHasher>;
+extern std::atomic_bool fReindex;
 
 struct CBlockIndexWorkComparator {
     bool operator()(const CBlockIndex* pa, const CBlockIndex* pb) const;
@@ -162,6 +163,12 @@ public:
     std::unique_ptr<CBlockTreeDB> m_block_tree_db GUARDED_BY(::cs_main);
 
     bool WriteBlockIndexDB() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+    /** Move the entries of active chain blocks at least BLOCK_INDEX_FLAT_DEPTH
+     *  deep from the block tree database to its flat file. */
+    bool WriteFlatBlockIndex(const CChain& active_chain) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+    /** Whether at least MAX_BLOCK_INDEX_FLAT_BATCH entries wait to be moved
+     *  to the flat file, as after an upgrade. */
+    bool FlatBlockIndexLags(const CChain& active_chain) const EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
     bool LoadBlockIndexDB(const Consensus::Params& consensus_params) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
     /**
@@ -174,6 +181,11 @@ public:
     CBlockIndex* AddToBlockIndex(const CBlockHeader& block, CBlockIndex*& best_header) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     /** Create a new block index entry for a given block hash */
     CBlockIndex* InsertBlockIndex(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    /** InsertBlockIndex for the LoadBlockIndexGuts loader threads. These do not
+     *  hold cs_main themselves: the thread that started them holds it until they
+     *  are joined, and the loader serializes the calls with its own mutex. Must
+     *  not be called from anywhere else. */
+    CBlockIndex* InsertBlockIndexFromLoader(const uint256& hash) NO_THREAD_SAFETY_ANALYSIS;
 
     //! Mark one block file as pruned (modify associated database entries)
     void PruneOneBlockFile(const int fileNumber) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
@@ -231,7 +243,8 @@ fs::path GetBlockPosFilename(const FlatFilePos& pos);
 void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune);
 
 /** Functions for disk access for blocks */
-bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams);
+bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams, bool fCheckPOW = true);
+/** Read the block for an index entry. The header's PoW is only recomputed if the entry isn't BLOCK_VALID_TRANSACTIONS yet. */
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
 bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos, const CMessageHeader::MessageStartChars& message_start);
 
@@ -4,6 +4,8 @@
 
 #include <node/caches.h>
 
+#include <index/addressindex.h>
+#include <index/spentindex.h>
 #include <index/txindex.h>
 #include <txdb.h>
 #include <util/system.h>
@@ -19,6 +21,17 @@ CacheSizes CalculateCacheSizes(const ArgsManager& args, size_t n_indexes)
     nTotalCache -= sizes.block_tree_db;
     sizes.tx_index = std::min(nTotalCache / 8, args.GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxTxIndexCache << 20 : 0);
     nTotalCache -= sizes.tx_index;
+    // Sugar: Addressindex
+    const bool address_index{args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)};
+    sizes.address_index = std::min(nTotalCache / 8, address_index ? nMaxTxIndexCache << 20 : 0);
+    nTotalCache -= sizes.address_index;
+    const bool spent_index{args.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX)};
+    sizes.spent_index = std::min(nTotalCache / 8, spent_index ? nMaxTxIndexCache << 20 : 0);
+    nTotalCache -= sizes.spent_index;
+    // the address and spent indexes each keep the entries of new blocks in a write cache
+    const int n_write_caches{address_index + spent_index};
+    sizes.index_write_cache = n_write_caches > 0 ? std::min(nTotalCache / 8, nMaxTxIndexCache << 20) / n_write_caches : 0;
+    nTotalCache -= sizes.index_write_cache * n_write_caches;
     sizes.filter_index = 0;
     if (n_indexes > 0) {
         int64_t max_cache = std::min(nTotalCache / 8, max_filter_index_cache << 20);
@@ -155,14 +155,6 @@ static ChainstateLoadResult CompleteChainstateInitialization(
     // on the condition of each chainstate.
     chainman.MaybeRebalanceCaches();
 
-    // Sugar: Addressindex
-    if (fAddressIndex != options.addressindex)
-        return {ChainstateLoadStatus::FAILURE, _("Bad -addressindex flag")};
-    if (fTimestampIndex != options.timestampindex)
-        return {ChainstateLoadStatus::FAILURE, _("Bad -timestampindex flag")};
-    if (fSpentIndex != options.spentindex)
-        return {ChainstateLoadStatus::FAILURE, _("Bad -spentindex flag")};
-
     return {ChainstateLoadStatus::SUCCESS, {}};
 }
 
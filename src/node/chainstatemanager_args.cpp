@@ -26,6 +26,8 @@ std::optional<bilingual_str> ApplyArgsManOptions(const ArgsManager& args, Chains
 
     if (auto value{args.GetBoolArg("-checkpoints")}) opts.checkpoints_enabled = *value;
 
+    if (auto value{args.GetBoolArg("-assumepow")}) opts.assume_pow = *value; /* YespowerSugar */
+
     if (auto value{args.GetArg("-minimumchainwork")}) {
         if (!IsHexNumber(*value)) {
             return strprintf(Untranslated("Invalid non-hex (%s) minimum chain work value specified"), *value);
@@ -28,20 +28,18 @@ unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHead
             return pindexLast->nBits;
     }
 
-    // Find the first block in the averaging interval
-    const CBlockIndex* pindexFirst = pindexLast;
-    arith_uint256 bnTot {0};
-    for (int i = 0; pindexFirst && i < params.nPowAveragingWindow; i++) {
-        arith_uint256 bnTmp;
-        bnTmp.SetCompact(pindexFirst->nBits);
-        bnTot += bnTmp;
-        pindexFirst = pindexFirst->pprev;
-    }
-
     // Check we have enough blocks
-    if (pindexFirst == nullptr)
+    if (pindexLast->nHeight < params.nPowAveragingWindow)
         return nProofOfWorkLimit;
 
+    // Find the last block before the averaging interval
+    const CBlockIndex* pindexFirst = pindexLast->GetAncestor(pindexLast->nHeight - params.nPowAveragingWindow);
+    assert(pindexFirst != nullptr);
+
+    // The interval's target sum is the difference of the chain target sums,
+    // which wrap around exactly like summing the interval's targets would
+    arith_uint256 bnTot {pindexLast->nChainTargetSum - pindexFirst->nChainTargetSum};
+
     arith_uint256 bnAvg {bnTot / params.nPowAveragingWindow};
 
     return CalculateNextWorkRequired(bnAvg, pindexLast->GetMedianTimePast(), pindexFirst->GetMedianTimePast(), params);
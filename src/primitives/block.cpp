@@ -9,32 +9,37 @@
 #include <tinyformat.h>
 
 /* YespowerSugar */
-#include <crypto/yespower-1.0.1/yespower.h>
+#include <crypto/yespower.h>
 #include <streams.h>
 #include <version.h>
 #include <stdlib.h> // exit()
 #include <sync.h>
 
+#include <array>
+#include <vector>
+
 uint256 CBlockHeaderUncached::GetHash() const
 {
     return SerializeHash(*this);
 }
 
 
+/* YespowerSugar */
+static const yespower_params_t yespower_1_0_sugarchain = {
+    .version = YESPOWER_1_0,
+    .N = 2048,
+    .r = 32,
+    .pers = (const uint8_t *)"Satoshi Nakamoto 31/Oct/2008 Proof-of-work is essentially one-CPU-one-vote",
+    .perslen = 74
+};
+
 /* YespowerSugar */
 uint256 CBlockHeaderUncached::GetPoWHash() const
 {
-    static const yespower_params_t yespower_1_0_sugarchain = {
-        .version = YESPOWER_1_0,
-        .N = 2048,
-        .r = 32,
-        .pers = (const uint8_t *)"Satoshi Nakamoto 31/Oct/2008 Proof-of-work is essentially one-CPU-one-vote",
-        .perslen = 74
-    };
     uint256 hash;
     CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
     ss << *this;
-    if (yespower_tls((const uint8_t *)&ss[0], ss.size(), &yespower_1_0_sugarchain, (yespower_binary_t *)&hash)) {
+    if (!YespowerHash(UCharCast(ss.data()), ss.size(), yespower_1_0_sugarchain, hash.begin())) {
         tfm::format(std::cerr, "Error: CBlockHeaderUncached::GetPoWHash(): failed to compute PoW hash (out of memory?)\n");
         exit(1);
     }
@@ -42,25 +47,105 @@ uint256 CBlockHeaderUncached::GetPoWHash() const
 }
 
 /* YespowerSugar */
-uint256 CBlockHeader::GetPoWHash_cached() const
+size_t InitPoWHashRegions(size_t count, bool hugepages)
+{
+    return YespowerInitRegions(count, hugepages, yespower_1_0_sugarchain);
+}
+
+/* YespowerSugar */
+namespace {
+/**
+ * Fixed-size table of recently computed PoW hashes, keyed by block hash.
+ *
+ * A header's PoW hash is needed a few times while it is being accepted (the
+ * batch check in HasValidProofOfWork, CheckBlockHeader, CheckBlock), but not
+ * once it is in the block index with BLOCK_VALID_TRANSACTIONS. So instead of a cache in
+ * every header and block index entry, keep one bounded table: each block hash
+ * maps to a single slot, and a newer hash simply replaces whatever was there.
+ * Slots are spread over shards with their own lock, so the PoW worker threads
+ * rarely contend.
+ */
+class PoWHashCache
 {
-    uint256 block_hash = GetHash();
-    LOCK(cache_lock);
-    if (cache_init) {
-        if (block_hash != cache_block_hash) {
-            tfm::format(std::cerr, "Error: CBlockHeader::GetPoWHash_cached(): block hash changed unexpectedly\n");
-            exit(1);
+    static constexpr size_t SHARDS{16};
+    static constexpr size_t SLOTS_PER_SHARD{4096}; // 64 bytes each, 4 MiB in total
+
+    struct Entry {
+        uint256 block_hash; //!< null if the slot is empty
+        uint256 pow_hash;
+    };
+
+    struct Shard {
+        Mutex mutex;
+        std::vector<Entry> entries GUARDED_BY(mutex);
+    };
+
+    std::array<Shard, SHARDS> m_shards;
+
+    // Block hashes are uniformly distributed, so their bits pick shard and slot
+    // directly. Crafted hashes can only evict entries, never return a wrong one.
+    Shard& GetShard(const uint256& block_hash) { return m_shards[block_hash.GetUint64(0) % SHARDS]; }
+    static size_t GetSlot(const uint256& block_hash) { return block_hash.GetUint64(1) % SLOTS_PER_SHARD; }
+
+public:
+    std::optional<uint256> Get(const uint256& block_hash)
+    {
+        Shard& shard{GetShard(block_hash)};
+        LOCK(shard.mutex);
+        if (shard.entries.empty()) return std::nullopt;
+        const Entry& entry{shard.entries[GetSlot(block_hash)]};
+        if (entry.block_hash != block_hash) return std::nullopt;
+        return entry.pow_hash;
+    }
+
+    void Put(const uint256& block_hash, const uint256& pow_hash)
+    {
+        Shard& shard{GetShard(block_hash)};
+        LOCK(shard.mutex);
+        if (shard.entries.empty()) shard.entries.resize(SLOTS_PER_SHARD);
+        shard.entries[GetSlot(block_hash)] = Entry{block_hash, pow_hash};
+    }
+
+    void Clear()
+    {
+        for (Shard& shard : m_shards) {
+            LOCK(shard.mutex);
+            shard.entries.clear();
         }
-        /* yespower PoW cache log: O (cyan) = HIT */
-        // printf("\033[36;1mO\033[0m block = %s PoW = %s\n", cache_block_hash.ToString().c_str(), cache_PoW_hash.ToString().c_str());
-    } else {
-        cache_PoW_hash = GetPoWHash();
-        cache_block_hash = block_hash;
-        cache_init = true;
-        /* yespower PoW cache log: x = MISS */
-        // printf("x block = %s PoW = %s\n", cache_block_hash.ToString().c_str(), cache_PoW_hash.ToString().c_str());
     }
-    return cache_PoW_hash;
+};
+
+PoWHashCache& GetPoWHashCache()
+{
+    static PoWHashCache cache;
+    return cache;
+}
+} // namespace
+
+/* YespowerSugar */
+std::optional<uint256> GetCachedPoWHash(const uint256& block_hash)
+{
+    return GetPoWHashCache().Get(block_hash);
+}
+
+/* YespowerSugar */
+void ClearPoWHashCache()
+{
+    GetPoWHashCache().Clear();
+}
+
+/* YespowerSugar */
+uint256 CBlockHeader::GetPoWHash_cached() const
+{
+    const uint256 block_hash{GetHash()};
+    if (const auto pow_hash{GetPoWHashCache().Get(block_hash)}) {
+        return *pow_hash;
+    }
+    // Computed without holding the shard lock; concurrent misses on the same
+    // header both hash it and store the same result.
+    const uint256 pow_hash{GetPoWHash()};
+    GetPoWHashCache().Put(block_hash, pow_hash);
+    return pow_hash;
 }
 
 std::string CBlock::ToString() const
@@ -11,7 +11,7 @@
 #include <uint256.h>
 #include <util/time.h>
 
-#include <sync.h> /* YespowerSugar */
+#include <optional> /* YespowerSugar */
 
 /** Nodes collect new transactions into a block, hash them into a hash tree,
  * and scan through nonce values to make the block's hash satisfy proof-of-work
@@ -70,35 +70,22 @@ public:
 
 
 /* YespowerSugar */
+/**
+ * Block header whose PoW hash is looked up in (and added to) the shared PoW
+ * hash cache. Carries no state of its own, so it stays plain data.
+ */
 class CBlockHeader : public CBlockHeaderUncached
 {
 public:
-    mutable RecursiveMutex cache_lock; // Do not use CCriticalSection // See https://github.com/bitcoin/bitcoin/pull/17891
-    mutable bool cache_init;
-    mutable uint256 cache_block_hash, cache_PoW_hash;
-
-    CBlockHeader()
-    {
-        cache_init = false;
-    }
-
-    CBlockHeader(const CBlockHeader& header)
-    {
-        *this = header;
-    }
-
-    CBlockHeader& operator=(const CBlockHeader& header)
-    {
-        *(CBlockHeaderUncached*)this = (CBlockHeaderUncached)header;
-        cache_init = header.cache_init;
-        cache_block_hash = header.cache_block_hash;
-        cache_PoW_hash = header.cache_PoW_hash;
-        return *this;
-    }
-
     uint256 GetPoWHash_cached() const;
 };
 
+/* YespowerSugar */
+/** Look up the PoW hash of the block with this hash in the shared PoW hash cache. */
+std::optional<uint256> GetCachedPoWHash(const uint256& block_hash);
+/** Drop every entry from the shared PoW hash cache. */
+void ClearPoWHashCache();
+
 class CBlock : public CBlockHeader
 {
 public:
@@ -147,6 +134,12 @@ public:
     std::string ToString() const;
 };
 
+/* YespowerSugar */
+static constexpr bool DEFAULT_YESPOWER_HUGEPAGES{false};
+/** Pre-allocate count Yespower regions for PoW hashing and cap the number of
+ *  hashes in flight there. Returns how many regions got huge pages. */
+size_t InitPoWHashRegions(size_t count, bool hugepages);
+
 /** Describes a place in the block chain to another node such that if the
  * other node doesn't have the same branch, it can find a recent common trunk.
  * The further back it is, the further before the fork it may be.
@@ -8,10 +8,14 @@
 #include <blockfilter.h>
 #include <chain.h>
 #include <chainparams.h>
+#include <consensus/consensus.h>
 #include <core_io.h>
 #include <httpserver.h>
+#include <index/addressindex.h>
 #include <index/blockfilterindex.h>
+#include <index/spentindex.h>
 #include <index/txindex.h>
+#include <key_io.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
 #include <primitives/block.h>
@@ -21,6 +25,8 @@
 #include <rpc/protocol.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
+#include <script/standard.h>
+#include <spentindex.h>
 #include <streams.h>
 #include <sync.h>
 #include <txmempool.h>
@@ -40,6 +46,8 @@ using node::ReadBlockFromDisk;
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
 static constexpr unsigned int MAX_REST_HEADERS_RESULTS = 2000;
+// Sugar: Addressindex
+static constexpr size_t MAX_REST_ADDRESS_CHUNK{1000}; //number of address index entries read and sent at once
 
 static const struct {
     RESTResponseFormat rf;
@@ -1001,6 +1009,236 @@ static bool rest_blockhash_by_height(const std::any& context, HTTPRequest* req,
     }
 }
 
+// Sugar: Addressindex
+static bool WriteRESTChunk(HTTPRequest* req, RESTResponseFormat rf, const DataStream& ss)
+{
+    return req->WriteReplyChunk(rf == RESTResponseFormat::HEX ? HexStr(ss) : ss.str());
+}
+
+/**
+ * Stream the index entries of an address, reading one page of at most
+ * MAX_REST_ADDRESS_CHUNK entries at a time. Each page is sent as a chunk
+ * holding a vector of records, and an empty vector ends the reply, so that
+ * a client can tell a complete reply from one that broke off.
+ *
+ * A page is only read once the client took in most of the previous ones,
+ * and the reply ends early when the client goes away.
+ *
+ * read_page appends the entries following a cursor, write_entry serializes
+ * an entry and returns false to leave it out.
+ */
+template <typename Key, typename Value, typename ReadPage, typename WriteEntry>
+static bool rest_address_stream(HTTPRequest* req, RESTResponseFormat rf, ReadPage&& read_page, WriteEntry&& write_entry)
+{
+    std::optional<Key> after;
+    std::vector<std::pair<Key, Value>> page;
+    if (!read_page(after, page)) {
+        return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, "Unable to read the address index");
+    }
+
+    req->WriteHeader("Content-Type", rf == RESTResponseFormat::HEX ? "text/plain" : "application/octet-stream");
+    req->WriteReplyStart(HTTP_OK);
+    while (true) {
+        DataStream records{};
+        uint64_t count{0};
+        for (const auto& entry : page) {
+            if (write_entry(records, entry)) ++count;
+        }
+        // an empty chunk would end the reply
+        if (count > 0) {
+            DataStream ss{};
+            WriteCompactSize(ss, count);
+            ss.write(MakeByteSpan(records));
+            if (!WriteRESTChunk(req, rf, ss)) {
+                req->WriteReplyEnd();
+                return true;
+            }
+        }
+        if (page.size() < MAX_REST_ADDRESS_CHUNK) break;
+
+        after = page.back().first;
+        page.clear();
+        if (!read_page(after, page)) {
+            // the status was sent already, leave the end marker out
+            LogPrintf("%s: Unable to read the address index, reply cut short\n", __func__);
+            req->WriteReplyEnd();
+            return true;
+        }
+    }
+    DataStream end{};
+    WriteCompactSize(end, 0);
+    WriteRESTChunk(req, rf, end);
+    if (rf == RESTResponseFormat::HEX) req->WriteReplyChunk("\n");
+    req->WriteReplyEnd();
+    return true;
+}
+
+static bool rest_address(const std::any& context, HTTPRequest* req, const std::string& str_uri_part)
+{
+    if (!CheckWarmup(req)) return false;
+    std::string param;
+    const RESTResponseFormat rf = ParseDataFormat(param, str_uri_part);
+    if (rf != RESTResponseFormat::BINARY && rf != RESTResponseFormat::HEX) {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: bin, hex)");
+    }
+
+    // request is sent over URI scheme /rest/address/<address>/<utxos|txids|deltas|balance>
+    const std::vector<std::string> uri_parts = SplitString(param, '/');
+    if (uri_parts.size() != 2) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/address/<address>/<utxos|txids|deltas|balance>.<ext>");
+    }
+    const auto indexed{ExtractIndexAddress(DecodeDestination(uri_parts[0]))};
+    if (!indexed) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid address: " + SanitizeString(uri_parts[0]));
+    }
+    const int type{indexed->first};
+    const uint256 hash{indexed->second};
+    const std::string& kind{uri_parts[1]};
+
+    if (!g_address_index) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Address index is not enabled");
+    }
+    if (!g_address_index->BlockUntilSyncedToCurrentChain()) {
+        return RESTERR(req, HTTP_SERVICE_UNAVAILABLE, "Address index is still syncing");
+    }
+
+    if (kind == "balance") {
+        ChainstateManager* maybe_chainman = GetChainman(context, req);
+        if (!maybe_chainman) return false;
+        const int height{WITH_LOCK(cs_main, return maybe_chainman->ActiveChain().Height())};
+
+        CAddressBalanceValue value;
+        CAmount immature;
+        if (!g_address_index->ReadAddressBalance(hash, type, value) ||
+            !g_address_index->ReadAddressCoinbase(hash, type, std::max(0, height - COINBASE_MATURITY + 1), immature)) {
+            return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, "Unable to read the address index");
+        }
+        DataStream ss{};
+        ss << value.balance << immature << value.received << value.txCount;
+        if (rf == RESTResponseFormat::HEX) {
+            req->WriteHeader("Content-Type", "text/plain");
+            req->WriteReply(HTTP_OK, HexStr(ss) + "\n");
+        } else {
+            req->WriteHeader("Content-Type", "application/octet-stream");
+            req->WriteReply(HTTP_OK, ss.str());
+        }
+        return true;
+    }
+
+    if (kind == "utxos") {
+        return rest_address_stream<CAddressUnspentKey, CAddressUnspentValue>(
+            req, rf,
+            [&](const std::optional<CAddressUnspentKey>& after, std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>>& page) {
+                return g_address_index->ReadAddressUnspentIndex(hash, type, page, after, MAX_REST_ADDRESS_CHUNK);
+            },
+            [](DataStream& ss, const std::pair<CAddressUnspentKey, CAddressUnspentValue>& entry) {
+                const auto& [key, value] = entry;
+                ss << key.txhash << uint32_t(key.index) << int32_t(value.blockHeight) << value.satoshis << value.script;
+                return true;
+            });
+    }
+
+    if (kind != "txids" && kind != "deltas") {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/address/<address>/<utxos|txids|deltas|balance>.<ext>");
+    }
+
+    // an optional range of block heights, as in getaddressdeltas
+    int start{0};
+    int end{0};
+    try {
+        const auto raw_start{req->GetQueryParameter("start")};
+        const auto raw_end{req->GetQueryParameter("end")};
+        if (raw_start || raw_end) {
+            if (!raw_start || !raw_end || !ParseInt32(*raw_start, &start) || !ParseInt32(*raw_end, &end) ||
+                start <= 0 || end < start) {
+                return RESTERR(req, HTTP_BAD_REQUEST, "Invalid height range. Expected start and end greater than zero, with end not below start");
+            }
+        }
+    } catch (const std::runtime_error& e) {
+        return RESTERR(req, HTTP_BAD_REQUEST, e.what());
+    }
+    const auto read_page{[&](const std::optional<CAddressIndexKey>& after, std::vector<std::pair<CAddressIndexKey, CAmount>>& page) {
+        return g_address_index->ReadAddressIndex(hash, type, page, start, end, after, MAX_REST_ADDRESS_CHUNK);
+    }};
+
+    if (kind == "txids") {
+        // The entries of a transaction are adjacent in the index
+        uint256 last_txid;
+        return rest_address_stream<CAddressIndexKey, CAmount>(
+            req, rf, read_page,
+            [&last_txid](DataStream& ss, const std::pair<CAddressIndexKey, CAmount>& entry) {
+                const CAddressIndexKey& key{entry.first};
+                if (key.txhash == last_txid) return false;
+                last_txid = key.txhash;
+                ss << key.txhash << int32_t(key.blockHeight);
+                return true;
+            });
+    }
+
+    return rest_address_stream<CAddressIndexKey, CAmount>(
+        req, rf, read_page,
+        [](DataStream& ss, const std::pair<CAddressIndexKey, CAmount>& entry) {
+            const auto& [key, amount] = entry;
+            ss << key.txhash << uint32_t(key.index) << int32_t(key.blockHeight) << uint32_t(key.txindex) << amount;
+            return true;
+        });
+}
+
+static bool rest_spent(const std::any& context, HTTPRequest* req, const std::string& str_uri_part)
+{
+    if (!CheckWarmup(req)) return false;
+    std::string param;
+    const RESTResponseFormat rf = ParseDataFormat(param, str_uri_part);
+    if (rf != RESTResponseFormat::BINARY && rf != RESTResponseFormat::HEX) {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: bin, hex)");
+    }
+
+    // request is sent over URI scheme /rest/spent/<txid>/<n>
+    const std::vector<std::string> uri_parts = SplitString(param, '/');
+    if (uri_parts.size() != 2) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/spent/<txid>/<n>.<ext>");
+    }
+    uint256 txid;
+    if (!ParseHashStr(uri_parts[0], txid)) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + SanitizeString(uri_parts[0]));
+    }
+    uint32_t output_index;
+    if (!ParseUInt32(uri_parts[1], &output_index)) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid output index: " + SanitizeString(uri_parts[1]));
+    }
+
+    if (!g_spent_index) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Spent index is not enabled");
+    }
+    if (!g_spent_index->BlockUntilSyncedToCurrentChain()) {
+        return RESTERR(req, HTTP_SERVICE_UNAVAILABLE, "Spent index is still syncing");
+    }
+    const CTxMemPool* mempool = GetMemPool(context, req);
+    if (!mempool) return false;
+
+    // spends in the mempool take precedence, as in getspentinfo
+    const CSpentIndexKey key{txid, output_index};
+    CSpentIndexValue value;
+    if (!mempool->getSpentIndex(key, value) && !g_spent_index->ReadSpentIndex(key, value)) {
+        return RESTERR(req, HTTP_NOT_FOUND, uri_parts[0] + "/" + uri_parts[1] + " not spent");
+    }
+
+    // The height of a spend in the mempool is -1, which the index
+    // serialization of CSpentIndexValue does not allow
+    DataStream ss{};
+    ss << value.txid << uint32_t(value.inputIndex) << int32_t(value.blockHeight) << value.satoshis;
+    SerializeAddress(ss, value.addressType, value.addressHash);
+
+    if (rf == RESTResponseFormat::HEX) {
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, HexStr(ss) + "\n");
+    } else {
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, ss.str());
+    }
+    return true;
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(const std::any& context, HTTPRequest* req, const std::string& strReq);
@@ -1017,6 +1255,8 @@ static const struct {
       {"/rest/deploymentinfo/", rest_deploymentinfo},
       {"/rest/deploymentinfo", rest_deploymentinfo},
       {"/rest/blockhashbyheight/", rest_blockhash_by_height},
+      {"/rest/address/", rest_address},
+      {"/rest/spent/", rest_spent},
 };
 
 void StartREST(const std::any& context)
@@ -232,6 +232,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "getaddressesbalance", 0, "addresses"},
     { "getaddressutxos", 1, "amount"},
     { "getaddressutxos", 2, "chainInfo"},
+    { "setzmqaddressfilter", 0, "addresses"},
 };
 // clang-format on
 
@@ -3,13 +3,17 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <index/addressindex.h>
+#include <index/spentindex.h>
+#include <index/timestampindex.h>
 #include <node/context.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <rpc/util.h>
-#include <txdb.h>
+#include <streams.h>
 #include <txmempool.h>
 #include <univalue.h>
+#include <util/strencodings.h>
 #include <validation.h>
 #include <uint256.h>
 #include <key_io.h>
@@ -19,6 +23,7 @@
 #include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <optional>
 
 using node::NodeContext;
 
@@ -130,32 +135,114 @@ static bool getAddressesFromParams(const UniValue& params, std::vector<std::pair
 }
 
 
-bool GetSpentIndex(ChainstateManager &chainman, const CSpentIndexKey &key, CSpentIndexValue &value, const CTxMemPool *pmempool)
+/** Largest number of entries a page of the address RPCs can hold */
+static constexpr int MAX_ADDRESS_PAGE_SIZE{10000};
+
+/** Largest number of outputs getspentinfo looks up in one call */
+static constexpr size_t MAX_SPENT_INFO_BATCH_SIZE{10000};
+
+/** The "limit" of the address object, or 0 to return all entries at once */
+static size_t GetPageLimit(const UniValue& params)
+{
+    if (!params[0].isObject()) return 0;
+    const UniValue& limit_value = find_value(params[0].get_obj(), "limit");
+    if (limit_value.isNull()) return 0;
+
+    const int limit{limit_value.getInt<int>()};
+    if (limit <= 0 || limit > MAX_ADDRESS_PAGE_SIZE) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Limit is expected to be between 1 and %d", MAX_ADDRESS_PAGE_SIZE));
+    }
+    return limit;
+}
+
+/** The "after" cursor of the address object, which is the key of the last entry of the previous page */
+template <typename Key>
+static std::optional<Key> GetPageCursor(const UniValue& params)
+{
+    if (!params[0].isObject()) return std::nullopt;
+    const UniValue& after_value = find_value(params[0].get_obj(), "after");
+    if (after_value.isNull()) return std::nullopt;
+
+    if (find_value(params[0].get_obj(), "limit").isNull()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "A cursor is only valid together with a limit");
+    }
+    if (!IsHex(after_value.get_str())) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Cursor must be hexadecimal");
+    }
+    DataStream ss{ParseHex(after_value.get_str())};
+    Key key;
+    try {
+        ss >> key;
+    } catch (const std::ios_base::failure&) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+    }
+    if (!ss.empty()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+    }
+    return key;
+}
+
+template <typename Key>
+static std::string EncodePageCursor(const Key& key)
+{
+    DataStream ss{};
+    ss << key;
+    return HexStr(ss);
+}
+
+/** Position in addresses of the address a page resumes at */
+template <typename Key>
+static size_t GetResumeAddress(const std::vector<std::pair<uint256, int> >& addresses, const std::optional<Key>& after)
+{
+    if (!after) return 0;
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        if (addresses[i].first == after->hashBytes && unsigned(addresses[i].second) == after->type) return i;
+    }
+    throw JSONRPCError(RPC_INVALID_PARAMETER, "Cursor does not belong to any of the addresses");
+}
+
+/** Throw if a cursor is outside the start and end heights of the query, if these are given */
+static void CheckCursorRange(const std::optional<CAddressIndexKey>& after, int start, int end)
+{
+    if (!after || start <= 0 || end <= 0) return;
+    if (after->blockHeight < start || after->blockHeight > end) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Cursor is outside the start and end heights");
+    }
+}
+
+/** Wait for an index to process the blocks connected so far, or throw if it is still catching up */
+static void EnsureIndexSynced(const BaseIndex& index)
 {
-    auto& pblocktree{chainman.m_blockman.m_block_tree_db};
-    if (!fSpentIndex) {
+    if (!index.BlockUntilSyncedToCurrentChain()) {
+        const IndexSummary summary{index.GetSummary()};
+        throw JSONRPCError(RPC_MISC_ERROR, strprintf("Unable to get data because %s is still syncing. Current height: %d", summary.name, summary.best_block_height));
+    }
+}
+
+bool GetSpentIndex(const CSpentIndexKey &key, CSpentIndexValue &value, const CTxMemPool *pmempool)
+{
+    if (!g_spent_index) {
         return false;
     }
     if (pmempool && pmempool->getSpentIndex(key, value)) {
         return true;
     }
-    if (!pblocktree->ReadSpentIndex(key, value)) {
+    if (!g_spent_index->ReadSpentIndex(key, value)) {
         return false;
     }
 
     return true;
 };
 
-bool GetAddressIndex(ChainstateManager &chainman, const uint256 &addressHash, int type,
-                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex, int start = 0, int end = 0)
+bool GetAddressIndex(const uint256 &addressHash, int type,
+                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex, int start = 0, int end = 0,
+                     const std::optional<CAddressIndexKey> &after = std::nullopt, size_t limit = 0)
 {
-    auto& pblocktree{chainman.m_blockman.m_block_tree_db};
-
-    if (!fAddressIndex) {
+    if (!g_address_index) {
         return error("Address index not enabled");
     }
 
-    if (!pblocktree->ReadAddressIndex(addressHash, type, addressIndex, start, end)) {
+    if (!g_address_index->ReadAddressIndex(addressHash, type, addressIndex, start, end, after, limit)) {
         return error("Unable to get txids for address");
     }
 
@@ -163,53 +250,50 @@ bool GetAddressIndex(ChainstateManager &chainman, const uint256 &addressHash, in
 };
 
 
-bool GetAddressUnspent(ChainstateManager &chainman, const uint256 &addressHash, int type,
-                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs)
+bool GetAddressUnspent(const uint256 &addressHash, int type,
+                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                       const std::optional<CAddressUnspentKey> &after = std::nullopt, size_t limit = 0)
 {
-    auto& pblocktree{chainman.m_blockman.m_block_tree_db};
-    if (!fAddressIndex) {
+    if (!g_address_index) {
         return error("Address index not enabled");
     }
-    if (!pblocktree->ReadAddressUnspentIndex(addressHash, type, unspentOutputs)) {
+    if (!g_address_index->ReadAddressUnspentIndex(addressHash, type, unspentOutputs, after, limit)) {
         return error("Unable to get txids for address");
     }
 
     return true;
 };
 
-static bool HashOnchainActive(ChainstateManager &chainman, const uint256 &hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+/** Sum the balance records of addresses. Coinbase outputs of the last COINBASE_MATURITY blocks are immature. */
+static UniValue AddressesBalanceToJSON(const std::vector<std::pair<uint256, int>>& addresses, int height)
 {
-    CBlockIndex* pblockindex = chainman.m_blockman.LookupBlockIndex(hash);
-
-    if (!chainman.ActiveChain().Contains(pblockindex)) {
-        return false;
-    }
-
-    return true;
-};
-
-bool GetTimestampIndex(ChainstateManager &chainman, const unsigned int &high, const unsigned int &low, const bool fActiveOnly, std::vector<std::pair<uint256, unsigned int> > &hashes)
-{
-    auto& pblocktree{chainman.m_blockman.m_block_tree_db};
-    if (!fTimestampIndex) {
-        return error("Timestamp index not enabled");
-    }
-    if (!pblocktree->ReadTimestampIndex(high, low, hashes)) {
-        return error("Unable to get hashes for timestamps");
-    }
+    CAmount balance = 0;
+    CAmount balance_immature = 0;
+    CAmount received = 0;
+    int64_t txcount = 0;
 
-    if (fActiveOnly) {
-        for (auto it = hashes.begin(); it != hashes.end(); ) {
-            if (!HashOnchainActive(chainman, it->first)) {
-                it = hashes.erase(it);
-            } else {
-                ++it;
-            }
+    for (const auto& [hash, type] : addresses) {
+        CAddressBalanceValue value;
+        CAmount immature;
+        if (!g_address_index->ReadAddressBalance(hash, type, value) ||
+            !g_address_index->ReadAddressCoinbase(hash, type, std::max(0, height - COINBASE_MATURITY + 1), immature)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
+        balance += value.balance;
+        balance_immature += immature;
+        received += value.received;
+        txcount += value.txCount;
     }
 
-    return true;
-};
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("balance", balance);
+    result.pushKV("balance_immature", balance_immature);
+    result.pushKV("balance_spendable", balance - balance_immature);
+    result.pushKV("received", received);
+    result.pushKV("txcount", txcount);
+
+    return result;
+}
 
 static RPCHelpMan getaddressbalance()
 {
@@ -221,7 +305,10 @@ static RPCHelpMan getaddressbalance()
                 RPCResult{
                     RPCResult::Type::OBJ, "", "", {
                         {RPCResult::Type::STR_AMOUNT, "balance", "The current balance in satoshis"},
+                        {RPCResult::Type::STR_AMOUNT, "balance_immature", "The balance in satoshis of coinbase outputs that are not mature yet"},
+                        {RPCResult::Type::STR_AMOUNT, "balance_spendable", "The balance in satoshis that is not immature"},
                         {RPCResult::Type::STR_AMOUNT, "received", "The total number of satoshis received (including change)"},
+                        {RPCResult::Type::NUM, "txcount", "The number of transactions that sent to or spent from the address(es), counted per address"},
                     }
                 },
                 RPCExamples{
@@ -237,42 +324,15 @@ static RPCHelpMan getaddressbalance()
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address 7");
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-
-    ChainstateManager& chainman = EnsureAnyChainman(request.context);
-
-    for (std::vector<std::pair<uint256, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressIndex(chainman, (*it).first, (*it).second, addressIndex)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-        }
-    }
-
-    int nHeight = (unsigned int) chainman.ActiveChain().Height();
-
-    CAmount balance = 0;
-    CAmount balance_spendable = 0;
-    CAmount balance_immature = 0;
-    CAmount received = 0;
-
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        if (it->second > 0) {
-            received += it->second;
-        }
-        if (it->first.txindex == 0 && nHeight - it->first.blockHeight < COINBASE_MATURITY) {
-            balance_immature += it->second;
-        } else {
-            balance_spendable += it->second;
-        }
-        balance += it->second;
+    if (!g_address_index) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Address index is not enabled.");
     }
+    EnsureIndexSynced(*g_address_index);
 
-    UniValue result(UniValue::VOBJ);
-    result.pushKV("balance", balance);
-    result.pushKV("balance_immature", balance_immature);
-    result.pushKV("balance_spendable", balance_spendable);
-    result.pushKV("received", received);
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    int nHeight = WITH_LOCK(cs_main, return chainman.ActiveChain().Height());
 
-    return result;
+    return AddressesBalanceToJSON(addresses, nHeight);
 },
     };
 }
@@ -292,7 +352,10 @@ static RPCHelpMan getaddressesbalance()
                 RPCResult{
                     RPCResult::Type::OBJ, "", "", {
                         {RPCResult::Type::STR_AMOUNT, "balance", "The current balance in satoshis"},
+                        {RPCResult::Type::STR_AMOUNT, "balance_immature", "The balance in satoshis of coinbase outputs that are not mature yet"},
+                        {RPCResult::Type::STR_AMOUNT, "balance_spendable", "The balance in satoshis that is not immature"},
                         {RPCResult::Type::STR_AMOUNT, "received", "The total number of satoshis received (including change)"},
+                        {RPCResult::Type::NUM, "txcount", "The number of transactions that sent to or spent from the address(es), counted per address"},
                     }
                 },
                 RPCExamples{
@@ -308,42 +371,15 @@ static RPCHelpMan getaddressesbalance()
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address 7");
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-
-    ChainstateManager& chainman = EnsureAnyChainman(request.context);
-
-    for (std::vector<std::pair<uint256, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressIndex(chainman, (*it).first, (*it).second, addressIndex)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-        }
-    }
-
-    int nHeight = (unsigned int) chainman.ActiveChain().Height();
-
-    CAmount balance = 0;
-    CAmount balance_spendable = 0;
-    CAmount balance_immature = 0;
-    CAmount received = 0;
-
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        if (it->second > 0) {
-            received += it->second;
-        }
-        if (it->first.txindex == 0 && nHeight - it->first.blockHeight < COINBASE_MATURITY) {
-            balance_immature += it->second;
-        } else {
-            balance_spendable += it->second;
-        }
-        balance += it->second;
+    if (!g_address_index) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Address index is not enabled.");
     }
+    EnsureIndexSynced(*g_address_index);
 
-    UniValue result(UniValue::VOBJ);
-    result.pushKV("balance", balance);
-    result.pushKV("balance_immature", balance_immature);
-    result.pushKV("balance_spendable", balance_spendable);
-    result.pushKV("received", received);
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    int nHeight = WITH_LOCK(cs_main, return chainman.ActiveChain().Height());
 
-    return result;
+    return AddressesBalanceToJSON(addresses, nHeight);
 },
     };
 }
@@ -361,6 +397,8 @@ return RPCHelpMan{"getaddressutxos",
                     RPCArgOptions{.skip_type_check = true}},
                     {"amount", RPCArg::Type::AMOUNT, RPCArg::Default{0}, "The required amount in " + CURRENCY_UNIT + " to get UTXO for. eg 0.1"},
                     {"chainInfo", RPCArg::Type::BOOL, RPCArg::Default{false}, "Include chain info in results, only applies if start and end specified."},
+                    {"limit", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "Given in the addresses object. Return at most this many outputs, in index order, and a cursor to the next page."},
+                    {"after", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED, "Given in the addresses object. The cursor returned with the previous page."},
                 },
                 {
                     RPCResult{"Default",
@@ -375,14 +413,15 @@ return RPCHelpMan{"getaddressutxos",
                             }}
                         }
                     },
-                    RPCResult{"With chainInfo", RPCResult::Type::OBJ, "", "", {
-                        {RPCResult::Type::STR_HEX, "hash", "Start hash"},
-                        {RPCResult::Type::NUM, "height", "Chain height"},
+                    RPCResult{"With chainInfo or limit", RPCResult::Type::OBJ, "", "", {
+                        {RPCResult::Type::STR_HEX, "hash", /*optional=*/true, "Start hash, with chainInfo"},
+                        {RPCResult::Type::NUM, "height", /*optional=*/true, "Chain height, with chainInfo"},
                         {RPCResult::Type::ARR, "utxos", "", {
                             {RPCResult::Type::OBJ, "", "", {
                                 {RPCResult::Type::ELISION, "", "Same as Default"},
                             }}
-                        }}
+                        }},
+                        {RPCResult::Type::STR_HEX, "next", /*optional=*/true, "With limit, the cursor to pass as after for the next page, if there may be one"},
                     }}
                 },
                 RPCExamples{
@@ -394,9 +433,10 @@ return RPCHelpMan{"getaddressutxos",
 {
     ChainstateManager &chainman = EnsureAnyChainman(request.context);
 
-    if (!fAddressIndex) {
+    if (!g_address_index) {
         throw JSONRPCError(RPC_MISC_ERROR, "Address index is not enabled.");
     }
+    EnsureIndexSynced(*g_address_index);
 
     CAmount requiredAmount = 0;
     if (!request.params[1].isNull()) {
@@ -413,14 +453,22 @@ return RPCHelpMan{"getaddressutxos",
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    // With a limit, only one page is read, in index order
+    const size_t limit{GetPageLimit(request.params)};
+    std::optional<CAddressUnspentKey> after{GetPageCursor<CAddressUnspentKey>(request.params)};
+
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
-    for (std::vector<std::pair<uint256, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressUnspent(chainman, it->first, it->second, unspentOutputs)) {
+    for (size_t i = GetResumeAddress(addresses, after); i < addresses.size(); ++i) {
+        if (limit > 0 && unspentOutputs.size() >= limit) break;
+        if (!GetAddressUnspent(addresses[i].first, addresses[i].second, unspentOutputs, after, limit > 0 ? limit - unspentOutputs.size() : 0)) {
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
+        after.reset();
     }
 
-    std::sort(unspentOutputs.begin(), unspentOutputs.end(), heightSort);
+    if (limit == 0) {
+        std::sort(unspentOutputs.begin(), unspentOutputs.end(), heightSort);
+    }
 
     UniValue utxos(UniValue::VARR);
     CAmount total = 0;
@@ -429,7 +477,7 @@ return RPCHelpMan{"getaddressutxos",
         if (requiredAmount > 0 && total >= requiredAmount) {
             break;
         }
-        
+
         UniValue output(UniValue::VOBJ);
         std::string address;
         if (!getAddressFromIndex(it->first.type, it->first.hashBytes, address)) {
@@ -447,13 +495,21 @@ return RPCHelpMan{"getaddressutxos",
         total += it->second.satoshis;
     }
 
-    if (includeChainInfo) {
+    // a full page may be followed by another, unless the required amount is reached
+    const bool more{limit > 0 && unspentOutputs.size() >= limit && !(requiredAmount > 0 && total >= requiredAmount)};
+
+    if (includeChainInfo || limit > 0) {
         UniValue result(UniValue::VOBJ);
         result.pushKV("utxos", utxos);
 
-        LOCK(cs_main);
-        result.pushKV("hash", chainman.ActiveChain().Tip()->GetBlockHash().GetHex());
-        result.pushKV("height", int(chainman.ActiveChain().Height()));
+        if (includeChainInfo) {
+            LOCK(cs_main);
+            result.pushKV("hash", chainman.ActiveChain().Tip()->GetBlockHash().GetHex());
+            result.pushKV("height", int(chainman.ActiveChain().Height()));
+        }
+        if (more) {
+            result.pushKV("next", EncodePageCursor(unspentOutputs.back().first));
+        }
         return result;
     } else {
         return utxos;
@@ -476,6 +532,8 @@ static RPCHelpMan getaddressdeltas()
                     {"start", RPCArg::Type::NUM, RPCArg::Default{0}, "The start block height."},
                     {"end", RPCArg::Type::NUM, RPCArg::Default{0}, "The end block height."},
                     {"chainInfo", RPCArg::Type::BOOL, RPCArg::Default{false}, "Include chain info in results, only applies if start and end specified."},
+                    {"limit", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "Given in the addresses object. Return at most this many deltas and a cursor to the next page."},
+                    {"after", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED, "Given in the addresses object. The cursor returned with the previous page."},
                 },
                 {
                     RPCResult{"Default",
@@ -490,20 +548,21 @@ static RPCHelpMan getaddressdeltas()
                             }}
                         }
                     },
-                    RPCResult{"With chainInfo", RPCResult::Type::OBJ, "", "", {
+                    RPCResult{"With chainInfo or limit", RPCResult::Type::OBJ, "", "", {
                         {RPCResult::Type::ARR, "deltas", "", {
                             {RPCResult::Type::OBJ, "", "", {
                                 {RPCResult::Type::ELISION, "", "Same output as Default output"},
                             }}
                         }},
-                        {RPCResult::Type::OBJ, "start", "", {
+                        {RPCResult::Type::OBJ, "start", /*optional=*/true, "With chainInfo", {
                             {RPCResult::Type::STR_HEX, "hash", "Start hash"},
                             {RPCResult::Type::NUM, "height", "Start height"},
                         }},
-                        {RPCResult::Type::OBJ, "end", "", {
+                        {RPCResult::Type::OBJ, "end", /*optional=*/true, "With chainInfo", {
                             {RPCResult::Type::STR_HEX, "hash", "End hash"},
                             {RPCResult::Type::NUM, "height", "End height"},
                         }},
+                        {RPCResult::Type::STR_HEX, "next", /*optional=*/true, "With limit, the cursor to pass as after for the next page, if there may be one"},
                     }}
                 },
                 RPCExamples{
@@ -513,9 +572,10 @@ static RPCHelpMan getaddressdeltas()
                 },
         [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
 {
-    if (!fAddressIndex) {
+    if (!g_address_index) {
         throw JSONRPCError(RPC_MISC_ERROR, "Address index is not enabled.");
     }
+    EnsureIndexSynced(*g_address_index);
 
     ChainstateManager &chainman = EnsureAnyChainman(request.context);
 
@@ -547,18 +607,18 @@ static RPCHelpMan getaddressdeltas()
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    const size_t limit{GetPageLimit(request.params)};
+    std::optional<CAddressIndexKey> after{GetPageCursor<CAddressIndexKey>(request.params)};
+    CheckCursorRange(after, start, end);
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
-    for (std::vector<std::pair<uint256, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (start > 0 && end > 0) {
-            if (!GetAddressIndex(chainman, it->first, it->second, addressIndex, start, end)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-            }
-        } else {
-            if (!GetAddressIndex(chainman, it->first, it->second, addressIndex)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-            }
+    for (size_t i = GetResumeAddress(addresses, after); i < addresses.size(); ++i) {
+        if (limit > 0 && addressIndex.size() >= limit) break;
+        if (!GetAddressIndex(addresses[i].first, addresses[i].second, addressIndex, start, end, after, limit > 0 ? limit - addressIndex.size() : 0)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
+        after.reset();
     }
 
     UniValue deltas(UniValue::VARR);
@@ -581,28 +641,34 @@ static RPCHelpMan getaddressdeltas()
 
     UniValue result(UniValue::VOBJ);
 
-    if (includeChainInfo && start > 0 && end > 0) {
-        LOCK(cs_main);
-        const int tip_height = chainman.ActiveChain().Height();
-        if (start > tip_height || end > tip_height) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Start or end is outside chain range");
-        }
+    if ((includeChainInfo && start > 0 && end > 0) || limit > 0) {
+        result.pushKV("deltas", deltas);
 
-        CBlockIndex* startIndex = chainman.ActiveChain()[start];
-        CBlockIndex* endIndex = chainman.ActiveChain()[end];
+        if (includeChainInfo && start > 0 && end > 0) {
+            LOCK(cs_main);
+            const int tip_height = chainman.ActiveChain().Height();
+            if (start > tip_height || end > tip_height) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Start or end is outside chain range");
+            }
 
-        UniValue startInfo(UniValue::VOBJ);
-        UniValue endInfo(UniValue::VOBJ);
+            CBlockIndex* startIndex = chainman.ActiveChain()[start];
+            CBlockIndex* endIndex = chainman.ActiveChain()[end];
 
-        startInfo.pushKV("hash", startIndex->GetBlockHash().GetHex());
-        startInfo.pushKV("height", start);
+            UniValue startInfo(UniValue::VOBJ);
+            UniValue endInfo(UniValue::VOBJ);
 
-        endInfo.pushKV("hash", endIndex->GetBlockHash().GetHex());
-        endInfo.pushKV("height", end);
+            startInfo.pushKV("hash", startIndex->GetBlockHash().GetHex());
+            startInfo.pushKV("height", start);
 
-        result.pushKV("deltas", deltas);
-        result.pushKV("start", startInfo);
-        result.pushKV("end", endInfo);
+            endInfo.pushKV("hash", endIndex->GetBlockHash().GetHex());
+            endInfo.pushKV("height", end);
+
+            result.pushKV("start", startInfo);
+            result.pushKV("end", endInfo);
+        }
+        if (limit > 0 && addressIndex.size() >= limit) {
+            result.pushKV("next", EncodePageCursor(addressIndex.back().first));
+        }
 
         return result;
     } else {
@@ -625,11 +691,22 @@ static RPCHelpMan getaddresstxids()
                     RPCArgOptions{.skip_type_check = true}},
                     {"start", RPCArg::Type::NUM, RPCArg::Default{0}, "The start block height."},
                     {"end", RPCArg::Type::NUM, RPCArg::Default{0}, "The end block height."},
+                    {"limit", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "Given in the addresses object. Read at most this many index entries, in index order, and return a cursor to the next page. "
+                        "A transaction of several of the addresses can be listed on more than one page."},
+                    {"after", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED, "Given in the addresses object. The cursor returned with the previous page."},
                 },
-                RPCResult{
-                    RPCResult::Type::ARR, "", "", {
-                        {RPCResult::Type::STR_HEX, "transactionid", "The transaction txid"},
-                    }
+                {
+                    RPCResult{"Default",
+                        RPCResult::Type::ARR, "", "", {
+                            {RPCResult::Type::STR_HEX, "transactionid", "The transaction txid"},
+                        }
+                    },
+                    RPCResult{"With limit", RPCResult::Type::OBJ, "", "", {
+                        {RPCResult::Type::ARR, "txids", "", {
+                            {RPCResult::Type::STR_HEX, "transactionid", "The transaction txid"},
+                        }},
+                        {RPCResult::Type::STR_HEX, "next", /*optional=*/true, "The cursor to pass as after for the next page, if there may be one"},
+                    }},
                 },
                 RPCExamples{
             HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"Pb7FLL3DyaAVP2eGfRiEkj4U8ZJ3RHLY9g\"]}'") +
@@ -638,10 +715,10 @@ static RPCHelpMan getaddresstxids()
                 },
         [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
 {
-    if (!fAddressIndex) {
+    if (!g_address_index) {
         throw JSONRPCError(RPC_MISC_ERROR, "Address index is not enabled.");
     }
-    ChainstateManager &chainman = EnsureAnyChainman(request.context);
+    EnsureIndexSynced(*g_address_index);
 
     std::vector<std::pair<uint256, int> > addresses;
 
@@ -660,18 +737,39 @@ static RPCHelpMan getaddresstxids()
         }
     }
 
+    const size_t limit{GetPageLimit(request.params)};
+    std::optional<CAddressIndexKey> after{GetPageCursor<CAddressIndexKey>(request.params)};
+    CheckCursorRange(after, start, end);
+    const std::optional<CAddressIndexKey> cursor{after};
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
-    for (std::vector<std::pair<uint256, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (start > 0 && end > 0) {
-            if (!GetAddressIndex(chainman, it->first, it->second, addressIndex, start, end)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-            }
-        } else {
-            if (!GetAddressIndex(chainman, it->first, it->second, addressIndex)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+    for (size_t i = GetResumeAddress(addresses, after); i < addresses.size(); ++i) {
+        if (limit > 0 && addressIndex.size() >= limit) break;
+        if (!GetAddressIndex(addresses[i].first, addresses[i].second, addressIndex, start, end, after, limit > 0 ? limit - addressIndex.size() : 0)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+        after.reset();
+    }
+
+    if (limit > 0) {
+        // The entries of a transaction are adjacent in the index, so only those
+        // continuing the last transaction of the previous page are repeated
+        std::set<uint256> seen;
+        if (cursor) seen.insert(cursor->txhash);
+        UniValue txids(UniValue::VARR);
+        for (const auto& [key, value] : addressIndex) {
+            if (seen.insert(key.txhash).second) {
+                txids.push_back(key.txhash.GetHex());
             }
         }
+
+        UniValue result(UniValue::VOBJ);
+        result.pushKV("txids", txids);
+        if (addressIndex.size() >= limit) {
+            result.pushKV("next", EncodePageCursor(addressIndex.back().first));
+        }
+        return result;
     }
 
     std::set<std::pair<int, std::string> > txids;
@@ -717,14 +815,14 @@ static RPCHelpMan getblockhashes()
                     },
                 },
                 RPCResults{
-                    {RPCResult::Type::ARR, "", "", {
+                    {"Default", RPCResult::Type::ARR, "", "", {
                         {RPCResult::Type::STR_HEX, "hash", "The block hash"},
                     }},
-                    {RPCResult::Type::ARR, "", "", {
+                    {"With logicalTimes", RPCResult::Type::ARR, "", "", {
                         {RPCResult::Type::OBJ, "", "", {
                             {RPCResult::Type::STR_HEX, "blockhash", "The block hash"},
                             {RPCResult::Type::NUM, "logicalts", "The logical timestamp"},
-                            {RPCResult::Type::NUM, "height", "The height of the block containing the spending tx"},
+                            {RPCResult::Type::NUM, "height", "The height of the block"},
                         }}
                     }}
                 },
@@ -735,8 +833,6 @@ static RPCHelpMan getblockhashes()
                 },
         [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
 {
-    ChainstateManager& chainman = EnsureAnyChainman(request.context);
-
     unsigned int high = request.params[0].getInt<int>();
     unsigned int low = request.params[1].getInt<int>();
     bool fActiveOnly = false;
@@ -756,25 +852,24 @@ static RPCHelpMan getblockhashes()
         }
     }
 
-    std::vector<std::pair<uint256, unsigned int> > blockHashes;
-
-    {
-        LOCK(cs_main);
-        if (!GetTimestampIndex(chainman, high, low, fActiveOnly, blockHashes)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for block hashes");
-        }
+    if (!g_timestamp_index) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Timestamp index is not enabled.");
     }
 
+    std::vector<const CBlockIndex*> blocks;
+    g_timestamp_index->ReadTimestampIndex(high, low, fActiveOnly, blocks);
+
     UniValue result(UniValue::VARR);
 
-    for (std::vector<std::pair<uint256, unsigned int> >::const_iterator it=blockHashes.begin(); it!=blockHashes.end(); it++) {
+    for (const CBlockIndex* pindex : blocks) {
         if (fLogicalTS) {
             UniValue item(UniValue::VOBJ);
-            item.pushKV("blockhash", it->first.GetHex());
-            item.pushKV("logicalts", int(it->second));
+            item.pushKV("blockhash", pindex->GetBlockHash().GetHex());
+            item.pushKV("logicalts", int(pindex->nTime));
+            item.pushKV("height", pindex->nHeight);
             result.push_back(item);
         } else {
-            result.push_back(it->first.GetHex());
+            result.push_back(pindex->GetBlockHash().GetHex());
         }
     }
 
@@ -863,27 +958,63 @@ static RPCHelpMan getaddressmempool()
 }
 
 
+/** Parse an output given to getspentinfo as {"txid", "index"} */
+static CSpentIndexKey SpentIndexKeyFromValue(const UniValue& value)
+{
+    if (!value.isObject()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Expected an object with txid and index");
+    }
+    const UniValue& txidValue = find_value(value.get_obj(), "txid");
+    const UniValue& indexValue = find_value(value.get_obj(), "index");
+
+    if (!txidValue.isStr() || !indexValue.isNum()) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid txid or index");
+    }
+
+    return CSpentIndexKey(ParseHashV(txidValue, "txid"), indexValue.getInt<int>());
+}
+
+static UniValue SpentIndexValueToJSON(const CSpentIndexValue& value)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("txid", value.txid.GetHex());
+    obj.pushKV("index", int(value.inputIndex));
+    obj.pushKV("height", value.blockHeight);
+    return obj;
+}
+
 static RPCHelpMan getspentinfo()
 {
     return RPCHelpMan{"getspentinfo",
-                "\nReturns the txid and index where an output is spent.\n",
+                "\nReturns the txid and index where an output is spent.\n"
+                "Given an array of outputs, looks them all up at once and returns an array with an entry for each, which is null if the output is not spent.\n",
                 {
-                    {"inputs", RPCArg::Type::OBJ, RPCArg::Optional::NO, "",
+                    {"inputs", RPCArg::Type::OBJ, RPCArg::Optional::NO, "The output, or an array of at most " + ToString(MAX_SPENT_INFO_BATCH_SIZE) + " outputs",
                         {
                             {"txid", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The hex string of the txid."},
                             {"index", RPCArg::Type::NUM, RPCArg::Optional::NO, "The output number."},
                         },
-                    },
+                    RPCArgOptions{.skip_type_check = true, .type_str = {"", "json object or array"}}},
                 },
-                RPCResult{
-                    RPCResult::Type::OBJ, "", "", {
-                        {RPCResult::Type::STR_HEX, "txid", "The transaction id"},
-                        {RPCResult::Type::NUM, "index", "The spending input index"},
-                        {RPCResult::Type::NUM, "height", "The height of the block containing the spending tx"},
-                    }
+                {
+                    RPCResult{"For a single output",
+                        RPCResult::Type::OBJ, "", "", {
+                            {RPCResult::Type::STR_HEX, "txid", "The transaction id"},
+                            {RPCResult::Type::NUM, "index", "The spending input index"},
+                            {RPCResult::Type::NUM, "height", "The height of the block containing the spending tx, -1 if it is in the mempool"},
+                        }
+                    },
+                    RPCResult{"For an array of outputs",
+                        RPCResult::Type::ARR, "", "", {
+                            {RPCResult::Type::OBJ, "", "The spending input, or null if the output is not spent", {
+                                {RPCResult::Type::ELISION, "", "Same as for a single output"},
+                            }, /*skip_type_check=*/true},
+                        }
+                    },
                 },
                 RPCExamples{
             HelpExampleCli("getspentinfo", "'{\"txid\": \"0437cd7f8525ceed2324359c2d0ba26006d92d856a9c20fa0241106ee5a597c9\", \"index\": 0}'") +
+            HelpExampleCli("getspentinfo", "'[{\"txid\": \"0437cd7f8525ceed2324359c2d0ba26006d92d856a9c20fa0241106ee5a597c9\", \"index\": 0}, {\"txid\": \"0437cd7f8525ceed2324359c2d0ba26006d92d856a9c20fa0241106ee5a597c9\", \"index\": 1}]'") +
             "\nAs a JSON-RPC call\n"
             + HelpExampleRpc("getspentinfo", "{\"txid\": \"0437cd7f8525ceed2324359c2d0ba26006d92d856a9c20fa0241106ee5a597c9\", \"index\": 0}")
                 },
@@ -891,31 +1022,45 @@ static RPCHelpMan getspentinfo()
 {
     node::NodeContext &node = EnsureAnyNodeContext(request.context);
     const CTxMemPool& mempool = EnsureMemPool(node);
-    ChainstateManager &chainman = EnsureChainman(node);
-
-    UniValue txidValue = find_value(request.params[0].get_obj(), "txid");
-    UniValue indexValue = find_value(request.params[0].get_obj(), "index");
 
-    if (!txidValue.isStr() || !indexValue.isNum()) {
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid txid or index");
+    if (!g_spent_index) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Spent index is not enabled.");
     }
+    EnsureIndexSynced(*g_spent_index);
+
+    if (!request.params[0].isArray()) {
+        CSpentIndexKey key = SpentIndexKeyFromValue(request.params[0]);
+        CSpentIndexValue value;
 
-    uint256 txid = ParseHashV(txidValue, "txid");
-    int outputIndex = indexValue.getInt<int>();
+        if (!GetSpentIndex(key, value, &mempool)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unable to get spent info");
+        }
 
-    CSpentIndexKey key(txid, outputIndex);
-    CSpentIndexValue value;
+        return SpentIndexValueToJSON(value);
+    }
 
-    if (!GetSpentIndex(chainman, key, value, &mempool)) {
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unable to get spent info");
+    const UniValue& inputs = request.params[0].get_array();
+    if (inputs.size() > MAX_SPENT_INFO_BATCH_SIZE) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("At most %u outputs can be looked up at once", MAX_SPENT_INFO_BATCH_SIZE));
+    }
+    std::vector<CSpentIndexKey> keys;
+    keys.reserve(inputs.size());
+    for (const UniValue& input : inputs.getValues()) {
+        keys.push_back(SpentIndexKeyFromValue(input));
     }
 
-    UniValue obj(UniValue::VOBJ);
-    obj.pushKV("txid", value.txid.GetHex());
-    obj.pushKV("index", int(value.inputIndex));
-    obj.pushKV("height", value.blockHeight);
+    // spends in the mempool take precedence, as in GetSpentIndex
+    std::vector<std::optional<CSpentIndexValue>> values;
+    if (!g_spent_index->ReadSpentIndex(keys, values)) {
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read spent index");
+    }
+    mempool.getSpentIndex(keys, values);
 
-    return obj;
+    UniValue result(UniValue::VARR);
+    for (const auto& value : values) {
+        result.push_back(value ? SpentIndexValueToJSON(*value) : NullUniValue);
+    }
+    return result;
 },
     };
 }
@@ -33,13 +33,16 @@
 #include <util/strencodings.h>
 #include <util/string.h>
 #include <util/system.h>
+#include <util/threadnames.h>
 #include <util/translation.h>
 #include <validation.h>
 #include <validationinterface.h>
 #include <warnings.h>
 
+#include <atomic>
 #include <memory>
 #include <stdint.h>
+#include <thread>
 
 using node::BlockAssembler;
 using node::CBlockTemplate;
@@ -115,14 +118,76 @@ static RPCHelpMan getnetworkhashps()
     };
 }
 
-static bool GenerateBlock(ChainstateManager& chainman, CBlock& block, uint64_t& max_tries, std::shared_ptr<const CBlock>& block_out, bool process_new_block)
+/* YespowerSugar */
+/** Number of threads the generate RPCs search nonces on (-genproclimit, 0 = all cores). */
+static int GetGenerateThreads(const NodeContext& node)
+{
+    const int threads{static_cast<int>(EnsureArgsman(node).GetIntArg("-genproclimit", DEFAULT_GENERATE_THREADS))};
+    return threads > 0 ? threads : std::max(GetNumCores(), 1);
+}
+
+/* YespowerSugar */
+/**
+ * Search the nonces in [header.nNonce, end) for one that satisfies the
+ * header's PoW target, on num_threads threads. Nonces are handed out in
+ * increasing order and threads only stop once everything below the best
+ * nonce found has been tried, so the result is the lowest valid nonce,
+ * exactly as with a serial search.
+ *
+ * @returns the lowest valid nonce, or end if there is none (or shutdown was requested)
+ */
+static uint64_t GrindNonce(const CBlockHeaderUncached& header, uint64_t end, int num_threads, const Consensus::Params& consensus)
+{
+    // Hand out nonces in small batches, short enough that all threads get
+    // work on easy targets.
+    static constexpr uint64_t NONCE_BATCH_SIZE{16};
+    const uint64_t batch_size{std::max<uint64_t>(NONCE_BATCH_SIZE / num_threads, 1)};
+    std::atomic<uint64_t> next{header.nNonce};
+    std::atomic<uint64_t> best{end};
+
+    auto worker = [&] {
+        CBlockHeaderUncached candidate{header};
+        while (!ShutdownRequested()) {
+            const uint64_t start{next.fetch_add(batch_size)};
+            const uint64_t limit{best.load()};
+            if (start >= limit) break;
+
+            for (uint64_t nonce = start; nonce < std::min(start + batch_size, limit); ++nonce) {
+                candidate.nNonce = nonce;
+                if (CheckProofOfWork(candidate.GetPoWHash(), header.nBits, consensus)) {
+                    uint64_t current{best.load()};
+                    while (nonce < current && !best.compare_exchange_weak(current, nonce)) {}
+                    break;
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int n = 1; n < num_threads; ++n) {
+        threads.emplace_back([&worker, n] {
+            util::ThreadRename(strprintf("grind.%i", n));
+            worker();
+        });
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return best.load();
+}
+
+static bool GenerateBlock(ChainstateManager& chainman, CBlock& block, uint64_t& max_tries, std::shared_ptr<const CBlock>& block_out, bool process_new_block, int num_threads)
 {
     block_out.reset();
     block.hashMerkleRoot = BlockMerkleRoot(block);
 
-    while (max_tries > 0 && block.nNonce < std::numeric_limits<uint32_t>::max() && !CheckProofOfWork(block.GetPoWHash(), block.nBits, chainman.GetConsensus()) && !ShutdownRequested()) {
-        ++block.nNonce;
-        --max_tries;
+    /* YespowerSugar */
+    if (max_tries > 0 && block.nNonce < std::numeric_limits<uint32_t>::max() && !ShutdownRequested()) {
+        const uint64_t start{block.nNonce};
+        const uint64_t end{start + std::min<uint64_t>(max_tries, std::numeric_limits<uint32_t>::max() - start)};
+        block.nNonce = GrindNonce(block, end, num_threads, chainman.GetConsensus());
+        max_tries -= block.nNonce - start;
     }
     if (max_tries == 0 || ShutdownRequested()) {
         return false;
@@ -142,7 +207,7 @@ static bool GenerateBlock(ChainstateManager& chainman, CBlock& block, uint64_t&
     return true;
 }
 
-static UniValue generateBlocks(ChainstateManager& chainman, const CTxMemPool& mempool, const CScript& coinbase_script, int nGenerate, uint64_t nMaxTries)
+static UniValue generateBlocks(ChainstateManager& chainman, const CTxMemPool& mempool, const CScript& coinbase_script, int nGenerate, uint64_t nMaxTries, int num_threads)
 {
     UniValue blockHashes(UniValue::VARR);
     while (nGenerate > 0 && !ShutdownRequested()) {
@@ -151,7 +216,7 @@ static UniValue generateBlocks(ChainstateManager& chainman, const CTxMemPool& me
             throw JSONRPCError(RPC_INTERNAL_ERROR, "Couldn't create new block");
 
         std::shared_ptr<const CBlock> block_out;
-        if (!GenerateBlock(chainman, pblocktemplate->block, nMaxTries, block_out, /*process_new_block=*/true)) {
+        if (!GenerateBlock(chainman, pblocktemplate->block, nMaxTries, block_out, /*process_new_block=*/true, num_threads)) {
             break;
         }
 
@@ -230,7 +295,7 @@ static RPCHelpMan generatetodescriptor()
     const CTxMemPool& mempool = EnsureMemPool(node);
     ChainstateManager& chainman = EnsureChainman(node);
 
-    return generateBlocks(chainman, mempool, coinbase_script, num_blocks, max_tries);
+    return generateBlocks(chainman, mempool, coinbase_script, num_blocks, max_tries, GetGenerateThreads(node));
 },
     };
 }
@@ -278,7 +343,7 @@ static RPCHelpMan generatetoaddress()
 
     CScript coinbase_script = GetScriptForDestination(destination);
 
-    return generateBlocks(chainman, mempool, coinbase_script, num_blocks, max_tries);
+    return generateBlocks(chainman, mempool, coinbase_script, num_blocks, max_tries, GetGenerateThreads(node));
 },
     };
 }
@@ -383,7 +448,7 @@ static RPCHelpMan generateblock()
     std::shared_ptr<const CBlock> block_out;
     uint64_t max_tries{DEFAULT_MAX_TRIES};
 
-    if (!GenerateBlock(chainman, block, max_tries, block_out, process_new_block) || !block_out) {
+    if (!GenerateBlock(chainman, block, max_tries, block_out, process_new_block, GetGenerateThreads(node)) || !block_out) {
         throw JSONRPCError(RPC_MISC_ERROR, "Failed to make block.");
     }
 
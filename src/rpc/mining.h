@@ -8,4 +8,7 @@
 /** Default max iterations to try in RPC generatetodescriptor, generatetoaddress, and generateblock. */
 static const uint64_t DEFAULT_MAX_TRIES{1000000};
 
+/** Default for -genproclimit, the number of threads those RPCs search nonces on (0 = all cores). */
+static const int DEFAULT_GENERATE_THREADS{1};
+
 #endif // BITCOIN_RPC_MINING_H
@@ -7,9 +7,56 @@
 #define BITCOIN_SPENTINDEX_H
 
 #include <uint256.h>
+#include <compressor.h>
 #include <consensus/amount.h>
+#include <crypto/siphash.h>
+#include <random.h>
 #include <script/script.h>
 #include <serialize.h>
+#include <span.h>
+
+// Sugar: Addressindex
+enum AddressIndexType {
+    ADDR_INDT_UNKNOWN                = 0,
+    ADDR_INDT_PUBKEY_ADDRESS         = 1,
+    ADDR_INDT_SCRIPT_ADDRESS         = 2,
+    ADDR_INDT_WITNESS_V0_KEYHASH     = 5,
+    ADDR_INDT_WITNESS_V0_SCRIPTHASH  = 6,
+    ADDR_INDT_WITNESS_V1_TAPROOT     = 7
+};
+
+/** Number of bytes of the address hash that are used by an address type */
+inline size_t AddressHashSize(unsigned int type)
+{
+    switch (type) {
+    case ADDR_INDT_PUBKEY_ADDRESS:
+    case ADDR_INDT_SCRIPT_ADDRESS:
+    case ADDR_INDT_WITNESS_V0_KEYHASH:
+        return 20;
+    default:
+        return 32;
+    }
+}
+
+/**
+ * The index databases store an address as its type in one byte, followed by
+ * only the bytes of the hash that the type uses. The remaining bytes of a
+ * 20 byte hash are zero in memory.
+ */
+template <typename Stream>
+void SerializeAddress(Stream& s, unsigned int type, const uint256& hash)
+{
+    ser_writedata8(s, type);
+    s.write(AsBytes(Span{hash.begin(), AddressHashSize(type)}));
+}
+
+template <typename Stream>
+void UnserializeAddress(Stream& s, unsigned int& type, uint256& hash)
+{
+    type = ser_readdata8(s);
+    hash.SetNull();
+    s.read(AsWritableBytes(Span{hash.begin(), AddressHashSize(type)}));
+}
 
 struct CSpentIndexKey {
     uint256 txid;
@@ -17,7 +64,7 @@ struct CSpentIndexKey {
 
     SERIALIZE_METHODS(CSpentIndexKey, obj)
     {
-        READWRITE(obj.txid, obj.outputIndex);
+        READWRITE(obj.txid, VARINT(obj.outputIndex));
     }
 
     CSpentIndexKey(uint256 t, unsigned int i) {
@@ -34,6 +81,23 @@ struct CSpentIndexKey {
         outputIndex = 0;
     }
 
+    friend bool operator==(const CSpentIndexKey& a, const CSpentIndexKey& b) {
+        return a.txid == b.txid && a.outputIndex == b.outputIndex;
+    }
+};
+
+/** Salted hasher for the spent outputs in the mempool */
+class CSpentIndexKeyHasher
+{
+private:
+    const uint64_t k0, k1;
+
+public:
+    CSpentIndexKeyHasher() : k0{GetRand<uint64_t>()}, k1{GetRand<uint64_t>()} {}
+
+    size_t operator()(const CSpentIndexKey& key) const noexcept {
+        return SipHashUint256Extra(k0, k1, key.txid, key.outputIndex);
+    }
 };
 
 struct CSpentIndexValue {
@@ -44,9 +108,18 @@ struct CSpentIndexValue {
     int addressType;
     uint256 addressHash;
 
-    SERIALIZE_METHODS(CSpentIndexValue, obj)
-    {
-        READWRITE(obj.txid, obj.inputIndex, obj.blockHeight, obj.satoshis, obj.addressType, obj.addressHash);
+    template <typename Stream>
+    void Serialize(Stream& s) const {
+        s << txid << VARINT(inputIndex) << VARINT_MODE(blockHeight, VarIntMode::NONNEGATIVE_SIGNED) << Using<AmountCompression>(satoshis);
+        SerializeAddress(s, addressType, addressHash);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s) {
+        s >> txid >> VARINT(inputIndex) >> VARINT_MODE(blockHeight, VarIntMode::NONNEGATIVE_SIGNED) >> Using<AmountCompression>(satoshis);
+        unsigned int type;
+        UnserializeAddress(s, type, addressHash);
+        addressType = type;
     }
 
     CSpentIndexValue(uint256 t, unsigned int i, int h, CAmount s, int type, uint256 a) {
@@ -92,53 +165,22 @@ struct CSpentIndexTxInfo
     std::map<CSpentIndexKey, CSpentIndexValue, CSpentIndexKeyCompare> mSpentInfo;
 };
 
-struct CTimestampIndexIteratorKey {
-    unsigned int timestamp;
-
-    SERIALIZE_METHODS(CTimestampIndexIteratorKey, obj) { READWRITE(obj.timestamp); }
-
-    CTimestampIndexIteratorKey(unsigned int time) {
-        timestamp = time;
-    }
-
-    CTimestampIndexIteratorKey() {
-        SetNull();
-    }
-
-    void SetNull() {
-        timestamp = 0;
-    }
-};
-
-struct CTimestampIndexKey {
-    unsigned int timestamp;
-    uint256 blockHash;
-
-    SERIALIZE_METHODS(CTimestampIndexKey, obj) { READWRITE(obj.timestamp, obj.blockHash); }
-
-    CTimestampIndexKey(unsigned int time, uint256 hash) {
-        timestamp = time;
-        blockHash = hash;
-    }
-
-    CTimestampIndexKey() {
-        SetNull();
-    }
-
-    void SetNull() {
-        timestamp = 0;
-        blockHash.SetNull();
-    }
-};
-
 struct CAddressUnspentKey {
     unsigned int type;
     uint256 hashBytes;
     uint256 txhash;
     unsigned int index;
 
-    SERIALIZE_METHODS(CAddressUnspentKey, obj) {
-        READWRITE(obj.type, obj.hashBytes, obj.txhash, obj.index);
+    template <typename Stream>
+    void Serialize(Stream& s) const {
+        SerializeAddress(s, type, hashBytes);
+        s << txhash << VARINT(index);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s) {
+        UnserializeAddress(s, type, hashBytes);
+        s >> txhash >> VARINT(index);
     }
 
     CAddressUnspentKey(unsigned int addressType, uint256 addressHash, uint256 txid, unsigned int indexValue) {
@@ -152,6 +194,10 @@ struct CAddressUnspentKey {
         SetNull();
     }
 
+    friend bool operator==(const CAddressUnspentKey& a, const CAddressUnspentKey& b) {
+        return a.type == b.type && a.hashBytes == b.hashBytes && a.txhash == b.txhash && a.index == b.index;
+    }
+
     void SetNull() {
         type = 0;
         hashBytes.SetNull();
@@ -167,7 +213,7 @@ struct CAddressUnspentValue {
 
     SERIALIZE_METHODS(CAddressUnspentValue, obj)
     {
-        READWRITE(obj.satoshis, obj.script, obj.blockHeight);
+        READWRITE(Using<AmountCompression>(obj.satoshis), Using<ScriptCompression>(obj.script), VARINT_MODE(obj.blockHeight, VarIntMode::NONNEGATIVE_SIGNED));
     }
 
     CAddressUnspentValue(CAmount sats, CScript scriptPubKey, int height) {
@@ -200,7 +246,22 @@ struct CAddressIndexKey {
     unsigned int index;
     bool spending;
 
-    SERIALIZE_METHODS(CAddressIndexKey, obj) {READWRITE(obj.type, obj.hashBytes, obj.blockHeight, obj.txindex, obj.txhash, obj.index, obj.spending);}
+    // The height is big endian so the entries of an address sort by height.
+    // Varints keep their order up to 16511, more than the positions within a
+    // block that are used in practice.
+    template <typename Stream>
+    void Serialize(Stream& s) const {
+        SerializeAddress(s, type, hashBytes);
+        ser_writedata32be(s, blockHeight);
+        s << VARINT(txindex) << txhash << VARINT(index) << spending;
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s) {
+        UnserializeAddress(s, type, hashBytes);
+        blockHeight = ser_readdata32be(s);
+        s >> VARINT(txindex) >> txhash >> VARINT(index) >> spending;
+    }
 
     CAddressIndexKey(unsigned int addressType, uint256 addressHash, int height, int blockindex,
                      uint256 txid, unsigned int indexValue, bool isSpending) {
@@ -217,6 +278,11 @@ struct CAddressIndexKey {
         SetNull();
     }
 
+    friend bool operator==(const CAddressIndexKey& a, const CAddressIndexKey& b) {
+        return a.type == b.type && a.hashBytes == b.hashBytes && a.blockHeight == b.blockHeight && a.txindex == b.txindex &&
+               a.txhash == b.txhash && a.index == b.index && a.spending == b.spending;
+    }
+
     void SetNull() {
         type = 0;
         hashBytes.SetNull();
@@ -233,7 +299,15 @@ struct CAddressIndexIteratorKey {
     unsigned int type;
     uint256 hashBytes;
 
-    SERIALIZE_METHODS(CAddressIndexIteratorKey, obj) {READWRITE(obj.type, obj.hashBytes);}
+    template <typename Stream>
+    void Serialize(Stream& s) const {
+        SerializeAddress(s, type, hashBytes);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s) {
+        UnserializeAddress(s, type, hashBytes);
+    }
 
     CAddressIndexIteratorKey(unsigned int addressType, uint256 addressHash) {
         type = addressType;
@@ -255,7 +329,17 @@ struct CAddressIndexIteratorHeightKey {
     uint256 hashBytes;
     int blockHeight;
 
-    SERIALIZE_METHODS(CAddressIndexIteratorHeightKey, obj) {READWRITE(obj.type, obj.hashBytes, obj.blockHeight);}
+    template <typename Stream>
+    void Serialize(Stream& s) const {
+        SerializeAddress(s, type, hashBytes);
+        ser_writedata32be(s, blockHeight);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s) {
+        UnserializeAddress(s, type, hashBytes);
+        blockHeight = ser_readdata32be(s);
+    }
 
     CAddressIndexIteratorHeightKey(unsigned int addressType, uint256 addressHash, int height) {
         type = addressType;
@@ -274,4 +358,64 @@ struct CAddressIndexIteratorHeightKey {
     }
 };
 
+struct CAddressBalanceValue {
+    CAmount balance;
+    CAmount received;
+    int64_t txCount;
+
+    SERIALIZE_METHODS(CAddressBalanceValue, obj) { READWRITE(obj.balance, obj.received, obj.txCount); }
+
+    CAddressBalanceValue() {
+        SetNull();
+    }
+
+    void SetNull() {
+        balance = 0;
+        received = 0;
+        txCount = 0;
+    }
+
+    CAddressBalanceValue& operator+=(const CAddressBalanceValue& other) {
+        balance += other.balance;
+        received += other.received;
+        txCount += other.txCount;
+        return *this;
+    }
+};
+
+struct CAddressCoinbaseKey {
+    unsigned int type;
+    uint256 hashBytes;
+    int blockHeight;
+
+    // The height is big endian so the entries of an address sort by height
+    template <typename Stream>
+    void Serialize(Stream& s) const {
+        SerializeAddress(s, type, hashBytes);
+        ser_writedata32be(s, blockHeight);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s) {
+        UnserializeAddress(s, type, hashBytes);
+        blockHeight = ser_readdata32be(s);
+    }
+
+    CAddressCoinbaseKey(unsigned int addressType, uint256 addressHash, int height) {
+        type = addressType;
+        hashBytes = addressHash;
+        blockHeight = height;
+    }
+
+    CAddressCoinbaseKey() {
+        SetNull();
+    }
+
+    void SetNull() {
+        type = 0;
+        hashBytes.SetNull();
+        blockHeight = 0;
+    }
+};
+
 #endif // BITCOIN_SPENTINDEX_H
\ No newline at end of file
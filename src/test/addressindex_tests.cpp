@@ -0,0 +1,257 @@
+// Copyright (c) 2023 The Sugarchain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/addressindex.h>
+#include <interfaces/chain.h>
+#include <key.h>
+#include <script/standard.h>
+#include <spentindex.h>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+#include <util/time.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <tuple>
+#include <vector>
+
+/** Runs the steps of a filter rebuild one at a time */
+struct AddressIndexTest {
+    AddressIndex& index;
+
+    /// Mark a rebuild as running, without building the filter yet
+    void BeginRebuild()
+    {
+        LOCK(index.m_filter_mutex);
+        index.m_filter_rebuilding = true;
+    }
+
+    std::unique_ptr<AddressFilter> BuildFilter() const { return index.BuildFilter(0); }
+
+    void FinishRebuild(std::unique_ptr<AddressFilter> filter) { index.FinishFilterRebuild(std::move(filter)); }
+
+    /// Rebuild the filter on its thread
+    void StartRebuild()
+    {
+        LOCK(index.m_filter_mutex);
+        index.StartFilterRebuild(0);
+    }
+
+    bool IsRebuilding() const { return WITH_LOCK(index.m_filter_mutex, return index.m_filter_rebuilding); }
+
+    const AddressFilter* GetFilter() const { return WITH_LOCK(index.m_filter_mutex, return index.m_filter.get()); }
+};
+
+BOOST_FIXTURE_TEST_SUITE(addressindex_tests, BasicTestingSetup)
+
+/** A hash of the size used by the address type, zero padded like ExtractIndexInfo */
+static uint256 RandomAddressHash(unsigned int type)
+{
+    const uint256 random{InsecureRand256()};
+    uint256 hash;
+    std::copy(random.begin(), random.begin() + AddressHashSize(type), hash.begin());
+    return hash;
+}
+
+BOOST_AUTO_TEST_CASE(address_filter)
+{
+    const uint32_t n_pages{AddressFilter::PagesFor(40000)};
+    AddressFilter filter{InsecureRandBits(64), InsecureRandBits(64), n_pages};
+    // a new filter is stored in full
+    BOOST_CHECK_EQUAL(filter.GetDirtyPages().size(), n_pages);
+    filter.ClearDirtyPages(AddressFilter::DirtyPages{filter.GetDirtyPages()});
+    BOOST_CHECK(filter.GetDirtyPages().empty());
+
+    std::vector<std::pair<int, uint256>> addresses;
+    for (int i = 0; i < 40000; ++i) {
+        const int type{i % 2 ? ADDR_INDT_PUBKEY_ADDRESS : ADDR_INDT_WITNESS_V1_TAPROOT};
+        addresses.emplace_back(type, RandomAddressHash(type));
+        filter.Insert(type, addresses.back().second);
+    }
+    // the filter has room for twice the addresses it was sized for
+    BOOST_CHECK(!filter.IsFull());
+    // an address whose bits were all set already is not counted
+    BOOST_CHECK(filter.GetCount() > 39900 && filter.GetCount() <= 40000);
+    for (const auto& [type, hash] : addresses) {
+        BOOST_CHECK(filter.MayContain(type, hash));
+    }
+    // the same hash of another address type is another address
+    unsigned int false_positives{0};
+    for (const auto& [type, hash] : addresses) {
+        if (filter.MayContain(ADDR_INDT_SCRIPT_ADDRESS, hash)) ++false_positives;
+    }
+    BOOST_CHECK_LT(false_positives, 400U);
+
+    // a filter restored from its pages holds the same addresses
+    const AddressFilter::DirtyPages dirty{filter.GetDirtyPages()};
+    BOOST_CHECK(!dirty.empty() && dirty.rbegin()->first < n_pages);
+    filter.ClearDirtyPages(dirty);
+    BOOST_CHECK(filter.GetDirtyPages().empty());
+    AddressFilter restored{filter.GetK0(), filter.GetK1(), filter.GetNumPages()};
+    for (uint32_t page = 0; page < filter.GetNumPages(); ++page) {
+        BOOST_CHECK(restored.LoadPage(page, filter.GetPage(page)));
+    }
+    BOOST_CHECK(!restored.LoadPage(n_pages, filter.GetPage(0)));
+    restored.LoadCount(filter.GetCount());
+    for (const auto& [type, hash] : addresses) {
+        BOOST_CHECK(restored.MayContain(type, hash));
+    }
+
+    // an address changes at most a single page
+    filter.Insert(ADDR_INDT_SCRIPT_ADDRESS, RandomAddressHash(ADDR_INDT_SCRIPT_ADDRESS));
+    BOOST_CHECK_LE(filter.GetDirtyPages().size(), 1U);
+    while (filter.GetDirtyPages().empty()) {
+        filter.Insert(ADDR_INDT_SCRIPT_ADDRESS, RandomAddressHash(ADDR_INDT_SCRIPT_ADDRESS));
+    }
+    // a page that changes again before the commit that wrote it completes stays dirty
+    const AddressFilter::DirtyPages written{filter.GetDirtyPages()};
+    const auto [page, change] = *written.begin();
+    while (filter.GetDirtyPages().at(page) == change) {
+        filter.Insert(ADDR_INDT_SCRIPT_ADDRESS, RandomAddressHash(ADDR_INDT_SCRIPT_ADDRESS));
+    }
+    filter.ClearDirtyPages(written);
+    BOOST_CHECK(filter.GetDirtyPages().count(page));
+    for (int i = 0; i < 50000; ++i) {
+        filter.Insert(ADDR_INDT_PUBKEY_ADDRESS, RandomAddressHash(ADDR_INDT_PUBKEY_ADDRESS));
+    }
+    BOOST_CHECK(filter.IsFull());
+}
+
+BOOST_FIXTURE_TEST_CASE(address_filter_rebuild, TestChain100Setup)
+{
+    AddressIndex index{interfaces::MakeChain(m_node), 1 << 20, 1 << 20, /*f_memory=*/true};
+    BOOST_REQUIRE(index.Start());
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+
+    const auto mine_to{[&](const CKey& key) {
+        const CBlock block{CreateAndProcessBlock({}, GetScriptForDestination(PKHash(key.GetPubKey())))};
+        BOOST_REQUIRE(index.BlockUntilSyncedToCurrentChain());
+        return block.vtx[0]->vout[0].nValue;
+    }};
+    const auto check_received{[&](const CKey& key, CAmount amount) {
+        const auto address{ExtractIndexAddress(PKHash(key.GetPubKey()))};
+        BOOST_REQUIRE(address);
+        CAddressBalanceValue balance;
+        BOOST_CHECK(index.ReadAddressBalance(address->second, address->first, balance));
+        BOOST_CHECK_EQUAL(balance.received, amount);
+        BOOST_CHECK_EQUAL(balance.txCount, amount ? 1 : 0);
+    }};
+
+    CKey old_key, new_key, unused_key;
+    old_key.MakeNewKey(true);
+    new_key.MakeNewKey(true);
+    unused_key.MakeNewKey(true);
+    const CAmount old_amount{mine_to(old_key)};
+
+    // the new filter is built from the addresses stored before a block with a
+    // new address is appended, and lookups keep using the old filter meanwhile
+    AddressIndexTest test{index};
+    const AddressFilter* old_filter{test.GetFilter()};
+    BOOST_REQUIRE(old_filter);
+    test.BeginRebuild();
+    auto filter{test.BuildFilter()};
+    BOOST_REQUIRE(filter);
+    const CAmount new_amount{mine_to(new_key)};
+    BOOST_CHECK(test.IsRebuilding());
+    BOOST_CHECK_EQUAL(test.GetFilter(), old_filter);
+    check_received(old_key, old_amount);
+    check_received(new_key, new_amount);
+    check_received(unused_key, 0);
+
+    // the address appended meanwhile is added to the new filter
+    test.FinishRebuild(std::move(filter));
+    BOOST_CHECK(!test.IsRebuilding());
+    BOOST_CHECK(test.GetFilter() != old_filter);
+    check_received(old_key, old_amount);
+    check_received(new_key, new_amount);
+    check_received(unused_key, 0);
+
+    // and so is one appended while the filter is rebuilt on its thread
+    CKey next_key;
+    next_key.MakeNewKey(true);
+    test.StartRebuild();
+    const CAmount next_amount{mine_to(next_key)};
+    check_received(next_key, next_amount);
+    time_start = GetTimeMillis();
+    while (test.IsRebuilding()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        UninterruptibleSleep(std::chrono::milliseconds{10});
+    }
+    check_received(old_key, old_amount);
+    check_received(new_key, new_amount);
+    check_received(next_key, next_amount);
+    check_received(unused_key, 0);
+
+    // shutdown sequence (c.f. Shutdown() in init.cpp)
+    SyncWithValidationInterfaceQueue();
+    index.Stop();
+}
+
+BOOST_FIXTURE_TEST_CASE(address_block_deltas, TestChain100Setup)
+{
+    AddressIndex index{interfaces::MakeChain(m_node), 1 << 20, 1 << 20, /*f_memory=*/true};
+    // called on the validation notification thread
+    Mutex mutex;
+    std::vector<std::tuple<uint256, bool, AddressIndex::BalanceDeltas>> notified;
+    index.SetBlockDeltasNotifier([&](const uint256& block_hash, bool connected, const AddressIndex::BalanceDeltas& deltas) {
+        LOCK(mutex);
+        notified.emplace_back(block_hash, connected, deltas);
+    });
+    BOOST_REQUIRE(index.Start());
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+    // the blocks indexed while catching up are not passed on
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK(WITH_LOCK(mutex, return notified.empty()));
+
+    CKey key;
+    key.MakeNewKey(true);
+    const auto address{ExtractIndexAddress(PKHash(key.GetPubKey()))};
+    BOOST_REQUIRE(address);
+    const CBlock block{CreateAndProcessBlock({}, GetScriptForDestination(PKHash(key.GetPubKey())))};
+    const CAmount amount{block.vtx[0]->vout[0].nValue};
+    BOOST_REQUIRE(index.BlockUntilSyncedToCurrentChain());
+    SyncWithValidationInterfaceQueue();
+    {
+        LOCK(mutex);
+        BOOST_REQUIRE_EQUAL(notified.size(), 1U);
+        const auto& [hash, connected, deltas] = notified[0];
+        BOOST_CHECK_EQUAL(hash, block.GetHash());
+        BOOST_CHECK(connected);
+        BOOST_CHECK_EQUAL(deltas.at(*address).balance, amount);
+        BOOST_CHECK_EQUAL(deltas.at(*address).txCount, 1);
+    }
+
+    // a disconnected block passes on the changes that were reverted
+    BlockValidationState state;
+    CBlockIndex* tip{WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip())};
+    BOOST_REQUIRE(m_node.chainman->ActiveChainstate().InvalidateBlock(state, tip));
+    SyncWithValidationInterfaceQueue();
+    {
+        LOCK(mutex);
+        BOOST_REQUIRE_EQUAL(notified.size(), 2U);
+        const auto& [hash, connected, deltas] = notified[1];
+        BOOST_CHECK_EQUAL(hash, block.GetHash());
+        BOOST_CHECK(!connected);
+        BOOST_CHECK_EQUAL(deltas.at(*address).balance, -amount);
+        BOOST_CHECK_EQUAL(deltas.at(*address).txCount, -1);
+    }
+
+    // shutdown sequence (c.f. Shutdown() in init.cpp)
+    SyncWithValidationInterfaceQueue();
+    index.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
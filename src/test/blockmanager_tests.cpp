@@ -5,15 +5,19 @@
 #include <chainparams.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
+#include <pow.h>
+#include <txdb.h>
 #include <validation.h>
 
 #include <boost/test/unit_test.hpp>
+#include <test/util/random.h>
 #include <test/util/setup_common.h>
 
 using node::BlockManager;
 using node::BLOCK_SERIALIZATION_HEADER_SIZE;
 using node::MAX_BLOCKFILE_SIZE;
 using node::OpenBlockFile;
+using node::ReadBlockFromDisk;
 
 // use BasicTestingSetup here for the data directory configuration, setup, and cleanup
 BOOST_FIXTURE_TEST_SUITE(blockmanager_tests, BasicTestingSetup)
@@ -82,4 +86,212 @@ BOOST_FIXTURE_TEST_CASE(blockmanager_scan_unlink_already_pruned_files, TestChain
     BOOST_CHECK(!AutoFile(OpenBlockFile(new_pos, true)).IsNull());
 }
 
+BOOST_AUTO_TEST_CASE(blockmanager_read_block_skips_checked_pow)
+{
+    const auto params {CreateChainParams(ArgsManager{}, CBaseChainParams::MAIN)};
+    const Consensus::Params& consensus{params->GetConsensus()};
+    BlockManager blockman{{}};
+    CChain chain {};
+
+    // A block whose header doesn't satisfy its own nBits
+    CBlock block{params->GenesisBlock()};
+    block.nNonce += 1;
+    BOOST_REQUIRE(!CheckProofOfWork(block.GetPoWHash(), block.nBits, consensus));
+    const uint256 hash{block.GetHash()};
+    const FlatFilePos pos{blockman.SaveBlockToDisk(block, 0, chain, *params, nullptr)};
+
+    CBlock read;
+    BOOST_CHECK(!ReadBlockFromDisk(read, pos, consensus));
+    BOOST_CHECK(ReadBlockFromDisk(read, pos, consensus, /*fCheckPOW=*/false));
+    BOOST_CHECK_EQUAL(read.GetHash(), hash);
+
+    CBlockIndex index{block};
+    index.phashBlock = &hash;
+    {
+        LOCK(cs_main);
+        index.nFile = pos.nFile;
+        index.nDataPos = pos.nPos;
+        index.nStatus = BLOCK_HAVE_DATA;
+    }
+    // Entries that never passed header validation still get their PoW checked
+    BOOST_CHECK(!ReadBlockFromDisk(read, &index, consensus));
+
+    // BLOCK_VALID_TREE doesn't mean the PoW was checked, since headers skip
+    // CheckBlockHeader during initial block download
+    WITH_LOCK(cs_main, index.RaiseValidity(BLOCK_VALID_TREE));
+    BOOST_CHECK(!ReadBlockFromDisk(read, &index, consensus));
+
+    // BLOCK_VALID_TRANSACTIONS means the block passed CheckBlock, so it isn't recomputed
+    WITH_LOCK(cs_main, index.RaiseValidity(BLOCK_VALID_TRANSACTIONS));
+    BOOST_CHECK(ReadBlockFromDisk(read, &index, consensus));
+    BOOST_CHECK_EQUAL(read.GetHash(), hash);
+}
+
+/** Add a main chain of 600 blocks to blockman, with forks branching off at
+ *  several heights so that some skip pointers land on heights with more than
+ *  one block. Returns the main chain. */
+static std::vector<CBlockIndex*> BuildBlockTree(BlockManager& blockman, const CChainParams& params) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    CBlockIndex* best_header{nullptr};
+    CBlockHeader header{params.GenesisBlock().GetBlockHeader()};
+    std::vector<CBlockIndex*> tips{blockman.AddToBlockIndex(header, best_header)};
+    std::vector<CBlockIndex*> main_chain{tips.front()};
+    for (int height = 1; height <= 600; ++height) {
+        for (CBlockIndex*& tip : tips) {
+            header.hashPrevBlock = tip->GetBlockHash();
+            header.nTime = tip->nTime + 5;
+            ++header.nNonce;
+            tip = blockman.AddToBlockIndex(header, best_header);
+        }
+        main_chain.push_back(tips.front());
+        if (height == 100 || height == 257 || height == 511) {
+            tips.push_back(tips.front()->pprev);
+        }
+    }
+    return main_chain;
+}
+
+/** Check that every entry of expected was loaded into reloaded with the same contents. */
+static void CheckReloadedBlockIndex(const BlockManager& expected, BlockManager& reloaded) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    BOOST_REQUIRE_EQUAL(reloaded.m_block_index.size(), expected.m_block_index.size());
+    const auto hash_of{[](const CBlockIndex* pindex) { return pindex ? pindex->GetBlockHash() : uint256{}; }};
+    for (const auto& [hash, entry] : expected.m_block_index) {
+        const CBlockIndex* pindex{reloaded.LookupBlockIndex(hash)};
+        BOOST_REQUIRE(pindex);
+        BOOST_CHECK_EQUAL(pindex->nHeight, entry.nHeight);
+        BOOST_CHECK_EQUAL(pindex->nStatus, entry.nStatus);
+        BOOST_CHECK_EQUAL(pindex->nTime, entry.nTime);
+        BOOST_CHECK_EQUAL(pindex->nNonce, entry.nNonce);
+        BOOST_CHECK(hash_of(pindex->pprev) == hash_of(entry.pprev));
+        BOOST_CHECK(hash_of(pindex->pskip) == hash_of(entry.pskip));
+        BOOST_CHECK(pindex->nChainWork == entry.nChainWork);
+        BOOST_CHECK(pindex->nChainTargetSum == entry.nChainTargetSum);
+        BOOST_CHECK_EQUAL(pindex->nTimeMax, entry.nTimeMax);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(blockmanager_load_block_index)
+{
+    const auto params{CreateChainParams(ArgsManager{}, CBaseChainParams::MAIN)};
+    BlockManager blockman{{}};
+    BlockManager reloaded{{}};
+    LOCK(cs_main);
+    blockman.m_block_tree_db = std::make_unique<CBlockTreeDB>(DBParams{
+        .path = m_args.GetDataDirNet() / "blocks" / "index",
+        .cache_bytes = 1 << 20,
+        .memory_only = true});
+
+    BuildBlockTree(blockman, *params);
+    BOOST_REQUIRE(blockman.WriteBlockIndexDB());
+
+    reloaded.m_block_tree_db = std::move(blockman.m_block_tree_db);
+    BOOST_REQUIRE(reloaded.LoadBlockIndexDB(params->GetConsensus()));
+    CheckReloadedBlockIndex(blockman, reloaded);
+}
+
+BOOST_AUTO_TEST_CASE(blockmanager_flat_block_index)
+{
+    const auto params{CreateChainParams(ArgsManager{}, CBaseChainParams::MAIN)};
+    const fs::path flat_path{m_args.GetDataDirNet() / "blocks" / "blockindex.dat"};
+    const auto open_db{[&](bool wipe) {
+        return std::make_unique<CBlockTreeDB>(DBParams{
+            .path = m_args.GetDataDirNet() / "blocks" / "index",
+            .cache_bytes = 1 << 20,
+            .wipe_data = wipe});
+    }};
+    BlockManager blockman{{}};
+    LOCK(cs_main);
+    blockman.m_block_tree_db = open_db(/*wipe=*/true);
+    const std::vector<CBlockIndex*> main_chain{BuildBlockTree(blockman, *params)};
+    BOOST_REQUIRE(blockman.WriteBlockIndexDB());
+
+    // Entries are appended in height order, in any number of batches
+    const std::vector<const CBlockIndex*> flat(main_chain.begin(), main_chain.begin() + 200);
+    CBlockTreeDB& db{*blockman.m_block_tree_db};
+    BOOST_CHECK(!db.WriteFlatBlockIndex({flat.begin() + 1, flat.begin() + 120}));
+    BOOST_CHECK(db.WriteFlatBlockIndex({flat.begin(), flat.begin() + 120}));
+    BOOST_CHECK(!db.WriteFlatBlockIndex({flat.begin() + 150, flat.end()}));
+    BOOST_CHECK(db.WriteFlatBlockIndex({flat.begin() + 120, flat.end()}));
+    BOOST_CHECK_EQUAL(db.FlatBlockIndexSize(), 200);
+    BOOST_CHECK(db.FlatBlockIndexTip() == flat.back()->GetBlockHash());
+
+    // An entry that changes after it was moved is written to the database again and wins
+    main_chain[50]->nStatus |= BLOCK_OPT_WITNESS;
+    BOOST_REQUIRE(db.WriteBatchSync({}, 0, {main_chain[50]}));
+
+    // Leftovers of an append that never got committed are ignored
+    {
+        FILE* file{fsbridge::fopen(flat_path, "ab")};
+        BOOST_REQUIRE(file);
+        fputs("garbage", file);
+        fclose(file);
+    }
+
+    blockman.m_block_tree_db.reset();
+    BlockManager reloaded{{}};
+    reloaded.m_block_tree_db = open_db(/*wipe=*/false);
+    BOOST_CHECK_EQUAL(reloaded.m_block_tree_db->FlatBlockIndexSize(), 0);
+    BOOST_CHECK_EQUAL(reloaded.m_block_tree_db->ReadFlatBlockIndexSize(), 200);
+    BOOST_REQUIRE(reloaded.LoadBlockIndexDB(params->GetConsensus()));
+    BOOST_CHECK_EQUAL(reloaded.m_block_tree_db->FlatBlockIndexSize(), 200);
+    CheckReloadedBlockIndex(blockman, reloaded);
+
+    // More appends after a reload continue the same file
+    CBlockTreeDB& reloaded_db{*reloaded.m_block_tree_db};
+    BOOST_CHECK(reloaded_db.WriteFlatBlockIndex({reloaded.LookupBlockIndex(main_chain[200]->GetBlockHash())}));
+    BOOST_CHECK_EQUAL(reloaded_db.FlatBlockIndexSize(), 201);
+
+    // Reindexing wipes the flat file along with the database
+    reloaded.m_block_tree_db.reset();
+    BOOST_CHECK(fs::exists(flat_path));
+    BlockManager wiped{{}};
+    wiped.m_block_tree_db = open_db(/*wipe=*/true);
+    BOOST_CHECK(!fs::exists(flat_path));
+    BOOST_REQUIRE(wiped.LoadBlockIndexDB(params->GetConsensus()));
+    BOOST_CHECK(wiped.m_block_index.empty());
+    BOOST_CHECK_EQUAL(wiped.m_block_tree_db->FlatBlockIndexSize(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(blockmanager_block_map)
+{
+    node::BlockMap map;
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(map.find(uint256::ONE) == map.end());
+
+    // Enough entries to span several chunks and grow the table a few times
+    std::vector<uint256> hashes;
+    std::vector<const CBlockIndex*> entries;
+    for (int i = 0; i < 20000; ++i) {
+        hashes.push_back(InsecureRand256());
+        auto [it, inserted] = map.try_emplace(hashes.back());
+        BOOST_CHECK(inserted);
+        it->second.nHeight = i;
+        entries.push_back(&it->second);
+    }
+    BOOST_CHECK_EQUAL(map.size(), hashes.size());
+
+    // Entries keep their addresses, and inserting an existing hash returns its entry
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        BOOST_CHECK_EQUAL(map.count(hashes[i]), 1U);
+        BOOST_CHECK(&map.find(hashes[i])->second == entries[i]);
+        BOOST_CHECK(&map[hashes[i]] == entries[i]);
+        auto [it, inserted] = map.try_emplace(hashes[i]);
+        BOOST_CHECK(!inserted);
+        BOOST_CHECK(&it->second == entries[i]);
+    }
+    BOOST_CHECK_EQUAL(map.size(), hashes.size());
+    BOOST_CHECK_EQUAL(map.count(InsecureRand256()), 0U);
+
+    // Iteration visits every entry once, in insertion order
+    const node::BlockMap& const_map{map};
+    int height{0};
+    for (const auto& [hash, entry] : const_map) {
+        BOOST_CHECK(hash == hashes[height]);
+        BOOST_CHECK_EQUAL(entry.nHeight, height);
+        ++height;
+    }
+    BOOST_CHECK_EQUAL(height, int(hashes.size()));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
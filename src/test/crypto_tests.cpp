@@ -14,6 +14,7 @@
 #include <crypto/sha256.h>
 #include <crypto/sha3.h>
 #include <crypto/sha512.h>
+#include <crypto/yespower.h>
 #include <crypto/muhash.h>
 #include <random.h>
 #include <streams.h>
@@ -21,6 +22,8 @@
 #include <test/util/setup_common.h>
 #include <util/strencodings.h>
 
+#include <array>
+#include <thread>
 #include <vector>
 
 #include <boost/test/unit_test.hpp>
@@ -1047,4 +1050,56 @@ BOOST_AUTO_TEST_CASE(muhash_tests)
     BOOST_CHECK_EQUAL(HexStr(out4), "3a31e6903aff0de9f62f9a9f7f8b861de76ce2cda09822b90014319ae5dc2271");
 }
 
+static void TestYespower(uint32_t N, uint32_t r, const std::string& pers, const std::string& hexout)
+{
+    const yespower_params_t params = {
+        .version = YESPOWER_1_0,
+        .N = N,
+        .r = r,
+        .pers = pers.empty() ? nullptr : UCharCast(pers.data()),
+        .perslen = pers.size()
+    };
+    unsigned char input[80];
+    for (size_t i = 0; i < sizeof(input); ++i) input[i] = i * 3;
+    unsigned char out[32];
+    BOOST_CHECK(YespowerHash(input, sizeof(input), params, out));
+    BOOST_CHECK_EQUAL(HexStr(out), hexout);
+}
+
+BOOST_AUTO_TEST_CASE(yespower_testvectors)
+{
+    // From the upstream yespower 1.0.1 TESTS-OK
+    TestYespower(2048, 8, "", "69e0e895b3df7aeeb837d71fe199e9d34f7ec46ecbca7a2c4308e51857ae9b46");
+    TestYespower(2048, 32, "", "d5efb813cd263e9b34540130233cbbc6a921fbff3431e5ec1a1abde2aea6ff4d");
+    TestYespower(1024, 32, "personality test", "1f0269acf565c49adc0ef9b8f26ab3808cdc38394a254fddeedcc3aacff6ad9d");
+}
+
+BOOST_AUTO_TEST_CASE(yespower_region_pool)
+{
+    const yespower_params_t params = {
+        .version = YESPOWER_1_0,
+        .N = 2048,
+        .r = 32,
+        .pers = nullptr,
+        .perslen = 0
+    };
+    // Huge pages are optional: the pool falls back to normal pages without them
+    const size_t hugepage_regions{YespowerInitRegions(2, /*hugepages=*/true, params)};
+    BOOST_CHECK(hugepage_regions <= 2);
+
+    // More threads than regions: the extra ones wait for a region instead of allocating one
+    unsigned char input[80];
+    for (size_t i = 0; i < sizeof(input); ++i) input[i] = i * 3;
+    std::vector<std::array<unsigned char, 32>> outs(4);
+    std::vector<std::thread> threads;
+    for (auto& out : outs) {
+        threads.emplace_back([&] { if (!YespowerHash(input, sizeof(input), params, out.data())) out.fill(0); });
+    }
+    for (auto& thread : threads) thread.join();
+    for (const auto& out : outs) {
+        BOOST_CHECK_EQUAL(HexStr(out), "d5efb813cd263e9b34540130233cbbc6a921fbff3431e5ec1a1abde2aea6ff4d");
+    }
+    YespowerFreeRegions();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -118,6 +118,7 @@ FUZZ_TARGET_INIT(pow_transition, initialize_pow)
         auto current_block{std::make_unique<CBlockIndex>(header)};
         current_block->pprev = blocks.empty() ? nullptr : blocks.back().get();
         current_block->nHeight = height;
+        current_block->nChainTargetSum = (current_block->pprev ? current_block->pprev->nChainTargetSum : 0) + GetBlockTarget(*current_block);
         blocks.emplace_back(std::move(current_block));
     }
     auto last_block{blocks.back().get()};
@@ -92,7 +92,7 @@ BOOST_AUTO_TEST_CASE(headers_sync_state)
     // initially and then the rest.
     headers_batch.insert(headers_batch.end(), std::next(first_chain.begin()), first_chain.end());
 
-    hss.reset(new HeadersSyncState(0, Params().GetConsensus(), chain_start, chain_work));
+    hss.reset(new HeadersSyncState(0, Params().GetConsensus(), chain_start, chain_work, /*assume_pow=*/true));
     (void)hss->ProcessNextHeaders({first_chain.front()}, true);
     // Pretend the first header is still "full", so we don't abort.
     auto result = hss->ProcessNextHeaders(headers_batch, true);
@@ -109,7 +109,7 @@ BOOST_AUTO_TEST_CASE(headers_sync_state)
     BOOST_CHECK(hss->GetState() == HeadersSyncState::State::FINAL);
 
     // Now try again, this time feeding the first chain twice.
-    hss.reset(new HeadersSyncState(0, Params().GetConsensus(), chain_start, chain_work));
+    hss.reset(new HeadersSyncState(0, Params().GetConsensus(), chain_start, chain_work, /*assume_pow=*/true));
     (void)hss->ProcessNextHeaders(first_chain, true);
     BOOST_CHECK(hss->GetState() == HeadersSyncState::State::REDOWNLOAD);
 
@@ -123,7 +123,7 @@ BOOST_AUTO_TEST_CASE(headers_sync_state)
 
     // Finally, verify that just trying to process the second chain would not
     // succeed (too little work)
-    hss.reset(new HeadersSyncState(0, Params().GetConsensus(), chain_start, chain_work));
+    hss.reset(new HeadersSyncState(0, Params().GetConsensus(), chain_start, chain_work, /*assume_pow=*/true));
     BOOST_CHECK(hss->GetState() == HeadersSyncState::State::PRESYNC);
      // Pretend just the first message is "full", so we don't abort.
     (void)hss->ProcessNextHeaders({second_chain.front()}, true);
@@ -143,4 +143,64 @@ BOOST_AUTO_TEST_CASE(headers_sync_state)
     BOOST_CHECK(result.success);
 }
 
+/* YespowerSugar */
+// Headers up to the assumed-PoW header are only matched by hash, so the sync
+// must fail on a chain that doesn't pass through it, and must not release
+// everything before that header was matched again during REDOWNLOAD.
+BOOST_AUTO_TEST_CASE(headers_sync_assumed_pow)
+{
+    const int assumed_height = 10000;
+    std::vector<CBlockHeader> chain;
+    GenerateHeaders(chain, 15000, Params().GenesisBlock().GetHash(),
+            Params().GenesisBlock().nVersion, Params().GenesisBlock().nTime,
+            ArithToUint256(0), Params().GenesisBlock().nBits);
+
+    const CBlockIndex* chain_start = WITH_LOCK(::cs_main, return m_node.chainman->m_blockman.LookupBlockIndex(Params().GenesisBlock().GetHash()));
+
+    // Reach the minimum work well below the assumed-PoW header
+    arith_uint256 min_work{chain_start->nChainWork};
+    for (int i = 0; i < assumed_height / 2; ++i) {
+        min_work += GetBlockProof(CBlockIndex(chain[i]));
+    }
+
+    Consensus::Params params{Params().GetConsensus()};
+    params.nAssumedPoWHeight = assumed_height;
+    params.hashAssumedPoW = chain[assumed_height - 1].GetHash();
+
+    // Disabled: every header needs its proof of work checked
+    HeadersSyncState disabled(0, params, chain_start, min_work, /*assume_pow=*/false);
+    BOOST_CHECK_EQUAL(disabled.CountAssumedPoWHeaders(chain), 0U);
+
+    // The chain passes through the assumed-PoW header
+    HeadersSyncState hss(0, params, chain_start, min_work, /*assume_pow=*/true);
+    BOOST_CHECK_EQUAL(hss.CountAssumedPoWHeaders(chain), size_t{assumed_height});
+    auto result = hss.ProcessNextHeaders(chain, true);
+    BOOST_CHECK(result.success);
+    BOOST_CHECK(hss.GetState() == HeadersSyncState::State::REDOWNLOAD);
+
+    // Redownloading up to just below it releases nothing beyond the buffer,
+    // even though the minimum work was reached long before
+    const std::vector<CBlockHeader> first_part(chain.begin(), chain.begin() + assumed_height - 1);
+    BOOST_CHECK_EQUAL(hss.CountAssumedPoWHeaders(first_part), first_part.size());
+    result = hss.ProcessNextHeaders(first_part, true);
+    BOOST_CHECK(result.success);
+    BOOST_CHECK(result.request_more);
+    BOOST_CHECK(result.pow_validated_headers.empty());
+
+    // Matching it releases everything
+    const std::vector<CBlockHeader> second_part(chain.begin() + assumed_height - 1, chain.end());
+    BOOST_CHECK_EQUAL(hss.CountAssumedPoWHeaders(second_part), 1U);
+    result = hss.ProcessNextHeaders(second_part, false);
+    BOOST_CHECK(result.success);
+    BOOST_CHECK_EQUAL(result.pow_validated_headers.size(), chain.size());
+    BOOST_CHECK(hss.GetState() == HeadersSyncState::State::FINAL);
+
+    // A chain that doesn't pass through the assumed-PoW header is rejected
+    params.hashAssumedPoW = chain[assumed_height].GetHash();
+    HeadersSyncState mismatch(0, params, chain_start, min_work, /*assume_pow=*/true);
+    result = mismatch.ProcessNextHeaders(chain, true);
+    BOOST_CHECK(!result.success);
+    BOOST_CHECK(mismatch.GetState() == HeadersSyncState::State::FINAL);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,194 @@
+// Copyright (c) 2023 The Sugarchain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <index/base.h>
+#include <primitives/block.h>
+#include <test/util/setup_common.h>
+#include <undo.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <deque>
+
+BOOST_FIXTURE_TEST_SUITE(index_tests, BasicTestingSetup)
+
+namespace {
+/** Gives access to the database and the block reader of the indexes */
+class CacheTestIndex : public BaseIndex
+{
+public:
+    using BaseIndex::BlockReader;
+    using BaseIndex::DB;
+};
+
+/** Appends count block index entries on top of prev, which may be null */
+void ExtendBlocks(std::deque<CBlockIndex>& blocks, std::deque<uint256>& hashes, CBlockIndex* prev, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        CBlockIndex& block{blocks.emplace_back()};
+        block.phashBlock = &hashes.emplace_back(uint256{static_cast<uint8_t>(hashes.size())});
+        block.pprev = prev;
+        block.nHeight = prev ? prev->nHeight + 1 : 0;
+        prev = &block;
+    }
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(index_write_cache)
+{
+    constexpr uint8_t prefix{'T'};
+    CacheTestIndex::DB db{m_args.GetDataDirBase() / "write_cache", 1 << 20, /*f_memory=*/true, /*f_wipe=*/false, /*f_obfuscate=*/true, /*n_write_cache_size=*/1 << 20};
+    const auto read_cursor{[&](CacheTestIndex::DB::CachedIterator& cursor) {
+        std::vector<std::pair<uint8_t, int>> entries;
+        for (cursor.Seek(std::make_pair(prefix, uint8_t{0})); cursor.Valid(); cursor.Next()) {
+            std::pair<uint8_t, uint8_t> key;
+            int value;
+            BOOST_REQUIRE(cursor.GetKey(key) && cursor.GetValue(value));
+            if (key.first != prefix) break;
+            entries.emplace_back(key.second, value);
+        }
+        return entries;
+    }};
+    const auto read_all{[&] { return read_cursor(*db.NewCachedIterator(prefix)); }};
+    const std::vector<std::pair<uint8_t, int>> expected{{1, 10}, {2, 20}, {3, 33}, {6, 60}};
+
+    for (const uint8_t i : {1, 3, 5}) {
+        BOOST_CHECK(db.Write(std::make_pair(prefix, i), i * 10));
+    }
+    CacheTestIndex::DB::CacheBatch batch;
+    batch.Write(std::make_pair(prefix, uint8_t{2}), 20);
+    batch.Write(std::make_pair(prefix, uint8_t{3}), 33);
+    batch.Erase(std::make_pair(prefix, uint8_t{4}));
+    batch.Erase(std::make_pair(prefix, uint8_t{5}));
+    batch.Write(std::make_pair(prefix, uint8_t{6}), 60);
+    db.WriteCache(batch);
+
+    // reads see the cache, the database is unchanged until the commit
+    BOOST_CHECK(read_all() == expected);
+    int value;
+    BOOST_CHECK(db.ReadCached(std::make_pair(prefix, uint8_t{3}), value) && value == 33);
+    BOOST_CHECK(!db.ReadCached(std::make_pair(prefix, uint8_t{5}), value));
+    BOOST_CHECK(db.Read(std::make_pair(prefix, uint8_t{5}), value) && value == 50);
+    BOOST_CHECK(!db.CacheFull());
+
+    CDBBatch commit{db};
+    BOOST_CHECK(db.WriteBatchWithCache(commit));
+    BOOST_CHECK(read_all() == expected);
+    BOOST_CHECK(db.Read(std::make_pair(prefix, uint8_t{3}), value) && value == 33);
+    BOOST_CHECK(!db.Exists(std::make_pair(prefix, uint8_t{5})));
+
+    // an iterator keeps the state at its creation while the cache is written
+    // and committed
+    auto cursor{db.NewCachedIterator(prefix)};
+    CacheTestIndex::DB::CacheBatch later;
+    later.Write(std::make_pair(prefix, uint8_t{7}), 70);
+    later.Write(std::make_pair(prefix, uint8_t{8}), 80);
+    later.Erase(std::make_pair(prefix, uint8_t{1}));
+    db.WriteCache(later);
+    BOOST_CHECK(read_cursor(*cursor) == expected);
+
+    // a range iterator sees the cache entries from its first key up to its last
+    auto range_cursor{db.NewCachedIterator(std::make_pair(prefix, uint8_t{2}), std::make_pair(prefix, uint8_t{7}))};
+    CDBBatch later_commit{db};
+    BOOST_CHECK(db.WriteBatchWithCache(later_commit));
+    BOOST_CHECK(read_cursor(*cursor) == expected);
+    std::vector<std::pair<uint8_t, int>> range_entries;
+    for (range_cursor->Seek(std::make_pair(prefix, uint8_t{2})); range_cursor->Valid(); range_cursor->Next()) {
+        std::pair<uint8_t, uint8_t> key;
+        BOOST_REQUIRE(range_cursor->GetKey(key) && range_cursor->GetValue(value));
+        if (key.second > 7) break;
+        range_entries.emplace_back(key.second, value);
+    }
+    const std::vector<std::pair<uint8_t, int>> later_expected{{2, 20}, {3, 33}, {6, 60}, {7, 70}, {8, 80}};
+    BOOST_CHECK(range_entries == std::vector(later_expected.begin(), later_expected.end() - 1));
+    BOOST_CHECK(read_all() == later_expected);
+
+    // without a write cache every block is committed
+    CacheTestIndex::DB uncached{m_args.GetDataDirBase() / "uncached", 1 << 20, /*f_memory=*/true};
+    uncached.WriteCache(batch);
+    BOOST_CHECK(uncached.CacheFull());
+}
+
+BOOST_AUTO_TEST_CASE(index_db_version)
+{
+    CacheTestIndex::DB db{m_args.GetDataDirBase() / "version", 1 << 20, /*f_memory=*/true};
+    // a database without entries is of any version, and reading does not mark it
+    BOOST_CHECK(!db.ReadVersion());
+    BOOST_CHECK(!db.HasOtherVersion(1));
+    BOOST_CHECK(!db.ReadVersion());
+
+    // one with entries but without a version predates versioning
+    CDBBatch batch{db};
+    db.WriteBestBlock(batch, CBlockLocator{{uint256::ONE}});
+    BOOST_CHECK(db.WriteBatch(batch));
+    BOOST_CHECK(db.HasOtherVersion(1));
+    BOOST_CHECK(db.WriteVersion(1));
+    BOOST_CHECK(db.ReadVersion() == 1);
+    BOOST_CHECK(!db.HasOtherVersion(1));
+    BOOST_CHECK(db.HasOtherVersion(2));
+}
+
+BOOST_AUTO_TEST_CASE(index_block_reader_reorg)
+{
+    // the entries have no block data, so every read fails, which doesn't
+    // matter for which of them are queued
+    std::deque<CBlockIndex> blocks;
+    std::deque<uint256> hashes;
+    ExtendBlocks(blocks, hashes, nullptr, 40);
+    CBlockIndex* const fork{&blocks[10]};
+    ExtendBlocks(blocks, hashes, fork, 40);
+    CBlockIndex* const tip_a{&blocks[39]};
+    CBlockIndex* const tip_b{&blocks.back()};
+
+    const auto chain_from{[](const CChain& chain, int height, size_t count) {
+        std::vector<const CBlockIndex*> entries;
+        for (const CBlockIndex* pindex{chain[height]}; pindex && entries.size() < count; pindex = chain.Next(pindex)) {
+            entries.push_back(pindex);
+        }
+        return entries;
+    }};
+
+    constexpr int read_ahead{16};
+    CacheTestIndex::BlockReader reader{"test", /*read_undo=*/false, /*num_threads=*/1};
+    CChain chain;
+    chain.SetTip(*tip_a);
+    CBlock block;
+    CBlockUndo undo;
+
+    // reads take cs_main, so it is only held to queue them
+    WITH_LOCK(cs_main, reader.Queue(chain[1], chain));
+    BOOST_CHECK(reader.Queued() == chain_from(chain, 1, read_ahead));
+
+    // taking a block and queueing the next one keeps the reads and tops them up
+    BOOST_CHECK(!reader.Take(chain[1], block, undo));
+    WITH_LOCK(cs_main, reader.Queue(chain[2], chain));
+    BOOST_CHECK(reader.Queued() == chain_from(chain, 2, read_ahead));
+
+    // a reorg above the next block leaves it in place, but the queued reads
+    // are dropped and queued again along the new chain
+    chain.SetTip(*tip_b);
+    WITH_LOCK(cs_main, reader.Queue(chain[2], chain));
+    BOOST_CHECK(reader.Queued() == chain_from(chain, 2, read_ahead));
+    BOOST_CHECK(reader.Queued().back() != &blocks[17]);
+
+    // a reorg below the next block rewinds the sync thread to the fork, so
+    // the reads are dropped and those of the new chain are queued
+    while (reader.Queued().front()->nHeight <= fork->nHeight + 1) {
+        BOOST_CHECK(!reader.Take(reader.Queued().front(), block, undo));
+    }
+    chain.SetTip(*tip_a);
+    WITH_LOCK(cs_main, reader.Queue(chain[fork->nHeight + 1], chain));
+    BOOST_CHECK(reader.Queued() == chain_from(chain, fork->nHeight + 1, read_ahead));
+
+    // near the tip fewer blocks are left to queue
+    for (int height{fork->nHeight + 1}; height < 30; ++height) {
+        BOOST_CHECK(!reader.Take(chain[height], block, undo));
+        WITH_LOCK(cs_main, reader.Queue(chain[height + 1], chain));
+    }
+    BOOST_CHECK(reader.Queued() == chain_from(chain, 30, read_ahead));
+    BOOST_CHECK_EQUAL(reader.Queued().size(), 10U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
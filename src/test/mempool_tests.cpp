@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <policy/policy.h>
+#include <script/standard.h>
 #include <test/util/txmempool.h>
 #include <txmempool.h>
 #include <util/system.h>
@@ -800,4 +801,89 @@ BOOST_AUTO_TEST_CASE(MempoolAncestryTestsDiamond)
     BOOST_CHECK_EQUAL(descendants, 4ULL);
 }
 
+BOOST_AUTO_TEST_CASE(MempoolAddressIndexTest)
+{
+    // Sugar: Addressindex
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    TestMemPoolEntryHelper entry;
+    CCoinsView base;
+    CCoinsViewCache view{&base};
+
+    const uint160 key_hash{std::vector<unsigned char>(20, 0x01)};
+    const uint256 address_hash{key_hash.begin(), key_hash.size()};
+    const CScript p2pkh{GetScriptForDestination(PKHash{key_hash})};
+
+    // Two outputs of the same address are spent by one transaction, which
+    // pays back to the address
+    CMutableTransaction tx;
+    tx.vin.resize(2);
+    for (uint32_t i = 0; i < 2; ++i) {
+        tx.vin[i].prevout = COutPoint{uint256::ONE, i};
+        view.AddCoin(tx.vin[i].prevout, Coin{CTxOut{5 * COIN, p2pkh}, 1, false}, false);
+    }
+    tx.vout.emplace_back(9 * COIN, p2pkh);
+    const CTxMemPoolEntry tx_entry{entry.Time(NodeSeconds{100s}).FromTx(tx)};
+
+    LOCK2(::cs_main, pool.cs);
+    pool.addUnchecked(tx_entry);
+    pool.addAddressIndex(tx_entry, view);
+    pool.addSpentIndex(tx_entry, view);
+
+    std::vector<std::pair<uint256, int>> addresses{{address_hash, ADDR_INDT_PUBKEY_ADDRESS}};
+    std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta>> deltas;
+    BOOST_CHECK(pool.getAddressIndex(addresses, deltas));
+    BOOST_CHECK_EQUAL(deltas.size(), 3U);
+    CAmount total{0};
+    for (const auto& [key, delta] : deltas) {
+        BOOST_CHECK(key.txhash == tx.GetHash());
+        BOOST_CHECK_EQUAL(delta.time, 100);
+        total += delta.amount;
+    }
+    BOOST_CHECK_EQUAL(total, -1 * COIN);
+
+    // The same hash as a different address type has no deltas
+    std::vector<std::pair<uint256, int>> other{{address_hash, ADDR_INDT_SCRIPT_ADDRESS}};
+    std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta>> other_deltas;
+    BOOST_CHECK(pool.getAddressIndex(other, other_deltas));
+    BOOST_CHECK(other_deltas.empty());
+
+    CSpentIndexValue spent;
+    BOOST_CHECK(pool.getSpentIndex(CSpentIndexKey{uint256::ONE, 1}, spent));
+    BOOST_CHECK(spent.txid == tx.GetHash());
+    BOOST_CHECK_EQUAL(spent.inputIndex, 1U);
+    BOOST_CHECK_EQUAL(spent.blockHeight, -1);
+
+    // A second, unrelated transaction pays to the same address
+    CMutableTransaction tx2;
+    tx2.vin.resize(1);
+    tx2.vin[0].prevout = COutPoint{uint256::ONE, 2};
+    view.AddCoin(tx2.vin[0].prevout, Coin{CTxOut{5 * COIN, CScript{} << OP_TRUE}, 1, false}, false);
+    tx2.vout.emplace_back(4 * COIN, p2pkh);
+    const CTxMemPoolEntry tx2_entry{entry.Time(NodeSeconds{200s}).FromTx(tx2)};
+    pool.addUnchecked(tx2_entry);
+    pool.addAddressIndex(tx2_entry, view);
+
+    std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta>> tx_deltas;
+    BOOST_CHECK(pool.getAddressIndex(tx.GetHash(), tx_deltas));
+    BOOST_CHECK_EQUAL(tx_deltas.size(), 3U);
+    tx_deltas.clear();
+    BOOST_CHECK(pool.getAddressIndex(tx2.GetHash(), tx_deltas));
+    BOOST_REQUIRE_EQUAL(tx_deltas.size(), 1U);
+    BOOST_CHECK_EQUAL(tx_deltas[0].second.amount, 4 * COIN);
+
+    // Removing the transaction from the mempool removes only its entries
+    pool.removeRecursive(CTransaction{tx}, REMOVAL_REASON_DUMMY);
+    deltas.clear();
+    BOOST_CHECK(pool.getAddressIndex(addresses, deltas));
+    BOOST_REQUIRE_EQUAL(deltas.size(), 1U);
+    BOOST_CHECK(deltas[0].first.txhash == tx2.GetHash());
+    BOOST_CHECK(!pool.getAddressIndex(tx.GetHash(), tx_deltas));
+    BOOST_CHECK(!pool.getSpentIndex(CSpentIndexKey{uint256::ONE, 0}, spent));
+
+    pool.removeRecursive(CTransaction{tx2}, REMOVAL_REASON_DUMMY);
+    deltas.clear();
+    BOOST_CHECK(pool.getAddressIndex(addresses, deltas));
+    BOOST_CHECK(deltas.empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -155,6 +155,43 @@ BOOST_AUTO_TEST_CASE(GetBlockProofEquivalentTime_test)
     }
 }
 
+/* SugarShield */
+//! The averaging window sum as a walk over the window, like GetNextWorkRequired() used to compute it
+static unsigned int GetNextWorkRequiredByWalk(const CBlockIndex* pindexLast, const Consensus::Params& params)
+{
+    const CBlockIndex* pindexFirst = pindexLast;
+    arith_uint256 bnTot {0};
+    for (int i = 0; pindexFirst && i < params.nPowAveragingWindow; i++) {
+        arith_uint256 bnTmp;
+        bnTmp.SetCompact(pindexFirst->nBits);
+        bnTot += bnTmp;
+        pindexFirst = pindexFirst->pprev;
+    }
+    if (pindexFirst == nullptr)
+        return UintToArith256(params.powLimit).GetCompact();
+    return CalculateNextWorkRequired(bnTot / params.nPowAveragingWindow, pindexLast->GetMedianTimePast(), pindexFirst->GetMedianTimePast(), params);
+}
+
+/* SugarShield */
+BOOST_AUTO_TEST_CASE(get_next_work_chain_target_sum)
+{
+    const auto chainParams = CreateChainParams(*m_node.args, CBaseChainParams::MAIN);
+    const Consensus::Params& params = chainParams->GetConsensus();
+    const arith_uint256 pow_limit = UintToArith256(params.powLimit);
+
+    std::vector<CBlockIndex> blocks(3 * params.nPowAveragingWindow);
+    for (size_t i = 0; i < blocks.size(); i++) {
+        blocks[i].pprev = i ? &blocks[i - 1] : nullptr;
+        blocks[i].nHeight = i;
+        blocks[i].nTime = 1269211443 + i * params.nPowTargetSpacing + InsecureRandRange(3 * params.nPowTargetSpacing);
+        blocks[i].nBits = arith_uint256{pow_limit >> InsecureRandRange(32)}.GetCompact();
+        blocks[i].nChainTargetSum = (i ? blocks[i - 1].nChainTargetSum : 0) + GetBlockTarget(blocks[i]);
+        blocks[i].BuildSkip();
+
+        BOOST_CHECK_EQUAL(GetNextWorkRequired(&blocks[i], nullptr, params), GetNextWorkRequiredByWalk(&blocks[i], params));
+    }
+}
+
 void sanity_check_chainparams(const ArgsManager& args, std::string chainName)
 {
     const auto chainParams = CreateChainParams(args, chainName);
@@ -0,0 +1,111 @@
+// Copyright (c) 2023 The Sugarchain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <hash.h>
+#include <script/script.h>
+#include <script/standard.h>
+#include <spentindex.h>
+#include <streams.h>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(spentindex_tests, BasicTestingSetup)
+
+/** A hash of the size used by the address type, zero padded like ExtractIndexInfo */
+static uint256 RandomAddressHash(unsigned int type)
+{
+    const uint256 random{InsecureRand256()};
+    uint256 hash;
+    std::copy(random.begin(), random.begin() + AddressHashSize(type), hash.begin());
+    return hash;
+}
+
+template <typename T>
+static DataStream Serialized(const T& obj)
+{
+    DataStream stream{};
+    stream << obj;
+    return stream;
+}
+
+BOOST_AUTO_TEST_CASE(address_index_key_roundtrip)
+{
+    const uint256 hash{RandomAddressHash(ADDR_INDT_PUBKEY_ADDRESS)};
+    const CAddressIndexKey key{ADDR_INDT_PUBKEY_ADDRESS, hash, 123456, 300, InsecureRand256(), 20000, true};
+
+    DataStream stream{Serialized(key)};
+    // type, 20 byte hash, height, 2 byte txindex, txhash, 3 byte index, spending
+    BOOST_CHECK_EQUAL(stream.size(), 1U + 20 + 4 + 2 + 32 + 3 + 1);
+
+    CAddressIndexKey read;
+    stream >> read;
+    BOOST_CHECK(read == key);
+    BOOST_CHECK(stream.empty());
+
+    // 32 byte hashes are stored in full
+    const CAddressIndexIteratorKey taproot{ADDR_INDT_WITNESS_V1_TAPROOT, InsecureRand256()};
+    BOOST_CHECK_EQUAL(Serialized(taproot).size(), 1U + 32);
+}
+
+BOOST_AUTO_TEST_CASE(address_index_key_order)
+{
+    // Range lookups depend on the entries of an address sorting by height
+    const uint256 hash{RandomAddressHash(ADDR_INDT_SCRIPT_ADDRESS)};
+    const auto first{Serialized(CAddressIndexKey{ADDR_INDT_SCRIPT_ADDRESS, hash, 255, 1000, uint256::ONE, 0, false})};
+    const auto second{Serialized(CAddressIndexKey{ADDR_INDT_SCRIPT_ADDRESS, hash, 256, 0, uint256::ZERO, 0, false})};
+    const auto start{Serialized(CAddressIndexIteratorHeightKey{ADDR_INDT_SCRIPT_ADDRESS, hash, 256})};
+    BOOST_CHECK(std::lexicographical_compare(first.begin(), first.end(), start.begin(), start.end()));
+    BOOST_CHECK(!std::lexicographical_compare(second.begin(), second.end(), start.begin(), start.end()));
+}
+
+BOOST_AUTO_TEST_CASE(unspent_and_spent_roundtrip)
+{
+    const uint256 hash{RandomAddressHash(ADDR_INDT_WITNESS_V0_KEYHASH)};
+    const CAddressUnspentKey key{ADDR_INDT_WITNESS_V0_KEYHASH, hash, InsecureRand256(), 7};
+    const CAddressUnspentValue value{50 * COIN, GetScriptForDestination(WitnessV0KeyHash{uint160{}}), 1000};
+
+    DataStream stream{Serialized(key)};
+    stream << value;
+    CAddressUnspentKey read_key;
+    CAddressUnspentValue read_value;
+    stream >> read_key >> read_value;
+    BOOST_CHECK(read_key == key);
+    BOOST_CHECK_EQUAL(read_value.satoshis, value.satoshis);
+    BOOST_CHECK(read_value.script == value.script);
+    BOOST_CHECK_EQUAL(read_value.blockHeight, value.blockHeight);
+
+    const CSpentIndexValue spent{InsecureRand256(), 3, 1000, 12345, ADDR_INDT_WITNESS_V0_KEYHASH, hash};
+    stream << spent;
+    CSpentIndexValue read_spent;
+    stream >> read_spent;
+    BOOST_CHECK(read_spent.txid == spent.txid);
+    BOOST_CHECK_EQUAL(read_spent.inputIndex, spent.inputIndex);
+    BOOST_CHECK_EQUAL(read_spent.blockHeight, spent.blockHeight);
+    BOOST_CHECK_EQUAL(read_spent.satoshis, spent.satoshis);
+    BOOST_CHECK_EQUAL(read_spent.addressType, spent.addressType);
+    BOOST_CHECK(read_spent.addressHash == spent.addressHash);
+}
+
+BOOST_AUTO_TEST_CASE(extract_witness_program)
+{
+    int type;
+    std::vector<uint8_t> hash_bytes;
+
+    const std::vector<uint8_t> program(20, 0x01);
+    BOOST_CHECK(ExtractIndexInfo(&(CScript() << OP_0 << program), type, hash_bytes));
+    BOOST_CHECK_EQUAL(type, ADDR_INDT_WITNESS_V0_KEYHASH);
+    BOOST_CHECK(hash_bytes == program);
+
+    // Programs that are longer than a hash are not indexed
+    const std::vector<uint8_t> long_program(40, 0x01);
+    BOOST_CHECK(ExtractIndexInfo(&(CScript() << OP_1 << long_program), type, hash_bytes));
+    BOOST_CHECK_EQUAL(type, ADDR_INDT_UNKNOWN);
+    BOOST_CHECK(ExtractIndexInfo(&(CScript() << OP_0 << std::vector<uint8_t>(33, 0x01)), type, hash_bytes));
+    BOOST_CHECK_EQUAL(type, ADDR_INDT_UNKNOWN);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,7 @@
 #include <chainparams.h>
 #include <consensus/amount.h>
 #include <net.h>
+#include <pow.h>
 #include <signet.h>
 #include <uint256.h>
 #include <validation.h>
@@ -144,4 +145,23 @@ BOOST_AUTO_TEST_CASE(test_assumeutxo)
     BOOST_CHECK_EQUAL(out210.nChainTx, 200U);
 }
 
+//! Test that header batches checked on the PoW worker threads match serial checking.
+BOOST_AUTO_TEST_CASE(header_batch_pow)
+{
+    const auto params = CreateChainParams(*m_node.args, CBaseChainParams::MAIN);
+    const Consensus::Params& consensus = params->GetConsensus();
+
+    ClearPoWHashCache();
+    std::vector<CBlockHeader> headers(16, params->GenesisBlock().GetBlockHeader());
+    BOOST_CHECK(HasValidProofOfWork(headers, consensus));
+    // The workers leave the PoW hash behind for AcceptBlockHeader
+    BOOST_CHECK(GetCachedPoWHash(headers.front().GetHash()) == headers.front().GetPoWHash());
+
+    CBlockHeader bad{params->GenesisBlock().GetBlockHeader()};
+    bad.nNonce += 1;
+    BOOST_REQUIRE(!CheckProofOfWork(bad.GetPoWHash(), bad.nBits, consensus));
+    headers[7] = bad;
+    BOOST_CHECK(!HasValidProofOfWork(headers, consensus));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -6,15 +6,34 @@
 #include <txdb.h>
 
 #include <chain.h>
+#include <crypto/common.h>
 #include <logging.h>
 #include <pow.h>
 #include <random.h>
 #include <shutdown.h>
+#include <span.h>
+#include <sync.h>
+#include <tinyformat.h>
 #include <uint256.h>
+#include <util/fs_helpers.h>
+#include <util/threadnames.h>
 #include <util/translation.h>
 #include <util/vector.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <stdint.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 static constexpr uint8_t DB_COIN{'C'};
 static constexpr uint8_t DB_BLOCK_FILES{'f'};
@@ -25,17 +44,17 @@ static constexpr uint8_t DB_HEAD_BLOCKS{'H'};
 static constexpr uint8_t DB_FLAG{'F'};
 static constexpr uint8_t DB_REINDEX_FLAG{'R'};
 static constexpr uint8_t DB_LAST_BLOCK{'l'};
-
-// Sugar: Addressindex
-static constexpr uint8_t DB_ADDRESSINDEX{'a'};
-static constexpr uint8_t DB_ADDRESSUNSPENTINDEX{'u'};
-static constexpr uint8_t DB_TIMESTAMPINDEX{'s'};
-static constexpr uint8_t DB_SPENTINDEX{'p'};
+static constexpr uint8_t DB_FLAT_BLOCK_INDEX_SIZE{'i'};
 
 // Keys used in previous version that might still be found in the DB:
 static constexpr uint8_t DB_COINS{'c'};
 static constexpr uint8_t DB_TXINDEX_BLOCK{'T'};
 //               uint8_t DB_TXINDEX{'t'}
+// Sugar: Addressindex, now kept in the databases of the indexes in index/
+//               uint8_t DB_ADDRESSINDEX{'a'}
+//               uint8_t DB_ADDRESSUNSPENTINDEX{'u'}
+//               uint8_t DB_TIMESTAMPINDEX{'s'}
+//               uint8_t DB_SPENTINDEX{'p'}
 
 std::optional<bilingual_str> CheckLegacyTxindex(CBlockTreeDB& block_tree_db)
 {
@@ -55,6 +74,25 @@ std::optional<bilingual_str> CheckLegacyTxindex(CBlockTreeDB& block_tree_db)
     return std::nullopt;
 }
 
+std::optional<bilingual_str> CheckLegacyAddressIndex(CBlockTreeDB& block_tree_db)
+{
+    bool legacy{false};
+    for (const char* name : {"addressindex", "spentindex", "timestampindex"}) {
+        bool flag{false};
+        block_tree_db.ReadFlag(name, flag);
+        if (!flag) continue;
+        // Disable the legacy index and warn once about occupied disk space
+        if (!block_tree_db.WriteFlag(name, false)) {
+            return strprintf(Untranslated("Failed to write block index db flag '%s'='0'"), name);
+        }
+        legacy = true;
+    }
+    if (legacy) {
+        return _("The block index db contains a legacy address, spent or timestamp index, which is not used anymore. To clear the occupied disk space, run a full -reindex. This warning will not be displayed again.");
+    }
+    return std::nullopt;
+}
+
 bool CCoinsViewDB::NeedsUpgrade()
 {
     std::unique_ptr<CDBIterator> cursor{m_db->NewIterator()};
@@ -273,6 +311,131 @@ void CCoinsViewDBCursor::Next()
     }
 }
 
+namespace {
+//! Start of the flat block index file: magic bytes, format version and record size
+constexpr std::array<unsigned char, 8> FLAT_BLOCK_INDEX_MAGIC{'s', 'u', 'g', 'a', 'r', 'b', 'i', 'x'};
+constexpr uint32_t FLAT_BLOCK_INDEX_VERSION{1};
+constexpr size_t FLAT_HEADER_SIZE{16};
+//! Size of one entry in the flat block index file, see EncodeFlatRecord()
+constexpr size_t FLAT_RECORD_SIZE{136};
+
+/** Serialize the fields of a block index entry that are stored on disk into a
+ *  flat record, with every field at a fixed offset. */
+void EncodeFlatRecord(const CBlockIndex& index, unsigned char* out)
+{
+    memcpy(out, index.GetBlockHash().begin(), 32);
+    const uint256 hash_prev{index.pprev ? index.pprev->GetBlockHash() : uint256{}};
+    memcpy(out + 32, hash_prev.begin(), 32);
+    WriteLE32(out + 64, index.nHeight);
+    WriteLE32(out + 68, index.nStatus);
+    WriteLE32(out + 72, index.nTx);
+    WriteLE32(out + 76, index.nFile);
+    WriteLE32(out + 80, index.nDataPos);
+    WriteLE32(out + 84, index.nUndoPos);
+    WriteLE32(out + 88, index.nVersion);
+    memcpy(out + 92, index.hashMerkleRoot.begin(), 32);
+    WriteLE32(out + 124, index.nTime);
+    WriteLE32(out + 128, index.nBits);
+    WriteLE32(out + 132, index.nNonce);
+}
+
+uint256 FlatRecordHash(const unsigned char* record) { return uint256{Span{record, 32}}; }
+uint256 FlatRecordHashPrev(const unsigned char* record) { return uint256{Span{record + 32, 32}}; }
+
+void DecodeFlatRecord(const unsigned char* record, CBlockIndex& index)
+{
+    index.nHeight        = ReadLE32(record + 64);
+    index.nStatus        = ReadLE32(record + 68);
+    index.nTx            = ReadLE32(record + 72);
+    index.nFile          = ReadLE32(record + 76);
+    index.nDataPos       = ReadLE32(record + 80);
+    index.nUndoPos       = ReadLE32(record + 84);
+    index.nVersion       = ReadLE32(record + 88);
+    index.hashMerkleRoot = uint256{Span{record + 92, 32}};
+    index.nTime          = ReadLE32(record + 124);
+    index.nBits          = ReadLE32(record + 128);
+    index.nNonce         = ReadLE32(record + 132);
+}
+
+/** A whole file mapped read-only into memory, or read into a buffer where mmap is unavailable. */
+class MappedFile
+{
+    const unsigned char* m_data{nullptr};
+    size_t m_size{0};
+#ifdef WIN32
+    std::vector<unsigned char> m_buffer;
+#endif
+
+public:
+    explicit MappedFile(const fs::path& path)
+    {
+#ifdef WIN32
+        FILE* file{fsbridge::fopen(path, "rb")};
+        if (!file) return;
+        std::error_code ec;
+        m_buffer.resize(fs::file_size(path, ec));
+        if (!ec && fread(m_buffer.data(), 1, m_buffer.size(), file) == m_buffer.size()) {
+            m_data = m_buffer.data();
+            m_size = m_buffer.size();
+        }
+        fclose(file);
+#else
+        const int fd{open(fs::PathToString(path).c_str(), O_RDONLY)};
+        if (fd == -1) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* data{mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)};
+            if (data != MAP_FAILED) {
+                m_data = static_cast<const unsigned char*>(data);
+                m_size = st.st_size;
+            }
+        }
+        close(fd);
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifndef WIN32
+        if (m_data) munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    Span<const unsigned char> Data() const { return {m_data, m_size}; }
+};
+
+/** Call fn(n) for every n in [0, num_threads), each on its own thread. */
+template <typename Fn>
+void RunOnThreads(int num_threads, const Fn& fn)
+{
+    std::vector<std::thread> threads;
+    for (int n = 1; n < num_threads; ++n) {
+        threads.emplace_back([&fn, n] {
+            util::ThreadRename(strprintf("loadblkidx.%i", n));
+            fn(n);
+        });
+    }
+    fn(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+} // namespace
+
+CBlockTreeDB::CBlockTreeDB(const DBParams& db_params)
+    : CDBWrapper{db_params}
+{
+    if (db_params.memory_only) return;
+    m_flat_path = db_params.path.parent_path() / "blockindex.dat";
+    if (db_params.wipe_data) {
+        LogPrintf("Wiping flat block index file %s\n", fs::PathToString(*m_flat_path));
+        fs::remove(*m_flat_path);
+    }
+}
+
 bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo) {
     CDBBatch batch(*this);
     for (std::vector<std::pair<int, const CBlockFileInfo*> >::const_iterator it=fileInfo.begin(); it != fileInfo.end(); it++) {
@@ -297,184 +460,208 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
-bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex)
+bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, int num_threads)
 {
     AssertLockHeld(::cs_main);
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
-    pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
-
-    // Load m_block_index
-    while (pcursor->Valid()) {
-        if (ShutdownRequested()) return false;
-        std::pair<uint8_t, uint256> key;
-        if (pcursor->GetKey(key) && key.first == DB_BLOCK_INDEX) {
-            CDiskBlockIndex diskindex;
-            if (pcursor->GetValue(diskindex)) {
-                // Construct block index object
-                CBlockIndex* pindexNew = insertBlockIndex(diskindex.ConstructBlockHash());
-                pindexNew->pprev          = insertBlockIndex(diskindex.hashPrev);
-                pindexNew->nHeight        = diskindex.nHeight;
-                pindexNew->nFile          = diskindex.nFile;
-                pindexNew->nDataPos       = diskindex.nDataPos;
-                pindexNew->nUndoPos       = diskindex.nUndoPos;
-                pindexNew->nVersion       = diskindex.nVersion;
-                pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
-                pindexNew->nTime          = diskindex.nTime;
-                pindexNew->nBits          = diskindex.nBits;
-                pindexNew->nNonce         = diskindex.nNonce;
-                pindexNew->nStatus        = diskindex.nStatus;
-                pindexNew->nTx            = diskindex.nTx;
-
-                /* YespowerSugar */
-                /*
-                Litecoin: Disable PoW Sanity check while loading block index from disk.
-                We use the sha256 hash for the block index for performance reasons, which is recorded for later use.
-                CheckProofOfWork() uses the scrypt hash which is discarded after a block is accepted.
-                While it is technically feasible to verify the PoW, doing so takes several minutes as it
-                requires recomputing every PoW hash during every Litecoin startup.
-                We opt instead to simply trust the data that is on your local disk.
-                */
-                /*
-                if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, consensusParams)) {
-                    return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
-                }
-                */
 
-                pcursor->Next();
+    num_threads = std::clamp(num_threads, 1, 256);
+    if (!LoadFlatBlockIndex(insertBlockIndex, num_threads)) return false;
+
+    // Block hashes are uniformly distributed, so slicing the key range on the
+    // first byte of the hash gives every thread about the same number of
+    // entries. Decoding and hashing an entry runs in parallel; only the map
+    // insertion is serialized.
+    Mutex insert_mutex;
+    std::atomic<bool> failed{false};
+
+    const auto load_slice = [&](int slice) {
+        const int first_byte{256 * slice / num_threads};
+        const int end_byte{256 * (slice + 1) / num_threads};
+        uint256 start;
+        *start.begin() = first_byte;
+
+        std::unique_ptr<CDBIterator> pcursor(NewIterator());
+        pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, start));
+
+        // Load m_block_index
+        while (pcursor->Valid()) {
+            if (failed || ShutdownRequested()) {
+                failed = true;
+                return;
+            }
+            std::pair<uint8_t, uint256> key;
+            if (pcursor->GetKey(key) && key.first == DB_BLOCK_INDEX && *key.second.begin() < end_byte) {
+                CDiskBlockIndex diskindex;
+                if (pcursor->GetValue(diskindex)) {
+                    // Construct block index object
+                    const uint256 hash{diskindex.ConstructBlockHash()};
+                    CBlockIndex* pindexNew;
+                    {
+                        LOCK(insert_mutex);
+                        pindexNew = insertBlockIndex(hash);
+                        pindexNew->pprev = insertBlockIndex(diskindex.hashPrev);
+                    }
+                    pindexNew->nHeight        = diskindex.nHeight;
+                    pindexNew->nFile          = diskindex.nFile;
+                    pindexNew->nDataPos       = diskindex.nDataPos;
+                    pindexNew->nUndoPos       = diskindex.nUndoPos;
+                    pindexNew->nVersion       = diskindex.nVersion;
+                    pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
+                    pindexNew->nTime          = diskindex.nTime;
+                    pindexNew->nBits          = diskindex.nBits;
+                    pindexNew->nNonce         = diskindex.nNonce;
+                    pindexNew->nStatus        = diskindex.nStatus;
+                    pindexNew->nTx            = diskindex.nTx;
+
+                    /* YespowerSugar */
+                    /*
+                    Litecoin: Disable PoW Sanity check while loading block index from disk.
+                    We use the sha256 hash for the block index for performance reasons, which is recorded for later use.
+                    CheckProofOfWork() uses the scrypt hash which is discarded after a block is accepted.
+                    While it is technically feasible to verify the PoW, doing so takes several minutes as it
+                    requires recomputing every PoW hash during every Litecoin startup.
+                    We opt instead to simply trust the data that is on your local disk.
+                    */
+                    /*
+                    if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, consensusParams)) {
+                        return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
+                    }
+                    */
+
+                    pcursor->Next();
+                } else {
+                    error("%s: failed to read value", __func__);
+                    failed = true;
+                    return;
+                }
             } else {
-                return error("%s: failed to read value", __func__);
+                break;
             }
-        } else {
-            break;
         }
-    }
+    };
 
-    return true;
-}
+    RunOnThreads(num_threads, load_slice);
 
-// Sugar: Addressindex
-bool CBlockTreeDB::ReadSpentIndex(const CSpentIndexKey &key, CSpentIndexValue &value) {
-    return Read(std::make_pair(DB_SPENTINDEX, key), value);
+    return !failed;
 }
 
-bool CBlockTreeDB::UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >&vect) {
-    CDBBatch batch(*this);
-    for (std::vector<std::pair<CSpentIndexKey,CSpentIndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
-        if (it->second.IsNull()) {
-            batch.Erase(std::make_pair(DB_SPENTINDEX, it->first));
-        } else {
-            batch.Write(std::make_pair(DB_SPENTINDEX, it->first), it->second);
-        }
-    }
-    return WriteBatch(batch);
+int CBlockTreeDB::ReadFlatBlockIndexSize()
+{
+    int flat_size{0};
+    if (!m_flat_path || !Read(DB_FLAT_BLOCK_INDEX_SIZE, flat_size)) return 0;
+    return std::max(flat_size, 0);
 }
 
-bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect) {
-    CDBBatch batch(*this);
-    for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
-        if (it->second.IsNull()) {
-            batch.Erase(std::make_pair(DB_ADDRESSUNSPENTINDEX, it->first));
-        } else {
-            batch.Write(std::make_pair(DB_ADDRESSUNSPENTINDEX, it->first), it->second);
-        }
+bool CBlockTreeDB::LoadFlatBlockIndex(const std::function<CBlockIndex*(const uint256&)>& insertBlockIndex, int num_threads)
+{
+    m_flat_size = 0;
+    m_flat_tip.SetNull();
+    int flat_size{0};
+    if (!m_flat_path || !Read(DB_FLAT_BLOCK_INDEX_SIZE, flat_size) || flat_size == 0) return true;
+
+    // Records past flat_size are left over from an append that was not
+    // committed to the database, and are ignored.
+    const MappedFile file{*m_flat_path};
+    const Span<const unsigned char> data{file.Data()};
+    if (data.size() < FLAT_HEADER_SIZE + size_t(flat_size) * FLAT_RECORD_SIZE ||
+        !std::equal(FLAT_BLOCK_INDEX_MAGIC.begin(), FLAT_BLOCK_INDEX_MAGIC.end(), data.begin()) ||
+        ReadLE32(data.data() + 8) != FLAT_BLOCK_INDEX_VERSION || ReadLE32(data.data() + 12) != FLAT_RECORD_SIZE) {
+        return error("%s: flat block index file %s is missing, truncated or of an unknown format", __func__, fs::PathToString(*m_flat_path));
     }
-    return WriteBatch(batch);
-}
-
-bool CBlockTreeDB::ReadAddressUnspentIndex(uint256 addressHash, int type,
-                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs) {
-
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
-
-    pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
-
-    while (pcursor->Valid()) {
-        std::pair<uint8_t,CAddressUnspentKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.hashBytes == addressHash) {
-            CAddressUnspentValue nValue;
-            if (pcursor->GetValue(nValue)) {
-                unspentOutputs.push_back(std::make_pair(key.second, nValue));
-                pcursor->Next();
-            } else {
-                return error("failed to get address unspent value");
+    const auto record{[&](int height) { return data.data() + FLAT_HEADER_SIZE + size_t(height) * FLAT_RECORD_SIZE; }};
+
+    // The records form one chain in height order. Checking each against the
+    // one before it catches a damaged or misplaced record without hashing.
+    Mutex insert_mutex;
+    std::atomic<bool> failed{false};
+    RunOnThreads(num_threads, [&](int slice) {
+        const int begin{int(int64_t{flat_size} * slice / num_threads)};
+        const int end{int(int64_t{flat_size} * (slice + 1) / num_threads)};
+        for (int height = begin; height < end; ++height) {
+            if (failed || ShutdownRequested()) {
+                failed = true;
+                return;
+            }
+            const unsigned char* rec{record(height)};
+            const uint256 hash{FlatRecordHash(rec)};
+            const uint256 hash_prev{FlatRecordHashPrev(rec)};
+            if (int(ReadLE32(rec + 64)) != height || hash_prev != (height == 0 ? uint256{} : FlatRecordHash(record(height - 1)))) {
+                error("%s: flat block index record %d is corrupt", __func__, height);
+                failed = true;
+                return;
             }
-        } else {
-            break;
+            CBlockIndex* pindexNew;
+            {
+                LOCK(insert_mutex);
+                pindexNew = insertBlockIndex(hash);
+                pindexNew->pprev = insertBlockIndex(hash_prev);
+            }
+            DecodeFlatRecord(rec, *pindexNew);
         }
-    }
+    });
+    if (failed) return false;
 
+    m_flat_size = flat_size;
+    m_flat_tip = FlatRecordHash(record(flat_size - 1));
+    LogPrintf("%s: loaded %d entries from %s\n", __func__, m_flat_size, fs::PathToString(*m_flat_path));
     return true;
 }
 
-bool CBlockTreeDB::WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
-    CDBBatch batch(*this);
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
-        batch.Write(std::make_pair(DB_ADDRESSINDEX, it->first), it->second);
-    return WriteBatch(batch);
-}
-
-bool CBlockTreeDB::EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
-    CDBBatch batch(*this);
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
-        batch.Erase(std::make_pair(DB_ADDRESSINDEX, it->first));
-    return WriteBatch(batch);
-}
-
-bool CBlockTreeDB::ReadAddressIndex(uint256 addressHash, int type,
-                                    std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
-                                    int start, int end) {
-
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
-
-    if (start > 0 && end > 0) {
-        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, start)));
-    } else {
-        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, addressHash)));
-    }
-
-    while (pcursor->Valid()) {
-        std::pair<uint8_t,CAddressIndexKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX && key.second.hashBytes == addressHash) {
-            if (end > 0 && key.second.blockHeight > end) {
-                break;
-            }
-            CAmount nValue;
-            if (pcursor->GetValue(nValue)) {
-                addressIndex.push_back(std::make_pair(key.second, nValue));
-                pcursor->Next();
-            } else {
-                return error("failed to get address index value");
-            }
-        } else {
-            break;
+bool CBlockTreeDB::WriteFlatBlockIndex(const std::vector<const CBlockIndex*>& blocks)
+{
+    if (!m_flat_path || blocks.empty()) return true;
+
+    std::vector<unsigned char> records(blocks.size() * FLAT_RECORD_SIZE);
+    uint256 tip{m_flat_tip};
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        const CBlockIndex& index{*blocks[i]};
+        const uint256 hash_prev{index.pprev ? index.pprev->GetBlockHash() : uint256{}};
+        if (index.nHeight != m_flat_size + int(i) || hash_prev != tip) {
+            return error("%s: block %s does not extend the flat block index", __func__, index.GetBlockHash().ToString());
         }
+        EncodeFlatRecord(index, records.data() + i * FLAT_RECORD_SIZE);
+        tip = index.GetBlockHash();
     }
 
-    return true;
-}
+    // Drop any records left over from an append that was not committed, then
+    // append after the committed ones
+    const size_t committed_size{m_flat_size == 0 ? 0 : FLAT_HEADER_SIZE + size_t(m_flat_size) * FLAT_RECORD_SIZE};
+    std::error_code ec;
+    const uintmax_t file_size{fs::exists(*m_flat_path) ? fs::file_size(*m_flat_path, ec) : 0};
+    if (ec || file_size < committed_size) {
+        return error("%s: flat block index file %s is truncated", __func__, fs::PathToString(*m_flat_path));
+    }
+    if (file_size > committed_size) {
+        fs::resize_file(*m_flat_path, committed_size, ec);
+        if (ec) return error("%s: failed to truncate %s: %s", __func__, fs::PathToString(*m_flat_path), ec.message());
+    }
+    FILE* file{fsbridge::fopen(*m_flat_path, "ab")};
+    if (!file) {
+        return error("%s: failed to open %s", __func__, fs::PathToString(*m_flat_path));
+    }
+    bool written{true};
+    if (committed_size == 0) {
+        unsigned char header[FLAT_HEADER_SIZE];
+        std::copy(FLAT_BLOCK_INDEX_MAGIC.begin(), FLAT_BLOCK_INDEX_MAGIC.end(), header);
+        WriteLE32(header + 8, FLAT_BLOCK_INDEX_VERSION);
+        WriteLE32(header + 12, FLAT_RECORD_SIZE);
+        written = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    }
+    written = written && fwrite(records.data(), 1, records.size(), file) == records.size() && FileCommit(file);
+    if (fclose(file) != 0 || !written) {
+        return error("%s: failed to write to %s", __func__, fs::PathToString(*m_flat_path));
+    }
 
-bool CBlockTreeDB::WriteTimestampIndex(const CTimestampIndexKey &timestampIndex) {
+    // The records only count once the database says so, in the same batch
+    // that erases the database records they replace
     CDBBatch batch(*this);
-    batch.Write(std::make_pair(DB_TIMESTAMPINDEX, timestampIndex), 0);
-    return WriteBatch(batch);
-}
-
-bool CBlockTreeDB::ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<std::pair<uint256, unsigned int> > &hashes) {
-
-    const std::unique_ptr<CDBIterator> pcursor(NewIterator());
-
-    pcursor->Seek(std::make_pair(DB_TIMESTAMPINDEX, CTimestampIndexIteratorKey(low)));
-
-    while (pcursor->Valid()) {
-        if (ShutdownRequested()) return false;
-        std::pair<uint8_t, CTimestampIndexKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_TIMESTAMPINDEX && key.second.timestamp < high) {
-            hashes.push_back(std::make_pair(key.second.blockHash, key.second.timestamp));
-            pcursor->Next();
-        } else {
-            break;
-        }
+    for (const CBlockIndex* index : blocks) {
+        batch.Erase(std::make_pair(DB_BLOCK_INDEX, index->GetBlockHash()));
     }
+    batch.Write(DB_FLAT_BLOCK_INDEX_SIZE, int(m_flat_size + blocks.size()));
+    if (!WriteBatch(batch, true)) return false;
 
+    m_flat_size += blocks.size();
+    m_flat_tip = tip;
     return true;
 }
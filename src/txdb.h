@@ -12,9 +12,7 @@
 #include <sync.h>
 #include <util/fs.h>
 
-// Sugar: Addressindex
-#include <spentindex.h>
-
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -85,11 +83,29 @@ public:
     std::optional<fs::path> StoragePath() { return m_db->StoragePath(); }
 };
 
-/** Access to the block database (blocks/index/) */
+/** Access to the block database (blocks/index/)
+ *
+ * Entries of blocks buried deep in the active chain are moved out of the
+ * database into a flat file (blocks/blockindex.dat) of fixed-size records,
+ * one per height, which is memory-mapped at startup. An entry that changes
+ * after that is written to the database again, and the database record takes
+ * precedence over the flat one.
+ */
 class CBlockTreeDB : public CDBWrapper
 {
+private:
+    //! Location of the flat block index file, or nullopt for an in-memory database
+    std::optional<fs::path> m_flat_path;
+    //! Number of entries in the flat file, which are those of heights 0 to m_flat_size - 1
+    int m_flat_size{0};
+    //! Hash of the last entry in the flat file, null if there is none
+    uint256 m_flat_tip;
+
+    bool LoadFlatBlockIndex(const std::function<CBlockIndex*(const uint256&)>& insertBlockIndex, int num_threads);
+
 public:
-    using CDBWrapper::CDBWrapper;
+    explicit CBlockTreeDB(const DBParams& db_params);
+
     bool WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo);
     bool ReadBlockFileInfo(int nFile, CBlockFileInfo &info);
     bool ReadLastBlockFile(int &nFile);
@@ -97,24 +113,27 @@ public:
     void ReadReindexing(bool &fReindexing);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
-    bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex)
+    /** Read every block index entry, from the flat file and then from the
+     *  database, and copy it into the entry insertBlockIndex returns for its
+     *  hash. The entries are decoded on num_threads threads, each walking its
+     *  own slice of the records; insertBlockIndex is called from all of them,
+     *  one call at a time. */
+    bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, int num_threads = 1)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
-    // Sugar: Addressindex
-    bool ReadSpentIndex(const CSpentIndexKey &key, CSpentIndexValue &value);
-    bool UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >&vect);
-    bool UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect);
-    bool ReadAddressUnspentIndex(uint256 addressHash, int type,
-                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect);
-    bool WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
-    bool EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
-    bool ReadAddressIndex(uint256 addressHash, int type,
-                          std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
-                          int start = 0, int end = 0);
-    bool WriteTimestampIndex(const CTimestampIndexKey &timestampIndex);
-    bool ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<std::pair<uint256, unsigned int> > &vect) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    /** Append the entries of blocks to the flat block index file and erase
+     *  their database records. The blocks must continue the chain of entries
+     *  already in the file, one height after the other. */
+    bool WriteFlatBlockIndex(const std::vector<const CBlockIndex*>& blocks);
+    //! Number of entries loaded from, or written to, the flat block index file
+    int FlatBlockIndexSize() const { return m_flat_size; }
+    //! Number of entries committed to the flat block index file on disk, before it is loaded
+    int ReadFlatBlockIndexSize();
+    const uint256& FlatBlockIndexTip() const { return m_flat_tip; }
 };
 
 std::optional<bilingual_str> CheckLegacyTxindex(CBlockTreeDB& block_tree_db);
+/* Sugar: Addressindex */
+std::optional<bilingual_str> CheckLegacyAddressIndex(CBlockTreeDB& block_tree_db);
 
 #endif // BITCOIN_TXDB_H
@@ -26,6 +26,7 @@
 #include <validation.h>
 #include <hash.h>
 
+#include <algorithm>
 #include <cmath>
 #include <optional>
 #include <string_view>
@@ -502,6 +503,10 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
 
     RemoveUnbroadcastTx(hash, true /* add logging because unchecked */ );
 
+    // Sugar: Addressindex
+    removeAddressIndex(hash);
+    removeSpentIndex(hash);
+
     if (vTxHashes.size() > 1) {
         vTxHashes[it->vTxHashesIdx] = std::move(vTxHashes.back());
         vTxHashes[it->vTxHashesIdx].second->vTxHashesIdx = it->vTxHashesIdx;
@@ -1167,7 +1172,7 @@ void CTxMemPool::addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewC
 {
     LOCK(cs);
     const CTransaction& tx = entry.GetTx();
-    std::vector<CMempoolAddressDeltaKey> inserted;
+    std::vector<addressDeltaMap::value_type*> inserted;
 
     // ToDo: extract address hash and script type here
 
@@ -1187,8 +1192,7 @@ void CTxMemPool::addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewC
 
         CMempoolAddressDeltaKey key(scriptType, uint256(hashBytes.data(), hashBytes.size()), txhash, j, 1);
         CMempoolAddressDelta delta(count_seconds(entry.GetTime()), prevout.nValue * -1, input.prevout.hash, input.prevout.n);
-        mapAddress.insert(std::make_pair(key, delta));
-        inserted.push_back(key);
+        addAddressDelta(key, delta, inserted);
     }
 
     for (unsigned int k = 0; k < tx.vout.size(); k++) {
@@ -1203,11 +1207,24 @@ void CTxMemPool::addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewC
         }
 
         CMempoolAddressDeltaKey key(scriptType, uint256(hashBytes.data(), hashBytes.size()), txhash, k, 0);
-        mapAddress.insert(std::make_pair(key, CMempoolAddressDelta(count_seconds(entry.GetTime()), out.nValue)));
-        inserted.push_back(key);
+        addAddressDelta(key, CMempoolAddressDelta(count_seconds(entry.GetTime()), out.nValue), inserted);
     }
 
-    mapAddressInserted.insert(std::make_pair(txhash, inserted));
+    if (!inserted.empty()) {
+        mapAddressInserted.emplace(txhash, std::move(inserted));
+    }
+}
+
+void CTxMemPool::addAddressDelta(const CMempoolAddressDeltaKey &key, const CMempoolAddressDelta &delta,
+                                 std::vector<addressDeltaMap::value_type*> &inserted)
+{
+    AssertLockHeld(cs);
+    addressDeltaMap::value_type& bucket = *mapAddress.try_emplace(std::make_pair(key.type, key.addressBytes)).first;
+    auto [entries, added] = bucket.second.try_emplace(key.txhash);
+    entries->second.emplace_back(key, delta);
+    if (added) {
+        inserted.push_back(&bucket);
+    }
 }
 
 bool CTxMemPool::getAddressIndex(std::vector<std::pair<uint256, int> > &addresses,
@@ -1215,24 +1232,44 @@ bool CTxMemPool::getAddressIndex(std::vector<std::pair<uint256, int> > &addresse
 {
     LOCK(cs);
     for (std::vector<std::pair<uint256, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        addressDeltaMap::const_iterator ait = mapAddress.lower_bound(CMempoolAddressDeltaKey((*it).second, (*it).first));
-        while (ait != mapAddress.end() && (*ait).first.addressBytes == (*it).first && (*ait).first.type == (*it).second) {
-            results.push_back(*ait);
-            ait++;
+        addressDeltaMap::const_iterator ait = mapAddress.find(std::make_pair((*it).second, (*it).first));
+        if (ait != mapAddress.end()) {
+            for (const auto& [txhash, entries] : ait->second) {
+                results.insert(results.end(), entries.begin(), entries.end());
+            }
         }
     }
     return true;
 }
 
+bool CTxMemPool::getAddressIndex(const uint256 &txhash,
+                                 std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> > &results) const
+{
+    LOCK(cs);
+    addressDeltaMapInserted::const_iterator it = mapAddressInserted.find(txhash);
+    if (it == mapAddressInserted.end()) {
+        return false;
+    }
+
+    for (const addressDeltaMap::value_type* bucket : it->second) {
+        const addressDeltaEntries& entries = bucket->second.at(txhash);
+        results.insert(results.end(), entries.begin(), entries.end());
+    }
+    return true;
+}
+
 bool CTxMemPool::removeAddressIndex(const uint256 txhash)
 {
     LOCK(cs);
     addressDeltaMapInserted::iterator it = mapAddressInserted.find(txhash);
 
     if (it != mapAddressInserted.end()) {
-        std::vector<CMempoolAddressDeltaKey> keys = (*it).second;
-        for (std::vector<CMempoolAddressDeltaKey>::iterator mit = keys.begin(); mit != keys.end(); mit++) {
-            mapAddress.erase(*mit);
+        for (addressDeltaMap::value_type* bucket : it->second) {
+            bucket->second.erase(txhash);
+            if (bucket->second.empty()) {
+                const std::pair<int, uint256> address{bucket->first};
+                mapAddress.erase(address);
+            }
         }
         mapAddressInserted.erase(it);
     }
@@ -1269,7 +1306,9 @@ void CTxMemPool::addSpentIndex(const CTxMemPoolEntry &entry, const CCoinsViewCac
 
     }
 
-    mapSpentInserted.insert(make_pair(txhash, inserted));
+    if (!inserted.empty()) {
+        mapSpentInserted.emplace(txhash, std::move(inserted));
+    }
 }
 
 bool CTxMemPool::getSpentIndex(const CSpentIndexKey &key, CSpentIndexValue &value) const
@@ -1283,15 +1322,27 @@ bool CTxMemPool::getSpentIndex(const CSpentIndexKey &key, CSpentIndexValue &valu
     return false;
 }
 
+void CTxMemPool::getSpentIndex(const std::vector<CSpentIndexKey> &keys, std::vector<std::optional<CSpentIndexValue>> &values) const
+{
+    assert(keys.size() == values.size());
+    LOCK(cs);
+    if (mapSpent.empty()) return;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        mapSpentIndex::const_iterator it = mapSpent.find(keys[i]);
+        if (it != mapSpent.end()) {
+            values[i] = it->second;
+        }
+    }
+}
+
 bool CTxMemPool::removeSpentIndex(const uint256 txhash)
 {
     LOCK(cs);
     mapSpentIndexInserted::iterator it = mapSpentInserted.find(txhash);
 
     if (it != mapSpentInserted.end()) {
-        std::vector<CSpentIndexKey> keys = (*it).second;
-        for (std::vector<CSpentIndexKey>::iterator mit = keys.begin(); mit != keys.end(); mit++) {
-            mapSpent.erase(*mit);
+        for (const CSpentIndexKey& key : it->second) {
+            mapSpent.erase(key);
         }
         mapSpentInserted.erase(it);
     }
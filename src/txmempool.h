@@ -12,6 +12,7 @@
 #include <set>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -421,17 +422,28 @@ private:
     typedef std::map<txiter, setEntries, CompareIteratorByHash> cacheMap;
 
     // Sugar: Addressindex
-    typedef std::map<CMempoolAddressDeltaKey, CMempoolAddressDelta, CMempoolAddressDeltaKeyCompare> addressDeltaMap;
-    addressDeltaMap mapAddress;
+    /** The deltas of an address, by address type and hash, and by the
+     *  transaction that added them, in no particular order */
+    typedef std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> > addressDeltaEntries;
+    typedef std::unordered_map<uint256, addressDeltaEntries, SaltedTxidHasher> addressDeltaBucket;
+    typedef std::unordered_map<std::pair<int, uint256>, addressDeltaBucket, CMempoolAddressHasher> addressDeltaMap;
+    addressDeltaMap mapAddress GUARDED_BY(cs);
 
-    typedef std::map<uint256, std::vector<CMempoolAddressDeltaKey> > addressDeltaMapInserted;
-    addressDeltaMapInserted mapAddressInserted;
+    /** The buckets a transaction added deltas to, each once. Elements of an
+     *  unordered_map keep their address, and a bucket is only erased once it
+     *  is empty, so removing a transaction touches only its own entries. */
+    typedef std::unordered_map<uint256, std::vector<addressDeltaMap::value_type*>, SaltedTxidHasher> addressDeltaMapInserted;
+    addressDeltaMapInserted mapAddressInserted GUARDED_BY(cs);
 
-    typedef std::map<CSpentIndexKey, CSpentIndexValue, CSpentIndexKeyCompare> mapSpentIndex;
-    mapSpentIndex mapSpent;
+    typedef std::unordered_map<CSpentIndexKey, CSpentIndexValue, CSpentIndexKeyHasher> mapSpentIndex;
+    mapSpentIndex mapSpent GUARDED_BY(cs);
 
-    typedef std::map<uint256, std::vector<CSpentIndexKey> > mapSpentIndexInserted;
-    mapSpentIndexInserted mapSpentInserted;
+    typedef std::unordered_map<uint256, std::vector<CSpentIndexKey>, SaltedTxidHasher> mapSpentIndexInserted;
+    mapSpentIndexInserted mapSpentInserted GUARDED_BY(cs);
+
+    /** Add a delta to the bucket of its address, and note a new bucket for the transaction */
+    void addAddressDelta(const CMempoolAddressDeltaKey &key, const CMempoolAddressDelta &delta,
+                         std::vector<addressDeltaMap::value_type*> &inserted) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     void UpdateParent(txiter entry, txiter parent, bool add) EXCLUSIVE_LOCKS_REQUIRED(cs);
     void UpdateChild(txiter entry, txiter child, bool add) EXCLUSIVE_LOCKS_REQUIRED(cs);
@@ -508,10 +520,15 @@ public:
     void addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewCache &view);
     bool getAddressIndex(std::vector<std::pair<uint256, int> > &addresses,
                          std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> > &results) const;
+    /** Get the address index entries of a transaction in the mempool, false if it has none */
+    bool getAddressIndex(const uint256 &txhash,
+                         std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> > &results) const;
     bool removeAddressIndex(const uint256 txhash);
 
     void addSpentIndex(const CTxMemPoolEntry &entry, const CCoinsViewCache &view);
     bool getSpentIndex(const CSpentIndexKey &key, CSpentIndexValue &value) const;
+    /** Set the entries of values whose key is spent in the mempool, under a single lock */
+    void getSpentIndex(const std::vector<CSpentIndexKey> &keys, std::vector<std::optional<CSpentIndexValue>> &values) const;
     bool removeSpentIndex(const uint256 txhash);
 
     void removeRecursive(const CTransaction& tx, MemPoolRemovalReason reason) EXCLUSIVE_LOCKS_REQUIRED(cs);
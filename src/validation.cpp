@@ -85,7 +85,6 @@ using node::UnlinkPrunedFiles;
 
 // Sugar: Addressindex
 bool fAddressIndex = false;
-bool fTimestampIndex = false;
 bool fSpentIndex = false;
 
 /** Maximum kilobytes for transactions to store for processing during reorg */
@@ -133,16 +132,28 @@ bool ExtractIndexInfo(const CScript *pScript, int &scriptType, std::vector<uint8
         hashBytes.assign(pScript->begin() + 2, pScript->begin() + 34);
         scriptType = ADDR_INDT_WITNESS_V0_SCRIPTHASH;
     } else if (pScript->IsWitnessProgram(witnessversion, witnessprogram)) {
-        hashBytes.assign(witnessprogram.begin(), witnessprogram.begin() + witnessprogram.size());
-        switch (witnessversion) {
-            case 0: scriptType = ADDR_INDT_WITNESS_V0_KEYHASH; break;
-            case 1: scriptType = ADDR_INDT_WITNESS_V1_TAPROOT; break;
+        // Programs of other lengths are not addresses, and do not fit a hash
+        if (witnessversion == 0 && witnessprogram.size() == WITNESS_V0_KEYHASH_SIZE) {
+            scriptType = ADDR_INDT_WITNESS_V0_KEYHASH;
+        } else if (witnessversion == 1 && witnessprogram.size() == WITNESS_V1_TAPROOT_SIZE) {
+            scriptType = ADDR_INDT_WITNESS_V1_TAPROOT;
         }
+        if (scriptType != ADDR_INDT_UNKNOWN) hashBytes = witnessprogram;
     }
 
     return true;
 };
 
+std::optional<std::pair<int, uint256>> ExtractIndexAddress(const CTxDestination& dest)
+{
+    if (!IsValidDestination(dest)) return std::nullopt;
+    const CScript script{GetScriptForDestination(dest)};
+    int type;
+    std::vector<uint8_t> hash_bytes;
+    if (!ExtractIndexInfo(&script, type, hash_bytes) || type == ADDR_INDT_UNKNOWN) return std::nullopt;
+    return std::make_pair(type, uint256(hash_bytes.data(), hash_bytes.size()));
+}
+
 const CBlockIndex* Chainstate::FindForkInGlobalIndex(const CBlockLocator& locator) const
 {
     AssertLockHeld(cs_main);
@@ -1971,11 +1982,6 @@ DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIn
     */
     bool fEnforceBIP30 = true;
 
-    // Sugar: Addressindex
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
-    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
-
     // undo transactions in reverse order
     for (int i = block.vtx.size() - 1; i >= 0; i--) {
         const CTransaction &tx = *(block.vtx[i]);
@@ -1983,28 +1989,6 @@ DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIn
         bool is_coinbase = tx.IsCoinBase();
         bool is_bip30_exception = (is_coinbase && !fEnforceBIP30);
 
-        // Sugar: Addressindex
-        if (fAddressIndex) {
-
-            for (unsigned int k = tx.vout.size(); k-- > 0;) {
-                const CTxOut &out = tx.vout[k];
-
-                std::vector<unsigned char> hashBytes;
-                int scriptType = 0;
-
-                if (!ExtractIndexInfo(&out.scriptPubKey, scriptType, hashBytes)
-                    || scriptType == 0) {
-                    continue;
-                }
-
-                // undo receiving activity
-                addressIndex.push_back(std::make_pair(CAddressIndexKey(scriptType, uint256(hashBytes.data(), hashBytes.size()), pindex->nHeight, i, hash, k, false), out.nValue));
-
-                // undo unspent index
-                addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(scriptType, uint256(hashBytes.data(), hashBytes.size()), hash, k), CAddressUnspentValue()));
-            }
-        }
-
         // Check that all outputs are available and match the outputs in the block itself
         // exactly.
         for (size_t o = 0; o < tx.vout.size(); o++) {
@@ -2033,51 +2017,11 @@ DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIn
                 int res = ApplyTxInUndo(std::move(txundo.vprevout[j]), view, out);
                 if (res == DISCONNECT_FAILED) return DISCONNECT_FAILED;
                 fClean = fClean && res != DISCONNECT_UNCLEAN;
-
-                // Sugar: Addressindex
-                int undoHeight = txundo.vprevout[j].nHeight;
-                const CTxIn input = tx.vin[j];
-
-                if (fSpentIndex) {
-                    // undo and delete the spent index
-                    spentIndex.push_back(std::make_pair(CSpentIndexKey(input.prevout.hash, input.prevout.n), CSpentIndexValue()));
-                }
-
-                if (fAddressIndex) {
-                    const Coin &coin = view.AccessCoin(tx.vin[j].prevout);
-                    const CTxOut &prevout = coin.out;
-
-                    std::vector<unsigned char> hashBytes;
-                    int scriptType = 0;
-
-                    if (!ExtractIndexInfo(&prevout.scriptPubKey, scriptType, hashBytes)
-                        || scriptType == 0) {
-                        continue;
-                    }
-
-                    // undo spending activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(scriptType, uint256(hashBytes.data(), hashBytes.size()), pindex->nHeight, i, hash, j, true), prevout.nValue * -1));
-
-                    // restore unspent index
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(scriptType, uint256(hashBytes.data(), hashBytes.size()), input.prevout.hash, input.prevout.n), CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, undoHeight)));
-                }
             }
             // At this point, all of txundo.vprevout should have been moved out.
         }
     }
 
-    // Sugar: Addressindex
-    if (fAddressIndex) {
-        if (!m_blockman.m_block_tree_db->EraseAddressIndex(addressIndex)) {
-            AbortNode("Failed to delete address index");
-            return DISCONNECT_FAILED;
-        }
-        if (!m_blockman.m_block_tree_db->UpdateAddressUnspentIndex(addressUnspentIndex)) {
-            AbortNode("Failed to write address unspent index");
-            return DISCONNECT_FAILED;
-        }
-    }
-
     // move best block pointer to prevout block
     view.SetBestBlock(pindex->pprev->GetBlockHash());
 
@@ -2096,6 +2040,39 @@ void StopScriptCheckWorkerThreads()
     scriptcheckqueue.StopWorkerThreads();
 }
 
+/* YespowerSugar */
+/** Closure representing one header's proof-of-work check. */
+class CPoWCheck
+{
+private:
+    const CBlockHeader* m_header{nullptr};
+    const Consensus::Params* m_params{nullptr};
+
+public:
+    CPoWCheck() = default;
+    CPoWCheck(const CBlockHeader& header, const Consensus::Params& params) : m_header(&header), m_params(&params) {}
+
+    bool operator()() const
+    {
+        // GetPoWHash_cached() is safe to call concurrently and leaves the
+        // result in the PoW hash cache, so later checks of this header hit it.
+        return CheckProofOfWork(m_header->GetPoWHash_cached(), m_header->nBits, *m_params);
+    }
+};
+
+// Each check is a full Yespower hash, so keep batches small for an even split.
+static CCheckQueue<CPoWCheck> powcheckqueue(8, "powch");
+
+void StartPoWCheckWorkerThreads(int threads_num)
+{
+    powcheckqueue.StartWorkerThreads(threads_num);
+}
+
+void StopPoWCheckWorkerThreads()
+{
+    powcheckqueue.StopWorkerThreads();
+}
+
 /**
  * Threshold condition checker that triggers when unknown versionbits are seen on the network.
  */
@@ -2394,18 +2371,10 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     int64_t nSigOpsCost = 0;
     blockundo.vtxundo.reserve(block.vtx.size() - 1);
 
-    // Sugar: Addressindex
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
-    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
-
     for (unsigned int i = 0; i < block.vtx.size(); i++)
     {
         const CTransaction &tx = *(block.vtx[i]);
 
-        // Sugar: Addressindex
-        const uint256 txhash = tx.GetHash();
-
         nInputs += tx.vin.size();
 
         if (!tx.IsCoinBase())
@@ -2436,38 +2405,6 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
                 LogPrintf("ERROR: %s: contains a non-BIP68-final transaction\n", __func__);
                 return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-txns-nonfinal");
             }
-
-            // Sugar: Addressindex
-            if (fAddressIndex || fSpentIndex)
-            {
-                for (size_t j = 0; j < tx.vin.size(); j++) {
-                    const CTxIn input = tx.vin[j];
-                    const Coin& coin = view.AccessCoin(tx.vin[j].prevout);
-                    const CTxOut &prevout = coin.out;
-
-                    std::vector<unsigned char> hashBytes;
-                    int scriptType = 0;
-
-                    if (!ExtractIndexInfo(&prevout.scriptPubKey, scriptType, hashBytes)
-                        || scriptType == 0) {
-                        continue;
-                    }
-
-                    if (fAddressIndex) {
-                        // record spending activity
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(scriptType, uint256(hashBytes.data(), hashBytes.size()), pindex->nHeight, i, txhash, j, true), prevout.nValue * -1));
-
-                        // remove address from unspent index
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(scriptType, uint256(hashBytes.data(), hashBytes.size()), input.prevout.hash, input.prevout.n), CAddressUnspentValue()));
-                    }
-
-                    if (fSpentIndex) {
-                        // add the spent index to determine the txid and input that spent an output
-                        // and to find the amount and address from an input
-                        spentIndex.push_back(std::make_pair(CSpentIndexKey(input.prevout.hash, input.prevout.n), CSpentIndexValue(txhash, j, pindex->nHeight, prevout.nValue, scriptType, uint256(hashBytes.data(), hashBytes.size()))));
-                    }
-                }
-            }
         }
 
         // GetTransactionSigOpCost counts 3 types of sigops:
@@ -2495,27 +2432,6 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
             control.Add(std::move(vChecks));
         }
 
-        // Sugar: Addressindex
-        if (fAddressIndex) {
-            for (unsigned int k = 0; k < tx.vout.size(); k++) {
-                const CTxOut &out = tx.vout[k];
-
-                std::vector<unsigned char> hashBytes;
-                int scriptType = 0;
-
-                if (!ExtractIndexInfo(&out.scriptPubKey, scriptType, hashBytes)
-                    || scriptType == 0) {
-                    continue;
-                }
-
-                // record receiving activity
-                addressIndex.push_back(std::make_pair(CAddressIndexKey(scriptType, uint256(hashBytes.data(), hashBytes.size()), pindex->nHeight, i, txhash, k, false), out.nValue));
-
-                // record unspent output
-                addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(scriptType, uint256(hashBytes.data(), hashBytes.size()), txhash, k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
-            }
-        }
-
         CTxUndo undoDummy;
         if (i > 0) {
             blockundo.vtxundo.push_back(CTxUndo());
@@ -2562,30 +2478,11 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
              Ticks<SecondsDouble>(time_undo),
              Ticks<MillisecondsDouble>(time_undo) / num_blocks_total);
 
-    // Sugar: Addressindex
     if (!pindex->IsValid(BLOCK_VALID_SCRIPTS)) {
         pindex->RaiseValidity(BLOCK_VALID_SCRIPTS);
         m_blockman.m_dirty_blockindex.insert(pindex);
     }
 
-    if (fAddressIndex) {
-        if (!m_blockman.m_block_tree_db->WriteAddressIndex(addressIndex)) {
-            return AbortNode(state, "Failed to write address index");
-        }
-
-        if (!m_blockman.m_block_tree_db->UpdateAddressUnspentIndex(addressUnspentIndex)) {
-            return AbortNode(state, "Failed to write address unspent index");
-        }
-    }
-
-    if (fSpentIndex)
-        if (!m_blockman.m_block_tree_db->UpdateSpentIndex(spentIndex))
-            return AbortNode(state, "Failed to write transaction index");
-
-    if (fTimestampIndex)
-        if (!m_blockman.m_block_tree_db->WriteTimestampIndex(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())))
-            return AbortNode(state, "Failed to write timestamp index");
-
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
 
@@ -2745,6 +2642,22 @@ bool Chainstate::FlushStateToDisk(
             }
             m_last_write = nNow;
         }
+        // Move buried block index entries to the flat file, a batch at a time.
+        // While the file lags behind, this happens on every periodic flush, so
+        // it catches up over many short steps.
+        const bool fFlatCatchUp{!fDoFullFlush && !fPeriodicWrite && mode == FlushStateMode::PERIODIC && m_blockman.FlatBlockIndexLags(m_chain)};
+        if (fDoFullFlush || fPeriodicWrite || fFlatCatchUp) {
+            if (fFlatCatchUp) {
+                // The moved entries refer to block and undo data, which has
+                // to be on disk first, as above.
+                LOG_TIME_MILLIS_WITH_CATEGORY("write block and undo data to disk", BCLog::BENCH);
+                m_blockman.FlushBlockFile();
+            }
+            LOG_TIME_MILLIS_WITH_CATEGORY("write flat block index to disk", BCLog::BENCH);
+            if (!m_blockman.WriteFlatBlockIndex(m_chain)) {
+                return AbortNode(state, "Failed to write to flat block index file");
+            }
+        }
         // Flush best chain related state. This can only be done if the blocks / block index write was also done.
         if (fDoFullFlush && !CoinsTip().GetBestBlock().IsNull()) {
             LOG_TIME_MILLIS_WITH_CATEGORY(strprintf("write coins cache to disk (%d coins, %.2fkB)",
@@ -3808,8 +3721,21 @@ std::vector<unsigned char> ChainstateManager::GenerateCoinbaseCommitment(CBlock&
 
 bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams)
 {
-    return std::all_of(headers.cbegin(), headers.cend(),
-            [&](const auto& header) { return CheckProofOfWork(header.GetPoWHash_cached(), header.nBits, consensusParams);});
+    if (headers.size() < 2 || !powcheckqueue.HasThreads()) {
+        return std::all_of(headers.cbegin(), headers.cend(),
+                [&](const auto& header) { return CheckProofOfWork(header.GetPoWHash_cached(), header.nBits, consensusParams);});
+    }
+
+    /* YespowerSugar */
+    // The calling thread joins the workers until the whole batch is checked.
+    CCheckQueueControl<CPoWCheck> control(&powcheckqueue);
+    std::vector<CPoWCheck> checks;
+    checks.reserve(headers.size());
+    for (const CBlockHeader& header : headers) {
+        checks.emplace_back(header, consensusParams);
+    }
+    control.Add(std::move(checks));
+    return control.Wait();
 }
 
 arith_uint256 CalculateHeadersWork(const std::vector<CBlockHeader>& headers)
@@ -4082,27 +4008,6 @@ bool ChainstateManager::ProcessNewBlockHeaders(const std::vector<CBlockHeader>&
 {
     AssertLockNotHeld(cs_main);
 
-    /* YespowerSugar */
-    // Look for this block's header in the index like AcceptBlock() will
-    {
-        LOCK(cs_main);
-
-        for (const CBlockHeader& header : headers) {
-            uint256 hash = header.GetHash();
-            BlockMap::iterator miSelf{m_blockman.m_block_index.find(hash)};
-            if (miSelf != m_blockman.m_block_index.end()) {
-                // Block header is already known
-                CBlockIndex* pindex = &(miSelf->second);
-                if (!header.cache_init && pindex->cache_init) {
-                    LOCK(header.cache_lock); // Probably unnecessary since no concurrent access to pblock is expected
-                    header.cache_init = true;
-                    header.cache_block_hash = pindex->cache_block_hash;
-                    header.cache_PoW_hash = pindex->cache_PoW_hash;
-                }
-            }
-        }
-    }
-
     {
         LOCK(cs_main);
         for (const CBlockHeader& header : headers) {
@@ -4726,19 +4631,6 @@ bool ChainstateManager::LoadBlockIndex()
         // needs_init.
 
         LogPrintf("Initializing databases...\n");
-
-        // Sugar: Addressindex
-        // Use the provided setting for -addressindex in the new database
-        fAddressIndex = gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
-        m_blockman.m_block_tree_db->WriteFlag("addressindex", fAddressIndex);
-
-        // Use the provided setting for -timestampindex in the new database
-        fTimestampIndex = gArgs.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
-        m_blockman.m_block_tree_db->WriteFlag("timestampindex", fTimestampIndex);
-
-        // Use the provided setting for -spentindex in the new database
-        fSpentIndex = gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX);
-        m_blockman.m_block_tree_db->WriteFlag("spentindex", fSpentIndex);
     }
     return true;
 }
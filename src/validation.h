@@ -24,6 +24,7 @@
 #include <policy/policy.h>
 #include <script/script_error.h>
 #include <shutdown.h>
+#include <spentindex.h>
 #include <sync.h>
 #include <txdb.h>
 #include <txmempool.h> // For CTxMemPool::cs
@@ -62,25 +63,15 @@ struct Params;
 } // namespace Consensus
 
 // Sugar: Addressindex
-static const bool DEFAULT_ADDRESSINDEX{false};
-static const bool DEFAULT_TIMESTAMPINDEX{false};
-static const bool DEFAULT_SPENTINDEX{false};
-
-// Address index
+// Whether the mempool keeps address and spent indexes of its transactions,
+// set when the corresponding index in index/ is enabled
 extern bool fAddressIndex;
-extern bool fTimestampIndex;
 extern bool fSpentIndex;
 
-enum AddressIndexType {
-    ADDR_INDT_UNKNOWN                = 0,
-    ADDR_INDT_PUBKEY_ADDRESS         = 1,
-    ADDR_INDT_SCRIPT_ADDRESS         = 2,
-    ADDR_INDT_WITNESS_V0_KEYHASH     = 5,
-    ADDR_INDT_WITNESS_V0_SCRIPTHASH  = 6,
-    ADDR_INDT_WITNESS_V1_TAPROOT     = 7
-};
-
 bool ExtractIndexInfo(const CScript *pScript, int &scriptType, std::vector<uint8_t> &hashBytes);
+/** Address type and hash of a destination, as ExtractIndexInfo extracts them
+ *  from its script. Nothing if the destination is invalid or not indexed. */
+std::optional<std::pair<int, uint256>> ExtractIndexAddress(const CTxDestination& dest);
 
 /** Maximum number of dedicated script-checking threads allowed */
 static const int MAX_SCRIPTCHECK_THREADS = 15;
@@ -122,6 +113,11 @@ void StartScriptCheckWorkerThreads(int threads_num);
 /** Stop all of the script checking worker threads */
 void StopScriptCheckWorkerThreads();
 
+/** Run instances of header proof-of-work checking worker threads */
+void StartPoWCheckWorkerThreads(int threads_num);
+/** Stop all of the header proof-of-work checking worker threads */
+void StopPoWCheckWorkerThreads();
+
 CAmount GetBlockSubsidy(int nHeight, const Consensus::Params& consensusParams);
 
 bool AbortNode(BlockValidationState& state, const std::string& strMessage, const bilingual_str& userMessage = bilingual_str{});
@@ -370,7 +366,8 @@ bool TestBlockValidity(BlockValidationState& state,
                        bool fCheckPOW = true,
                        bool fCheckMerkleRoot = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
-/** Check with the proof of work on each blockheader matches the value in nBits */
+/** Check the proof-of-work of a batch of headers, spread over the PoW check
+ *  worker threads when they are running. Leaves the PoW hashes in the PoW hash cache. */
 bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams);
 
 /** Return the sum of the work on a given set of headers */
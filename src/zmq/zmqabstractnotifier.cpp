@@ -42,3 +42,8 @@ bool CZMQAbstractNotifier::NotifyTransactionRemoval(const CTransaction &/*transa
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyAddressDeltas(const uint256 &/*hash*/, char /*label*/, const CZMQAddressDeltas &/*deltas*/)
+{
+    return true;
+}
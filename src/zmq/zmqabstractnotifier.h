@@ -5,9 +5,14 @@
 #ifndef BITCOIN_ZMQ_ZMQABSTRACTNOTIFIER_H
 #define BITCOIN_ZMQ_ZMQABSTRACTNOTIFIER_H
 
+#include <consensus/amount.h>
+#include <uint256.h>
+
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
 
 class CBlockIndex;
 class CTransaction;
@@ -15,6 +20,10 @@ class CZMQAbstractNotifier;
 
 using CZMQNotifierFactory = std::unique_ptr<CZMQAbstractNotifier> (*)();
 
+// Sugar: Addressindex
+/** Net balance change of each address, by address type and hash */
+using CZMQAddressDeltas = std::map<std::pair<int, uint256>, CAmount>;
+
 class CZMQAbstractNotifier
 {
 public:
@@ -55,6 +64,9 @@ public:
     virtual bool NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence);
     // Notifies of transactions added to mempool or appearing in blocks
     virtual bool NotifyTransaction(const CTransaction &transaction);
+    // Notifies of the balance changes of addresses by a transaction accepted
+    // to the mempool, or by a block that was connected or disconnected
+    virtual bool NotifyAddressDeltas(const uint256 &hash, char label, const CZMQAddressDeltas &deltas);
 
 protected:
     void* psocket{nullptr};
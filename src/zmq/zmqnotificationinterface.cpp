@@ -4,10 +4,14 @@
 
 #include <zmq/zmqnotificationinterface.h>
 
+#include <key_io.h>
 #include <logging.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
+#include <tinyformat.h>
+#include <util/string.h>
 #include <util/system.h>
+#include <validation.h>
 #include <validationinterface.h>
 #include <zmq/zmqabstractnotifier.h>
 #include <zmq/zmqpublishnotifier.h>
@@ -16,7 +20,9 @@
 #include <zmq.h>
 
 #include <cassert>
+#include <fstream>
 #include <map>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -39,7 +45,7 @@ std::list<const CZMQAbstractNotifier*> CZMQNotificationInterface::GetActiveNotif
     return result;
 }
 
-CZMQNotificationInterface* CZMQNotificationInterface::Create()
+CZMQNotificationInterface* CZMQNotificationInterface::Create(MempoolAddressIndexFn get_mempool_address_index)
 {
     std::map<std::string, CZMQNotifierFactory> factories;
     factories["pubhashblock"] = CZMQAbstractNotifier::Create<CZMQPublishHashBlockNotifier>;
@@ -47,6 +53,7 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     factories["pubrawblock"] = CZMQAbstractNotifier::Create<CZMQPublishRawBlockNotifier>;
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
     factories["pubsequence"] = CZMQAbstractNotifier::Create<CZMQPublishSequenceNotifier>;
+    factories["pubaddressdelta"] = CZMQAbstractNotifier::Create<CZMQPublishAddressDeltaNotifier>; // Sugar: Addressindex
 
     std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
     for (const auto& entry : factories)
@@ -65,7 +72,11 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     if (!notifiers.empty())
     {
         std::unique_ptr<CZMQNotificationInterface> notificationInterface(new CZMQNotificationInterface());
+        for (const auto& notifier : notifiers) {
+            notificationInterface->m_address_deltas |= notifier->GetType() == "pubaddressdelta";
+        }
         notificationInterface->notifiers = std::move(notifiers);
+        notificationInterface->m_get_mempool_address_index = std::move(get_mempool_address_index);
 
         if (notificationInterface->Initialize()) {
             return notificationInterface.release();
@@ -139,6 +150,75 @@ void TryForEachAndRemoveFailed(std::list<std::unique_ptr<CZMQAbstractNotifier>>&
 
 } // anonymous namespace
 
+bool CZMQNotificationInterface::SetAddressFilter(const std::vector<std::string>& addresses, std::string& error)
+{
+    decltype(m_address_filter) filter;
+    for (const std::string& address : addresses) {
+        const auto indexed{ExtractIndexAddress(DecodeDestination(address))};
+        if (!indexed) {
+            error = strprintf("Invalid address or address type not indexed: %s", address);
+            return false;
+        }
+        filter.insert(*indexed);
+    }
+
+    LOCK(m_address_filter_mutex);
+    m_address_filter = std::move(filter);
+    return true;
+}
+
+bool CZMQNotificationInterface::LoadAddressFilter(const fs::path& path, std::string& error)
+{
+    std::ifstream file{path};
+    if (!file.is_open()) {
+        error = strprintf("Cannot open address filter file %s", fs::PathToString(path));
+        return false;
+    }
+
+    std::vector<std::string> addresses;
+    std::string line;
+    while (std::getline(file, line)) {
+        line = TrimString(line);
+        if (line.empty() || line[0] == '#') continue;
+        addresses.push_back(line);
+    }
+    return SetAddressFilter(addresses, error);
+}
+
+size_t CZMQNotificationInterface::GetAddressFilterSize() const
+{
+    LOCK(m_address_filter_mutex);
+    return m_address_filter.size();
+}
+
+void CZMQNotificationInterface::NotifyAddressDeltas(const uint256& hash, char label, CZMQAddressDeltas deltas)
+{
+    {
+        LOCK(m_address_filter_mutex);
+        if (!m_address_filter.empty()) {
+            for (auto it = deltas.begin(); it != deltas.end();) {
+                it = m_address_filter.count(it->first) ? std::next(it) : deltas.erase(it);
+            }
+        }
+    }
+    if (deltas.empty()) return;
+
+    TryForEachAndRemoveFailed(notifiers, [&hash, label, &deltas](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyAddressDeltas(hash, label, deltas);
+    });
+}
+
+void CZMQNotificationInterface::NotifyBlockAddressDeltas(const uint256& block_hash, bool connected, const AddressIndex::BalanceDeltas& balance_deltas)
+{
+    if (!m_address_deltas) return;
+
+    CZMQAddressDeltas deltas;
+    for (const auto& [address, delta] : balance_deltas) {
+        deltas.emplace(address, delta.balance);
+    }
+    NotifyAddressDeltas(block_hash, connected ? /* Block (C)onnect */ 'C' : /* Block (D)isconnect */ 'D', std::move(deltas));
+}
+
 void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
 {
     if (fInitialDownload || pindexNew == pindexFork) // In IBD or blocks were disconnected without any new ones
@@ -156,6 +236,17 @@ void CZMQNotificationInterface::TransactionAddedToMempool(const CTransactionRef&
     TryForEachAndRemoveFailed(notifiers, [&tx, mempool_sequence](CZMQAbstractNotifier* notifier) {
         return notifier->NotifyTransaction(tx) && notifier->NotifyTransactionAcceptance(tx, mempool_sequence);
     });
+
+    // Sugar: Addressindex
+    std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta>> entries;
+    // a transaction that has already left the mempool is published with its block
+    if (m_address_deltas && m_get_mempool_address_index(tx.GetHash(), entries)) {
+        CZMQAddressDeltas deltas;
+        for (const auto& [key, delta] : entries) {
+            deltas[{key.type, key.addressBytes}] += delta.amount;
+        }
+        NotifyAddressDeltas(tx.GetHash(), /* Mempool (A)cceptance */ 'A', std::move(deltas));
+    }
 }
 
 void CZMQNotificationInterface::TransactionRemovedFromMempool(const CTransactionRef& ptx, MemPoolRemovalReason reason, uint64_t mempool_sequence)
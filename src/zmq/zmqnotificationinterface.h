@@ -5,12 +5,22 @@
 #ifndef BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 #define BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 
+#include <addressindex.h>
+#include <index/addressindex.h>
 #include <primitives/transaction.h>
+#include <sync.h>
+#include <util/fs.h>
 #include <validationinterface.h>
+#include <zmq/zmqabstractnotifier.h>
 
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
 class CBlock;
 class CBlockIndex;
@@ -19,11 +29,31 @@ class CZMQAbstractNotifier;
 class CZMQNotificationInterface final : public CValidationInterface
 {
 public:
+    // Sugar: Addressindex
+    /** Looks up the address index entries of a transaction in the mempool */
+    using MempoolAddressIndexFn = std::function<bool(const uint256& txhash, std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta>>& entries)>;
+
     virtual ~CZMQNotificationInterface();
 
     std::list<const CZMQAbstractNotifier*> GetActiveNotifiers() const;
 
-    static CZMQNotificationInterface* Create();
+    static CZMQNotificationInterface* Create(MempoolAddressIndexFn get_mempool_address_index);
+
+    /** Only publish the balance changes of these addresses in addressdelta
+     * notifications, or of all addresses if the list is empty. Returns false
+     * and leaves the filter unchanged if an address is not indexed. */
+    bool SetAddressFilter(const std::vector<std::string>& addresses, std::string& error) EXCLUSIVE_LOCKS_REQUIRED(!m_address_filter_mutex);
+
+    /** Set the address filter from a file with an address per line. Empty
+     * lines and lines starting with # are skipped. */
+    bool LoadAddressFilter(const fs::path& path, std::string& error) EXCLUSIVE_LOCKS_REQUIRED(!m_address_filter_mutex);
+
+    /** Number of addresses in the address filter, 0 if there is none */
+    size_t GetAddressFilterSize() const EXCLUSIVE_LOCKS_REQUIRED(!m_address_filter_mutex);
+
+    /** Publish the balance changes of a block the address index connected or
+     *  disconnected, see AddressIndex::SetBlockDeltasNotifier() */
+    void NotifyBlockAddressDeltas(const uint256& block_hash, bool connected, const AddressIndex::BalanceDeltas& balance_deltas) EXCLUSIVE_LOCKS_REQUIRED(!m_address_filter_mutex);
 
 protected:
     bool Initialize();
@@ -39,8 +69,17 @@ protected:
 private:
     CZMQNotificationInterface();
 
+    /** Publish the balance changes of the addresses that pass the filter */
+    void NotifyAddressDeltas(const uint256& hash, char label, CZMQAddressDeltas deltas) EXCLUSIVE_LOCKS_REQUIRED(!m_address_filter_mutex);
+
     void* pcontext{nullptr};
     std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
+
+    MempoolAddressIndexFn m_get_mempool_address_index;
+    /** Whether an addressdelta notifier is active, so the balance changes are needed */
+    bool m_address_deltas{false};
+    mutable Mutex m_address_filter_mutex;
+    std::set<std::pair<int, uint256>> m_address_filter GUARDED_BY(m_address_filter_mutex);
 };
 
 extern CZMQNotificationInterface* g_zmq_notification_interface;
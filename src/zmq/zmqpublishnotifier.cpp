@@ -16,6 +16,7 @@
 #include <primitives/transaction.h>
 #include <rpc/server.h>
 #include <serialize.h>
+#include <spentindex.h>
 #include <streams.h>
 #include <sync.h>
 #include <uint256.h>
@@ -48,6 +49,7 @@ static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
 static const char *MSG_SEQUENCE  = "sequence";
+static const char *MSG_ADDRESSDELTA = "addressdelta"; // Sugar: Addressindex
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -309,3 +311,21 @@ bool CZMQPublishSequenceNotifier::NotifyTransactionRemoval(const CTransaction &t
     LogPrint(BCLog::ZMQ, "Publish hashtx mempool removal %s to %s\n", hash.GetHex(), this->address);
     return SendSequenceMsg(*this, hash, /* Mempool (R)emoval */ 'R', mempool_sequence);
 }
+
+// Sugar: Addressindex
+bool CZMQPublishAddressDeltaNotifier::NotifyAddressDeltas(const uint256 &hash, char label, const CZMQAddressDeltas &deltas)
+{
+    LogPrint(BCLog::ZMQ, "Publish addressdelta %s %c for %u addresses to %s\n", hash.GetHex(), label, deltas.size(), this->address);
+    // <32-byte hash> | <1-byte label> | <compact size count> | count * (<address> | <8-byte LE satoshis>)
+    DataStream ss{};
+    for (unsigned int i = 0; i < sizeof(hash); ++i) {
+        ser_writedata8(ss, hash.begin()[sizeof(hash) - 1 - i]);
+    }
+    ser_writedata8(ss, label);
+    WriteCompactSize(ss, deltas.size());
+    for (const auto& [address, satoshis] : deltas) {
+        SerializeAddress(ss, address.first, address.second);
+        ss << satoshis;
+    }
+    return SendZmqMessage(MSG_ADDRESSDELTA, ss.data(), ss.size());
+}
@@ -65,4 +65,11 @@ public:
     bool NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence) override;
 };
 
+// Sugar: Addressindex
+class CZMQPublishAddressDeltaNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyAddressDeltas(const uint256 &hash, char label, const CZMQAddressDeltas &deltas) override;
+};
+
 #endif // BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
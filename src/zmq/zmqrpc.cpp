@@ -4,6 +4,7 @@
 
 #include <zmq/zmqrpc.h>
 
+#include <rpc/protocol.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
 #include <zmq/zmqabstractnotifier.h>
@@ -13,6 +14,7 @@
 
 #include <list>
 #include <string>
+#include <vector>
 
 class JSONRPCRequest;
 
@@ -56,8 +58,46 @@ static RPCHelpMan getzmqnotifications()
     };
 }
 
+// Sugar: Addressindex
+static RPCHelpMan setzmqaddressfilter()
+{
+    return RPCHelpMan{"setzmqaddressfilter",
+                "\nSets the addresses whose balance changes are published by the addressdelta notifications.\n"
+                "This replaces the list loaded with -zmqpubaddressdeltafilter. With an empty list, the changes of all addresses are published.\n",
+                {
+                    {"addresses", RPCArg::Type::ARR, RPCArg::Optional::NO, "The addresses to publish the balance changes of",
+                        {
+                            {"address", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "The base58check encoded address"},
+                        },
+                    },
+                },
+                RPCResult{RPCResult::Type::NUM, "", "The number of addresses that are published, 0 for all"},
+                RPCExamples{
+                    HelpExampleCli("setzmqaddressfilter", "'[\"" + EXAMPLE_ADDRESS[0] + "\"]'")
+            + HelpExampleRpc("setzmqaddressfilter", "[\"" + EXAMPLE_ADDRESS[0] + "\"]")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    if (g_zmq_notification_interface == nullptr) {
+        throw JSONRPCError(RPC_MISC_ERROR, "No ZeroMQ notifications are active");
+    }
+
+    std::vector<std::string> addresses;
+    for (const UniValue& address : request.params[0].get_array().getValues()) {
+        addresses.push_back(address.get_str());
+    }
+    std::string error;
+    if (!g_zmq_notification_interface->SetAddressFilter(addresses, error)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, error);
+    }
+    return uint64_t(g_zmq_notification_interface->GetAddressFilterSize());
+},
+    };
+}
+
 const CRPCCommand commands[]{
     {"zmq", &getzmqnotifications},
+    {"zmq", &setzmqaddressfilter},
 };
 
 } // anonymous namespace
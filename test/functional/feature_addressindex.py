@@ -0,0 +1,251 @@
+#!/usr/bin/env python3
+# Copyright (c) 2014-2022 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the address index RPCs.
+
+Check that getaddressutxos, getaddressdeltas and getaddresstxids return
+the same entries whether read at once or page by page, and that the
+paging arguments are checked. Check that the balance records agree with
+the address history across reorgs, restarts and a crash.
+"""
+
+from test_framework.address import byte_to_base58
+from test_framework.messages import (
+    COutPoint,
+    CTransaction,
+    CTxIn,
+    CTxOut,
+)
+from test_framework.script import (
+    CScript,
+    OP_TRUE,
+    hash160,
+)
+from test_framework.script_util import (
+    keyhash_to_p2pkh_script,
+    script_to_p2sh_script,
+)
+from test_framework.test_framework import SugarchainTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_raises_rpc_error,
+)
+
+# Regtest base58 prefixes of Sugarchain
+PUBKEY_ADDRESS_VERSION = 61
+SCRIPT_ADDRESS_VERSION = 123
+
+# Anyone can spend outputs to this P2SH address, which makes it the miner
+# and the funding address of the test
+REDEEM_SCRIPT = CScript([OP_TRUE])
+MINER_SCRIPT = script_to_p2sh_script(REDEEM_SCRIPT)
+MINER_ADDRESS = byte_to_base58(hash160(REDEEM_SCRIPT), SCRIPT_ADDRESS_VERSION)
+
+FEE = 1000
+
+
+def p2pkh_address(n):
+    """A P2PKH address and its script, for a made-up key hash"""
+    key_hash = hash160(bytes([n]))
+    return byte_to_base58(key_hash, PUBKEY_ADDRESS_VERSION), keyhash_to_p2pkh_script(key_hash)
+
+
+class AddressIndexTest(SugarchainTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 1
+        self.extra_args = [["-addressindex"]]
+
+    def spend(self, utxo, outputs):
+        """Spend an output of MINER_ADDRESS to (script, amount) outputs, with the rest back to MINER_ADDRESS"""
+        tx = CTransaction()
+        tx.vin = [CTxIn(COutPoint(int(utxo["txid"], 16), utxo["outputIndex"]), CScript([bytes(REDEEM_SCRIPT)]))]
+        tx.vout = [CTxOut(amount, script) for script, amount in outputs]
+        tx.vout.append(CTxOut(utxo["satoshis"] - sum(amount for _, amount in outputs) - FEE, MINER_SCRIPT))
+        return tx.serialize().hex()
+
+    def miner_utxos(self):
+        """The mature outputs of MINER_ADDRESS, oldest first"""
+        node = self.nodes[0]
+        height = node.getblockcount()
+        utxos = node.getaddressutxos({"addresses": [MINER_ADDRESS]})
+        return [u for u in utxos if height - u["height"] >= 100]
+
+    def mine_spends(self, outputs):
+        """Mine a block with one transaction paying to outputs, and return its height"""
+        node = self.nodes[0]
+        raw = self.spend(self.miner_utxos()[0], outputs)
+        self.generateblock(node, output=MINER_ADDRESS, transactions=[raw])
+        return node.getblockcount()
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.generatetoaddress(node, 110, MINER_ADDRESS)
+
+        self.log.info("Pay three outputs to an address in each of five blocks")
+        self.address, script = p2pkh_address(1)
+        self.heights = [self.mine_spends([(script, 10000 + 1000 * i + n) for n in range(3)]) for i in range(5)]
+
+        self.test_utxo_pages()
+        self.test_delta_pages()
+        self.test_txid_pages()
+        self.test_page_arguments()
+        self.test_balances()
+
+    def read_pages(self, method, query, field, limit, full_pages=True):
+        """Read all pages of a query and return the concatenated entries. With
+        full_pages, check that each page but the last has limit entries."""
+        entries = []
+        after = None
+        while True:
+            page_query = dict(query, limit=limit)
+            if after is not None:
+                page_query["after"] = after
+            page = self.nodes[0].__getattr__(method)(page_query)
+            assert len(page[field]) <= limit
+            entries += page[field]
+            if "next" not in page:
+                return entries
+            if full_pages:
+                assert_equal(len(page[field]), limit)
+            after = page["next"]
+
+    def test_utxo_pages(self):
+        self.log.info("Page through getaddressutxos")
+        query = {"addresses": [self.address]}
+        full = self.nodes[0].getaddressutxos(query)
+        assert_equal(len(full), 15)
+        for limit in [1, 4, 15, 16]:
+            pages = self.read_pages("getaddressutxos", query, "utxos", limit)
+            key = lambda u: (u["txid"], u["outputIndex"])
+            assert_equal(sorted(pages, key=key), sorted(full, key=key))
+
+    def test_delta_pages(self):
+        self.log.info("Page through getaddressdeltas, with and without a height range")
+        query = {"addresses": [self.address]}
+        full = self.nodes[0].getaddressdeltas(query)
+        assert_equal(len(full), 15)
+        for limit in [1, 4, 15]:
+            assert_equal(self.read_pages("getaddressdeltas", query, "deltas", limit), full)
+
+        ranged_query = dict(query, start=self.heights[1], end=self.heights[3])
+        ranged = self.nodes[0].getaddressdeltas(ranged_query)
+        assert_equal(len(ranged), 9)
+        assert_equal(ranged, [d for d in full if self.heights[1] <= d["height"] <= self.heights[3]])
+        for limit in [2, 9]:
+            assert_equal(self.read_pages("getaddressdeltas", ranged_query, "deltas", limit), ranged)
+
+    def test_txid_pages(self):
+        self.log.info("Page through getaddresstxids, without repeating a transaction across pages")
+        # The limit counts index entries, three per transaction here
+        query = {"addresses": [self.address]}
+        full = self.nodes[0].getaddresstxids(query)
+        assert_equal(len(full), 5)
+        for limit in [1, 2, 3, 15]:
+            assert_equal(self.read_pages("getaddresstxids", query, "txids", limit, full_pages=False), full)
+
+        ranged_query = dict(query, start=self.heights[1], end=self.heights[3])
+        assert_equal(self.read_pages("getaddresstxids", ranged_query, "txids", 2, full_pages=False), full[1:4])
+
+    def test_page_arguments(self):
+        self.log.info("Check the limit and cursor arguments")
+        node = self.nodes[0]
+        query = {"addresses": [self.address]}
+        after = node.getaddressdeltas(dict(query, limit=1))["next"]
+
+        assert_raises_rpc_error(-8, "Limit is expected to be between 1 and 10000", node.getaddressdeltas, dict(query, limit=0))
+        assert_raises_rpc_error(-8, "Limit is expected to be between 1 and 10000", node.getaddressutxos, dict(query, limit=10001))
+        assert_raises_rpc_error(-8, "A cursor is only valid together with a limit", node.getaddressdeltas, dict(query, after=after))
+        assert_raises_rpc_error(-8, "Cursor must be hexadecimal", node.getaddressdeltas, dict(query, limit=1, after="xy"))
+        assert_raises_rpc_error(-8, "Invalid cursor", node.getaddressdeltas, dict(query, limit=1, after=after + "00"))
+        assert_raises_rpc_error(-8, "Invalid cursor", node.getaddressdeltas, dict(query, limit=1, after=after[:-2]))
+
+        other_address, _ = p2pkh_address(2)
+        assert_raises_rpc_error(-8, "Cursor does not belong to any of the addresses", node.getaddressdeltas, {"addresses": [other_address], "limit": 1, "after": after})
+
+        # This cursor points into the first block, which is outside the range
+        ranged_query = dict(query, start=self.heights[1], end=self.heights[3], limit=1, after=after)
+        assert_raises_rpc_error(-8, "Cursor is outside the start and end heights", node.getaddressdeltas, ranged_query)
+        assert_raises_rpc_error(-8, "Cursor is outside the start and end heights", node.getaddresstxids, ranged_query)
+        # And this one into the last block
+        after_last = node.getaddressdeltas(dict(query, limit=14))["next"]
+        ranged_query = dict(query, start=self.heights[0], end=self.heights[3], limit=1, after=after_last)
+        assert_raises_rpc_error(-8, "Cursor is outside the start and end heights", node.getaddressdeltas, ranged_query)
+
+    def check_balances(self, addresses):
+        """Check the balance records against the history and unspent outputs of the addresses"""
+        node = self.nodes[0]
+        for address in addresses:
+            deltas = node.getaddressdeltas({"addresses": [address]})
+            utxos = node.getaddressutxos({"addresses": [address]})
+            balance = node.getaddressbalance(address)
+            assert_equal(balance["balance"], sum(d["satoshis"] for d in deltas))
+            assert_equal(balance["balance"], sum(u["satoshis"] for u in utxos))
+            assert_equal(balance["received"], sum(d["satoshis"] for d in deltas if d["satoshis"] > 0))
+            assert_equal(balance["txcount"], len({d["txid"] for d in deltas}))
+
+    def kill_node(self):
+        """Kill the node without letting it flush, and start it again"""
+        node = self.nodes[0]
+        node.process.kill()
+        node.process.wait()
+        node.running = False
+        node.process = None
+        node.rpc_connected = False
+        node.rpc = None
+        self.start_node(0)
+
+    def test_balances(self):
+        self.log.info("Balances agree with the address history")
+        node = self.nodes[0]
+        other_address, other_script = p2pkh_address(3)
+        addresses = [MINER_ADDRESS, self.address, other_address]
+        self.check_balances(addresses)
+
+        self.log.info("Balances are rewound and reapplied in a reorg of several blocks")
+        fork_height = self.mine_spends([(other_script, 5000)])
+        self.mine_spends([(other_script, 6000), (other_script, 7000)])
+        fork_block = node.getblockhash(fork_height)
+        balance = node.getaddressbalance(other_address)
+        assert_equal(balance["balance"], 18000)
+        assert_equal(balance["txcount"], 2)
+
+        node.invalidateblock(fork_block)
+        assert_equal(node.getaddressbalance(other_address)["balance"], 0)
+        self.check_balances(addresses)
+        # a longer fork without the payments
+        for _ in range(3):
+            self.generateblock(node, output=MINER_ADDRESS, transactions=[])
+        node.reconsiderblock(fork_block)
+        assert_equal(node.getaddressbalance(other_address)["balance"], 0)
+        self.check_balances(addresses)
+
+        # back to the payments, disconnecting the fork
+        node.invalidateblock(node.getblockhash(fork_height))
+        assert_equal(node.getblockhash(fork_height), fork_block)
+        assert_equal(node.getaddressbalance(other_address), balance)
+        self.check_balances(addresses)
+
+        self.log.info("Balances survive a restart")
+        self.restart_node(0)
+        assert_equal(node.getaddressbalance(other_address), balance)
+        self.check_balances(addresses)
+
+        self.log.info("Balances are consistent after a crash")
+        self.mine_spends([(other_script, 8000)])
+        tip_height = self.mine_spends([(other_script, 9000)])
+        # the chainstate is on disk, the index may or may not have committed
+        # the blocks yet, and has to replay them in that case
+        node.gettxoutsetinfo("none")
+        self.kill_node()
+        assert_equal(node.getblockcount(), tip_height)
+        self.wait_until(lambda: node.getindexinfo("addressindex")["addressindex"]["synced"])
+        assert_equal(node.getaddressbalance(other_address)["balance"], 35000)
+        self.check_balances(addresses)
+        self.mine_spends([(other_script, 10000)])
+        self.check_balances(addresses)
+
+
+if __name__ == '__main__':
+    AddressIndexTest().main()
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+# Copyright (c) 2014-2022 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test getspentinfo with -spentindex.
+
+Check single and batched lookups of outputs spent in blocks and in the
+mempool, and that both forms agree across a reorg. Check that the index
+rewinds disconnected blocks before it answers a query.
+"""
+
+from test_framework.address import byte_to_base58
+from test_framework.messages import (
+    COutPoint,
+    CTransaction,
+    CTxIn,
+    CTxOut,
+)
+from test_framework.script import (
+    CScript,
+    OP_TRUE,
+    hash160,
+)
+from test_framework.script_util import script_to_p2sh_script
+from test_framework.test_framework import SugarchainTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_raises_rpc_error,
+)
+
+# Anyone can spend outputs to this P2SH address on Sugarchain regtest
+REDEEM_SCRIPT = CScript([OP_TRUE])
+MINER_SCRIPT = script_to_p2sh_script(REDEEM_SCRIPT)
+MINER_ADDRESS = byte_to_base58(hash160(REDEEM_SCRIPT), 123)
+
+FEE = 1000
+
+
+class SpentIndexTest(SugarchainTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+        self.extra_args = [["-spentindex", "-addressindex"], []]
+
+    def spend(self, txid, vout, value, num_outputs=1, node=None):
+        """Send a transaction spending an output of MINER_ADDRESS to num_outputs outputs of it"""
+        tx = CTransaction()
+        tx.vin = [CTxIn(COutPoint(int(txid, 16), vout), CScript([bytes(REDEEM_SCRIPT)]))]
+        tx.vout = [CTxOut((value - FEE) // num_outputs, MINER_SCRIPT) for _ in range(num_outputs)]
+        node = node or self.nodes[0]
+        return node.sendrawtransaction(tx.serialize().hex()), (value - FEE) // num_outputs
+
+    def assert_index_at_tip(self):
+        node = self.nodes[0]
+        assert_equal(node.getindexinfo("spentindex")["spentindex"]["best_block_height"], node.getblockcount())
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.generatetoaddress(node, 110, MINER_ADDRESS)
+        coinbases = sorted(node.getaddressutxos({"addresses": [MINER_ADDRESS]}), key=lambda u: u["height"])[:3]
+        outpoint = lambda txid, index: {"txid": txid, "index": index}
+
+        assert_raises_rpc_error(-1, "Spent index is not enabled", self.nodes[1].getspentinfo, outpoint(coinbases[0]["txid"], 0))
+
+        self.log.info("Spend a coinbase output in a block, and one of the new outputs in the mempool")
+        cb = coinbases[0]
+        txid1, value1 = self.spend(cb["txid"], cb["outputIndex"], cb["satoshis"], num_outputs=2)
+        self.generatetoaddress(node, 1, MINER_ADDRESS)
+        height1 = node.getblockcount()
+        txid2, _ = self.spend(txid1, 0, value1)
+
+        confirmed = outpoint(cb["txid"], cb["outputIndex"])
+        in_mempool = outpoint(txid1, 0)
+        unspent = outpoint(txid1, 1)
+        unknown = outpoint("00" * 32, 5)
+        assert_equal(node.getspentinfo(confirmed), {"txid": txid1, "index": 0, "height": height1})
+        assert_equal(node.getspentinfo(in_mempool), {"txid": txid2, "index": 0, "height": -1})
+        assert_raises_rpc_error(-5, "Unable to get spent info", node.getspentinfo, unspent)
+        assert_raises_rpc_error(-5, "Unable to get spent info", node.getspentinfo, unknown)
+
+        self.log.info("Look up confirmed, mempool and unspent outputs at once")
+        outputs = [confirmed, in_mempool, unspent, unknown, outpoint(coinbases[1]["txid"], 0), confirmed]
+        expected = [node.getspentinfo(confirmed), node.getspentinfo(in_mempool), None, None, None, node.getspentinfo(confirmed)]
+        assert_equal(node.getspentinfo(outputs), expected)
+        assert_equal(node.getspentinfo([]), [])
+        assert_equal(node.getspentinfo([in_mempool]), [expected[1]])
+
+        self.log.info("A mined mempool spend gets its height, and loses it again in a reorg")
+        self.generatetoaddress(node, 1, MINER_ADDRESS)
+        height2 = node.getblockcount()
+        expected[1] = {"txid": txid2, "index": 0, "height": height2}
+        assert_equal(node.getspentinfo(outputs), expected)
+        assert_equal(node.getspentinfo(in_mempool), expected[1])
+
+        # the index rewinds as the blocks are disconnected, before the
+        # queries right after return
+        block2 = node.getbestblockhash()
+        node.invalidateblock(block2)
+        assert_equal(node.getrawmempool(), [txid2])
+        expected[1]["height"] = -1
+        assert_equal(node.getspentinfo(outputs), expected)
+        self.assert_index_at_tip()
+        assert_equal(node.getspentinfo(in_mempool), expected[1])
+
+        block1 = node.getbestblockhash()
+        node.invalidateblock(block1)
+        assert_equal(sorted(node.getrawmempool()), sorted([txid1, txid2]))
+        expected[0]["height"] = -1
+        expected[5]["height"] = -1
+        assert_equal(node.getspentinfo(confirmed), expected[0])
+        self.assert_index_at_tip()
+        assert_equal(node.getspentinfo(outputs), expected)
+
+        self.log.info("A reorg to a longer chain of another node rewinds the blocks that left the active chain")
+        node.reconsiderblock(block1)
+        assert_equal(node.getbestblockhash(), block2)
+        self.disconnect_nodes(0, 1)
+        # node 0 mines a spend, and a spend of its output
+        cb = coinbases[1]
+        txid_a, value_a = self.spend(cb["txid"], cb["outputIndex"], cb["satoshis"])
+        self.spend(txid_a, 0, value_a)
+        self.generatetoaddress(node, 1, MINER_ADDRESS, sync_fun=self.no_op)
+        assert_equal(node.getspentinfo(outpoint(txid_a, 0))["height"], node.getblockcount())
+        # node 1 mines a longer chain with a conflicting spend, so neither
+        # transaction of node 0 returns to its mempool
+        txid_b, _ = self.spend(cb["txid"], cb["outputIndex"], cb["satoshis"], num_outputs=2, node=self.nodes[1])
+        self.generatetoaddress(self.nodes[1], 2, MINER_ADDRESS, sync_fun=self.no_op)
+        height_b = self.nodes[1].getblockcount() - 1
+        self.connect_nodes(0, 1)
+        self.sync_blocks()
+        assert_equal(node.getrawmempool(), [])
+        assert_raises_rpc_error(-5, "Unable to get spent info", node.getspentinfo, outpoint(txid_a, 0))
+        self.assert_index_at_tip()
+        spent_b = {"txid": txid_b, "index": 0, "height": height_b}
+        assert_equal(node.getspentinfo(outpoint(cb["txid"], cb["outputIndex"])), spent_b)
+        assert_equal(node.getspentinfo([outpoint(txid_a, 0), outpoint(cb["txid"], cb["outputIndex"])]), [None, spent_b])
+
+        self.log.info("Check the arguments")
+        assert_raises_rpc_error(-8, "Expected an object with txid and index", node.getspentinfo, [confirmed, 1])
+        assert_raises_rpc_error(-5, "Invalid txid or index", node.getspentinfo, [{"txid": 1, "index": 0}])
+        assert_raises_rpc_error(-8, "At most 10000 outputs can be looked up at once", node.getspentinfo, [unknown] * 10001)
+        assert_equal(node.getspentinfo([unknown] * 10000), [None] * 10000)
+
+
+if __name__ == '__main__':
+    SpentIndexTest().main()
@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+# Copyright (c) 2014-2022 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test getblockhashes with -timestampindex.
+
+Check the time range queries, the blocks that left the active chain, and
+that the database of the old timestamp index is removed at startup.
+"""
+
+import os
+
+from test_framework.test_framework import SugarchainTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_raises_rpc_error,
+)
+
+# An anyone-can-spend P2SH address on Sugarchain regtest
+MINER_ADDRESS = "rqTMJDfpq2kCv6VQbPDqP1opgLBeMRrasV"
+
+START_TIME = 1700000000
+SPACING = 10
+
+
+class TimestampIndexTest(SugarchainTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+        self.extra_args = [["-timestampindex"], []]
+
+    def mine_at(self, node, times):
+        """Mine one block at each of times and return their hashes"""
+        hashes = []
+        for t in times:
+            node.setmocktime(t)
+            hashes += self.generatetoaddress(node, 1, MINER_ADDRESS, sync_fun=self.no_op)
+        return hashes
+
+    def run_test(self):
+        node = self.nodes[0]
+        assert_raises_rpc_error(-1, "Timestamp index is not enabled", self.nodes[1].getblockhashes, START_TIME + 100, START_TIME)
+
+        self.log.info("Mine ten blocks, ten seconds apart")
+        times = [START_TIME + SPACING * i for i in range(10)]
+        hashes = self.mine_at(node, times)
+        for h, t in zip(hashes, times):
+            assert_equal(node.getblockheader(h)["time"], t)
+
+        self.log.info("Query time ranges")
+        # low is included, high is not
+        assert_equal(node.getblockhashes(times[5], times[2]), hashes[2:5])
+        assert_equal(node.getblockhashes(times[5] + 1, times[2] - 1), hashes[2:6])
+        assert_equal(node.getblockhashes(times[9] + 1, times[0]), hashes)
+        assert_equal(node.getblockhashes(times[9] + 1, 0), [node.getblockhash(0)] + hashes)
+        assert_equal(node.getblockhashes(times[9] + 1000, times[9] + 1), [])
+        assert_equal(node.getblockhashes(times[2], times[2]), [])
+        assert_equal(node.getblockhashes(times[2], times[5]), [])
+        assert_equal(node.getblockhashes(times[4], times[2], {"logicalTimes": True}), [
+            {"blockhash": hashes[i], "logicalts": times[i], "height": node.getblockheader(hashes[i])["height"]} for i in [2, 3]
+        ])
+
+        self.log.info("Blocks that left the active chain are listed unless noOrphans is set")
+        node.invalidateblock(hashes[7])
+        fork_times = [times[6] + 5 + SPACING * i for i in range(4)]
+        fork_hashes = self.mine_at(node, fork_times)
+        query = (times[9] + SPACING * 10, times[6])
+        active = [hashes[6], fork_hashes[0], fork_hashes[1], fork_hashes[2], fork_hashes[3]]
+        assert_equal(node.getblockhashes(*query, {"noOrphans": True}), active)
+        all_blocks = [hashes[6], fork_hashes[0], hashes[7], fork_hashes[1], hashes[8], fork_hashes[2], hashes[9], fork_hashes[3]]
+        assert_equal(node.getblockhashes(*query), all_blocks)
+
+        self.log.info("Blocks that were reconnected are listed once")
+        node.reconsiderblock(hashes[7])
+        node.invalidateblock(fork_hashes[0])
+        assert_equal(node.getbestblockhash(), hashes[9])
+        assert_equal(node.getblockhashes(*query), all_blocks)
+        assert_equal(node.getblockhashes(*query, {"noOrphans": True}), hashes[6:10])
+
+        self.log.info("Stale blocks are found again after a restart")
+        legacy_db = os.path.join(node.chain_path, "indexes", "timestampindex")
+        os.makedirs(legacy_db)
+        with open(os.path.join(legacy_db, "CURRENT"), "w", encoding="utf8") as f:
+            f.write("MANIFEST-000001\n")
+        self.restart_node(0)
+        assert_equal(node.getblockhashes(*query), all_blocks)
+        assert_equal(node.getblockhashes(*query, {"noOrphans": True}), hashes[6:10])
+
+        self.log.info("The database of the old timestamp index was removed")
+        assert not os.path.exists(legacy_db)
+
+
+if __name__ == '__main__':
+    TimestampIndexTest().main()
@@ -6,16 +6,30 @@
 
 from decimal import Decimal
 from enum import Enum
+from io import BytesIO
 import http.client
 import json
 import typing
 import urllib.parse
 
 
+from test_framework.address import byte_to_base58
 from test_framework.messages import (
     BLOCK_HEADER_SIZE,
     COIN,
+    COutPoint,
+    CTransaction,
+    CTxIn,
+    CTxOut,
+    deser_compact_size,
+    deser_string,
 )
+from test_framework.script import (
+    CScript,
+    OP_TRUE,
+    hash160,
+)
+from test_framework.script_util import script_to_p2sh_script
 from test_framework.test_framework import SugarchainTestFramework
 from test_framework.util import (
     assert_equal,
@@ -33,6 +47,13 @@ UNKNOWN_PARAM = (
     "0000000000000000000000000000000000000000000000000000000000000000"
 )
 
+# Anyone can spend outputs to this P2SH address on regtest
+REDEEM_SCRIPT = CScript([OP_TRUE])
+INDEX_SCRIPT = script_to_p2sh_script(REDEEM_SCRIPT)
+INDEX_ADDRESS = byte_to_base58(hash160(REDEEM_SCRIPT), 123)
+# Index entries the node sends in one chunk of an address stream
+MAX_REST_ADDRESS_CHUNK = 1000
+
 
 class ReqType(Enum):
     JSON = 1
@@ -55,7 +76,7 @@ def filter_output_indices_by_value(vouts, value):
 class RESTTest(SugarchainTestFramework):
     def set_test_params(self):
         self.num_nodes = 2
-        self.extra_args = [["-rest", "-blockfilterindex=1"], []]
+        self.extra_args = [["-rest", "-blockfilterindex=1", "-addressindex", "-spentindex"], []]
         # whitelist peers to speed up tx relay / mempool sync
         for args in self.extra_args:
             args.append("-whitelist=noban@127.0.0.1")
@@ -719,6 +740,83 @@ class RESTTest(SugarchainTestFramework):
             f"Invalid hash: {INVALID_PARAM}",
         )
 
+        self.test_address_and_spent()
+
+    def read_address_stream(self, uri, record_size=None):
+        """Read a streamed address index reply, and return the record count of each chunk and the records"""
+        stream = BytesIO(self.test_rest_request(uri, req_type=ReqType.BIN, ret_type=RetType.BYTES))
+        counts = []
+        records = []
+        while True:
+            count = deser_compact_size(stream)
+            if count == 0:
+                break
+            counts.append(count)
+            for _ in range(count):
+                if record_size:
+                    records.append(stream.read(record_size))
+                else:
+                    # utxos: fixed fields followed by the script
+                    fixed = stream.read(48)
+                    records.append((fixed, deser_string(stream)))
+        assert_equal(stream.read(), b"")
+        return counts, records
+
+    def test_address_and_spent(self):
+        self.log.info("Test the /address URI")
+        node = self.nodes[0]
+        # More transactions than fit in one chunk
+        self.generatetoaddress(node, MAX_REST_ADDRESS_CHUNK + 1, INDEX_ADDRESS)
+
+        counts, records = self.read_address_stream(f"/address/{INDEX_ADDRESS}/txids", record_size=36)
+        assert_equal(counts, [MAX_REST_ADDRESS_CHUNK, 1])
+        txids = [r[31::-1].hex() for r in records]
+        heights = [int.from_bytes(r[32:], "little", signed=True) for r in records]
+        assert_equal(sorted(txids), sorted(node.getaddresstxids({"addresses": [INDEX_ADDRESS]})))
+        assert_equal(heights, sorted(heights))
+
+        # a height range
+        start = node.getblockcount() - 9
+        counts, _ = self.read_address_stream(f"/address/{INDEX_ADDRESS}/txids?start={start}&end={start + 4}", record_size=36)
+        assert_equal(counts, [5])
+
+        self.log.info("Test the /address URI for utxos and the balance")
+        _, records = self.read_address_stream(f"/address/{INDEX_ADDRESS}/utxos")
+        utxos = node.getaddressutxos({"addresses": [INDEX_ADDRESS]})
+        assert_equal(len(records), len(utxos))
+        rest_utxos = {(fixed[31::-1].hex(), int.from_bytes(fixed[32:36], "little")): (int.from_bytes(fixed[36:40], "little"), int.from_bytes(fixed[40:48], "little"), script) for fixed, script in records}
+        for utxo in utxos:
+            assert_equal(rest_utxos[(utxo["txid"], utxo["outputIndex"])], (utxo["height"], utxo["satoshis"], bytes.fromhex(utxo["script"])))
+
+        balance = bytes.fromhex(self.test_rest_request(f"/address/{INDEX_ADDRESS}/balance", req_type=ReqType.HEX, ret_type=RetType.BYTES).decode().strip())
+        assert_equal(len(balance), 32)
+        fields = [int.from_bytes(balance[i:i + 8], "little", signed=True) for i in range(0, 32, 8)]
+        rpc_balance = node.getaddressbalance(INDEX_ADDRESS)
+        assert_equal(fields, [rpc_balance["balance"], rpc_balance["balance_immature"], rpc_balance["received"], rpc_balance["txcount"]])
+
+        resp = self.test_rest_request(f"/address/{INVALID_PARAM}/txids", req_type=ReqType.BIN, ret_type=RetType.OBJ, status=400)
+        assert_equal(resp.read().decode("utf-8").rstrip(), f"Invalid address: {INVALID_PARAM}")
+
+        self.log.info("Test the /spent URI")
+        coinbase = next(u for u in utxos if u["height"] <= node.getblockcount() - 100)
+        tx = CTransaction()
+        tx.vin = [CTxIn(COutPoint(int(coinbase["txid"], 16), coinbase["outputIndex"]), CScript([bytes(REDEEM_SCRIPT)]))]
+        tx.vout = [CTxOut(coinbase["satoshis"] - 1000, INDEX_SCRIPT)]
+        spending_txid = node.sendrawtransaction(tx.serialize().hex())
+        spent_uri = f"/spent/{coinbase['txid']}/{coinbase['outputIndex']}"
+        for height in [-1, node.getblockcount() + 1]:
+            if height > 0:
+                self.generate(node, 1)
+            record = self.test_rest_request(spent_uri, req_type=ReqType.BIN, ret_type=RetType.BYTES)
+            assert_equal(record[31::-1].hex(), spending_txid)
+            assert_equal(int.from_bytes(record[32:36], "little"), 0)
+            assert_equal(int.from_bytes(record[36:40], "little", signed=True), height)
+            assert_equal(int.from_bytes(record[40:48], "little"), coinbase["satoshis"])
+            # a P2SH address
+            assert_equal(record[48:], bytes([2]) + hash160(REDEEM_SCRIPT))
+
+        self.test_rest_request(f"/spent/{spending_txid}/0", req_type=ReqType.BIN, ret_type=RetType.OBJ, status=404)
+
 
 if __name__ == "__main__":
     RESTTest().main()
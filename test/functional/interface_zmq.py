@@ -3,6 +3,7 @@
 # Distributed under the MIT software license, see the accompanying
 # file COPYING or http://www.opensource.org/licenses/mit-license.php.
 """Test the ZMQ notification interface."""
+from io import BytesIO
 import struct
 from time import sleep
 
@@ -17,6 +18,7 @@ from test_framework.blocktools import (
 )
 from test_framework.test_framework import SugarchainTestFramework
 from test_framework.messages import (
+    deser_compact_size,
     hash256,
     tx_from_hex,
 )
@@ -27,6 +29,7 @@ from test_framework.util import (
 )
 from test_framework.wallet import (
     MiniWallet,
+    getnewdestination,
 )
 from test_framework.netutil import test_ipv6_local
 
@@ -42,6 +45,25 @@ def hash256_reversed(byte_str):
     return hash256(byte_str)[::-1]
 
 
+# Address types of the address index with a 20 byte hash: P2PKH, P2SH and P2WPKH
+ADDRESS_TYPES_HASH160 = (1, 2, 5)
+ADDRESS_TYPE_WITNESS_V0_KEYHASH = 5
+
+
+def parse_address_deltas(body):
+    """Split an addressdelta body into its hash, label and the changes by address type and hash"""
+    stream = BytesIO(body)
+    hash = stream.read(32).hex()
+    label = chr(stream.read(1)[0])
+    deltas = {}
+    for _ in range(deser_compact_size(stream)):
+        address_type = stream.read(1)[0]
+        address_hash = stream.read(20 if address_type in ADDRESS_TYPES_HASH160 else 32)
+        deltas[(address_type, address_hash)] = struct.unpack("<q", stream.read(8))[0]
+    assert_equal(stream.read(), b"")
+    return hash, label, deltas
+
+
 class ZMQSubscriber:
     def __init__(self, socket, topic):
         self.sequence = None  # no sequence number received yet
@@ -129,6 +151,7 @@ class ZMQTest(SugarchainTestFramework):
             self.test_basic()
             self.test_sequence()
             self.test_mempool_sync()
+            self.test_addressdelta()
             self.test_reorg()
             self.test_multiple_interfaces()
             self.test_ipv6()
@@ -140,7 +163,7 @@ class ZMQTest(SugarchainTestFramework):
     # Restart node with the specified zmq notifications enabled, subscribe to
     # all of them and return the corresponding ZMQSubscriber objects.
     def setup_zmq_test(
-        self, services, *, recv_timeout=60, sync_blocks=True, ipv6=False
+        self, services, *, recv_timeout=60, sync_blocks=True, ipv6=False, extra_args=[]
     ):
         subscribers = []
         for topic, address in services:
@@ -152,7 +175,7 @@ class ZMQTest(SugarchainTestFramework):
         self.restart_node(
             0,
             [f"-zmqpub{topic}={address}" for topic, address in services]
-            + self.extra_args[0],
+            + self.extra_args[0] + extra_args,
         )
 
         for i, sub in enumerate(subscribers):
@@ -664,6 +687,55 @@ class ZMQTest(SugarchainTestFramework):
 
         self.generatetoaddress(self.nodes[0], 1, ADDRESS_BCRT1_UNSPENDABLE)
 
+    def test_addressdelta(self):
+        self.log.info("Testing the addressdelta publisher")
+        node = self.nodes[0]
+        [subscriber] = self.setup_zmq_test(
+            [("addressdelta", f"tcp://127.0.0.1:{self.zmq_port_base}")],
+            extra_args=["-addressindex"],
+        )
+        _, script, address = getnewdestination("bech32")
+        address_key = (ADDRESS_TYPE_WITNESS_V0_KEYHASH, bytes(script[2:]))
+        amount = 100000
+
+        # A transaction added to the mempool publishes its net changes
+        txid, _ = self.wallet.send_to(from_node=node, scriptPubKey=script, amount=amount)
+        hash, label, deltas = parse_address_deltas(subscriber.receive())
+        assert_equal((hash, label), (txid, "A"))
+        assert_equal(deltas[address_key], amount)
+        # the fee of send_to
+        assert_equal(sum(deltas.values()), -1000)
+
+        # and so does the block it is mined in
+        blockhash = self.generatetoaddress(node, 1, ADDRESS_BCRT1_UNSPENDABLE, sync_fun=self.no_op)[0]
+        hash, label, deltas = parse_address_deltas(subscriber.receive())
+        assert_equal((hash, label), (blockhash, "C"))
+        assert_equal(deltas[address_key], amount)
+
+        self.log.info("Testing the addressdelta address filter")
+        assert_equal(node.setzmqaddressfilter([address]), 1)
+        # A transaction and a block that do not change the balance of the
+        # address are not published, so the next message is the payment
+        self.wallet.send_self_transfer(from_node=node)
+        self.generatetoaddress(node, 1, ADDRESS_BCRT1_UNSPENDABLE, sync_fun=self.no_op)
+        txid, _ = self.wallet.send_to(from_node=node, scriptPubKey=script, amount=amount)
+        hash, label, deltas = parse_address_deltas(subscriber.receive())
+        assert_equal((hash, label), (txid, "A"))
+        assert_equal(deltas, {address_key: amount})
+        blockhash = self.generatetoaddress(node, 1, ADDRESS_BCRT1_UNSPENDABLE, sync_fun=self.no_op)[0]
+        hash, label, deltas = parse_address_deltas(subscriber.receive())
+        assert_equal((hash, label), (blockhash, "C"))
+        assert_equal(deltas, {address_key: amount})
+
+        # An empty list publishes all addresses again
+        assert_equal(node.setzmqaddressfilter([]), 0)
+        blockhash = self.generatetoaddress(node, 1, ADDRESS_BCRT1_UNSPENDABLE, sync_fun=self.no_op)[0]
+        hash, label, _ = parse_address_deltas(subscriber.receive())
+        assert_equal((hash, label), (blockhash, "C"))
+
+        assert_raises_rpc_error(-5, "Invalid address or address type not indexed: abc", node.setzmqaddressfilter, ["abc"])
+        self.sync_blocks()
+
     def test_multiple_interfaces(self):
         # Set up two subscribers with different addresses
         # (note that after the reorg test, syncing would fail due to different
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 The Sugarchain Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test that the reply to a pipelined getheaders is dropped after its batch is rejected.
+
+A full headers message makes the node request the next batch before it has
+verified the current one. If the current batch then fails validation, the
+headers that answer the request don't connect; they are dropped without
+penalising the peer, which was only answering our request.
+"""
+
+import time
+
+from test_framework.descriptors import descsum_create
+from test_framework.messages import (
+    CBlockHeader,
+    from_hex,
+    msg_headers,
+)
+from test_framework.p2p import P2PInterface
+from test_framework.test_framework import SugarchainTestFramework
+from test_framework.util import assert_equal
+
+MAX_HEADERS_RESULTS = 2000
+
+
+class HeadersPipeliningTest(SugarchainTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+
+    def setup_network(self):
+        # the nodes stay apart, node1 only builds the headers that are fed to node0
+        self.setup_nodes()
+
+    def run_test(self):
+        node, miner = self.nodes
+        start_height = node.getblockcount()
+
+        self.log.info("Build a chain of headers that are too far in the future for node0")
+        # a header from too far in the future fails validation without the
+        # peer being punished for it
+        future = int(time.time()) + 60 * 60
+        descriptor = descsum_create("raw(51)")
+        while miner.getblockcount() < start_height + MAX_HEADERS_RESULTS + 10:
+            # a second per block keeps the block times close to the mock time
+            miner.setmocktime(future + miner.getblockcount())
+            self.generatetodescriptor(miner, 50, descriptor, sync_fun=self.no_op)
+        headers = [from_hex(CBlockHeader(), miner.getblockheader(miner.getblockhash(height), False))
+                   for height in range(start_height + 1, start_height + MAX_HEADERS_RESULTS + 11)]
+        first_batch, next_batch = headers[:MAX_HEADERS_RESULTS], headers[MAX_HEADERS_RESULTS:]
+
+        peer = node.add_p2p_connection(P2PInterface())
+        pipelined_from = first_batch[-1].rehash()
+
+        def received_pipelined_getheaders():
+            getheaders = peer.last_message.get("getheaders")
+            return getheaders is not None and getheaders.locator.vHave[0] == pipelined_from
+
+        self.log.info("A full batch makes node0 request the next one before it is rejected")
+        with node.assert_debug_log(expected_msgs=["pipelined getheaders", "time-too-new"], unexpected_msgs=["Misbehaving"]):
+            peer.send_and_ping(msg_headers(first_batch))
+            peer.wait_until(received_pipelined_getheaders)
+        assert_equal(node.getblockcount(), start_height)
+        assert all(tip["height"] == start_height for tip in node.getchaintips())
+
+        self.log.info("The reply to the pipelined request is dropped without penalising the peer")
+        with node.assert_debug_log(expected_msgs=["ignoring headers following a rejected batch"], unexpected_msgs=["Misbehaving"]):
+            peer.send_and_ping(msg_headers(next_batch))
+        assert peer.is_connected
+        assert_equal(len(node.getpeerinfo()), 1)
+        assert all(tip["height"] == start_height for tip in node.getchaintips())
+
+
+if __name__ == "__main__":
+    HeadersPipeliningTest().main()
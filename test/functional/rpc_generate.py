@@ -20,6 +20,7 @@ class RPCGenerateTest(SugarchainTestFramework):
         self.test_generatetoaddress()
         self.test_generate()
         self.test_generateblock()
+        self.test_generate_threads()
 
     def test_generatetoaddress(self):
         self.generatetoaddress(
@@ -182,6 +183,34 @@ class RPCGenerateTest(SugarchainTestFramework):
             [],
         )
 
+    def test_generate_threads(self):
+        node = self.nodes[0]
+        address = MiniWallet(node).get_address()
+        tip_time = node.getblockheader(node.getbestblockhash())["time"]
+
+        def grind_blocks():
+            blocks = []
+            for i in range(10):
+                node.setmocktime(tip_time + 1 + i)
+                blocks.append(node.generateblock(output=address, transactions=[], submit=False)["hex"])
+            return blocks
+
+        def nonce(block):
+            return int.from_bytes(bytes.fromhex(block[152:160]), "little")
+
+        self.log.info("Grinding nonces on several threads finds the lowest valid nonce, as the serial search does")
+        self.restart_node(0, extra_args=["-genproclimit=1"])
+        serial_blocks = grind_blocks()
+        self.restart_node(0, extra_args=["-genproclimit=4"])
+        threaded_blocks = grind_blocks()
+        # the same mock time and chain tip give each pair the same header, so
+        # only the nonce search may differ
+        for serial_block, threaded_block in zip(serial_blocks, threaded_blocks):
+            assert_equal(threaded_block[:152], serial_block[:152])
+            assert_equal(nonce(threaded_block), nonce(serial_block))
+        assert_equal(threaded_blocks, serial_blocks)
+        self.restart_node(0)
+
     def test_generate(self):
         message = (
             "generate\n\n"
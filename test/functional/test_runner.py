@@ -100,6 +100,7 @@ BASE_SCRIPTS = [
     "feature_fee_estimation.py",
     "feature_taproot.py",
     "feature_block.py",
+    "p2p_headers_pipelining.py",
     # vv Tests less than 2m vv
     "mining_getblocktemplate_longpoll.py",
     "p2p_segwit.py",
@@ -344,6 +345,9 @@ BASE_SCRIPTS = [
     "feature_anchors.py",
     "mempool_datacarrier.py",
     "feature_coinstatsindex.py",
+    "feature_addressindex.py",
+    "feature_spentindex.py",
+    "feature_timestampindex.py",
     "wallet_orphanedreward.py",
     "wallet_timelock.py",
     "p2p_node_network_limited.py",